@@ -0,0 +1,185 @@
+// Choice of the processors to pin solver threads to
+// Candidate Number: 11066
+//
+// The sweeps are limited by memory bandwidth, so on a machine with more
+// than one socket the threads should be spread over every socket's memory
+// controller, and each thread should stay on the processor whose memory
+// holds its rows. The automatic policies read the topology Linux gives in
+// /sys: they use one processor of every core before any hyperthread
+// siblings, and either fill one socket at a time (compact) or alternate
+// between sockets (scatter).
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "affinity.h"
+
+//Struct describing where one processor sits in the machine
+struct cpuPlace
+{
+    int cpu; // Processor number, as used by sched_setaffinity
+    int package; // Socket holding the processor
+    int core; // Core within the socket
+    int sibling; // Processors of the same core listed before this one
+    int rank; // Cores of the same socket listed before this one's core
+};
+
+// Non zero while sorting for the scatter policy (qsort passes no context)
+static int scatter = 0;
+
+
+//readTopology
+//INPUT: Processor (cpu), name of a file in its topology directory (name)
+//OUT:   Number held in the file (-1 if it could not be read)
+static int readTopology(int cpu, const char *name)
+{
+    char path[128];
+    int value = -1;
+    snprintf(path, sizeof(path),
+            "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+    FILE *file = fopen(path, "r");
+    if(file == NULL)
+        return -1;
+    if(fscanf(file, "%d", &value) != 1)
+        value = -1;
+    fclose(file);
+    return value;
+}
+
+
+//comparePlaces
+//INPUT: Two processors (a, b, struct cpuPlace)
+//OUT:   Order to use them in: whole cores first, then by socket and core
+//       (compact) or by core and socket (scatter)
+static int comparePlaces(const void *a, const void *b)
+{
+    const struct cpuPlace *x = (const struct cpuPlace*)a;
+    const struct cpuPlace *y = (const struct cpuPlace*)b;
+    if(x->sibling != y->sibling)
+        return x->sibling - y->sibling;
+    if(scatter && x->rank != y->rank)
+        return x->rank - y->rank;
+    if(x->package != y->package)
+        return x->package - y->package;
+    if(x->core != y->core)
+        return x->core - y->core;
+    return x->cpu - y->cpu;
+}
+
+
+//placeCpus
+//INPUT: Policy to follow (scatterPolicy, non zero to alternate sockets)
+//       processors to fill (cpus), room in cpus (maxCpus)
+//PROC:  Orders the processors this process may run on by the policy
+//OUT:   Number of processors placed in cpus (0 on failure)
+static int placeCpus(int scatterPolicy, int *cpus, int maxCpus)
+{
+    cpu_set_t allowed;
+    int count = 0;
+    int i = 0;
+    int j = 0;
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return 0;
+    struct cpuPlace *places = malloc(CPU_SETSIZE * sizeof(struct cpuPlace));
+    if(places == NULL)
+        return 0;
+
+    for(i = 0; i < CPU_SETSIZE; i++)
+    {
+        if(!CPU_ISSET(i, &allowed))
+            continue;
+        places[count].cpu = i;
+        places[count].package = readTopology(i, "physical_package_id");
+        places[count].core = readTopology(i, "core_id");
+        places[count].sibling = 0;
+        places[count].rank = 0;
+        //Processors are listed in order, so earlier ones set the counts
+        for(j = 0; j < count; j++)
+        {
+            if(places[j].package != places[count].package)
+                continue;
+            if(places[j].core == places[count].core)
+                places[count].sibling++;
+            else if(places[j].sibling == 0)
+                places[count].rank++;
+        }
+        //A sibling shares its core's position in the socket
+        for(j = 0; j < count && places[count].sibling > 0; j++)
+            if(places[j].package == places[count].package
+                    && places[j].core == places[count].core
+                    && places[j].sibling == 0)
+                places[count].rank = places[j].rank;
+        count++;
+    }
+    scatter = scatterPolicy;
+    qsort(places, count, sizeof(struct cpuPlace), &comparePlaces);
+    if(count > maxCpus)
+        count = maxCpus;
+    for(i = 0; i < count; i++)
+        cpus[i] = places[i].cpu;
+    free(places);
+    return count;
+}
+
+
+//parseCpuList
+//INPUT: List of processors and ranges (list, e.g. "0-3,8,10-11")
+//       processors to fill (cpus), room in cpus (maxCpus)
+//OUT:   Number of processors placed in cpus (0 if the list is invalid)
+static int parseCpuList(const char *list, int *cpus, int maxCpus)
+{
+    int count = 0;
+    const char *next = list;
+    while(*next != '\0')
+    {
+        char *end = NULL;
+        long first = strtol(next, &end, 10);
+        long last = first;
+        if(end == next || first < 0 || first >= CPU_SETSIZE)
+            return 0;
+        if(*end == '-')
+        {
+            next = end + 1;
+            last = strtol(next, &end, 10);
+            if(end == next || last < first || last >= CPU_SETSIZE)
+                return 0;
+        }
+        for(; first <= last && count < maxCpus; first++)
+            cpus[count++] = (int)first;
+        if(*end == ',')
+            end++;
+        else if(*end != '\0')
+            return 0;
+        next = end;
+    }
+    return count;
+}
+
+
+//chooseAffinity
+//INPUT: Processors to use (spec, AFFINITY_COMPACT, AFFINITY_SCATTER or a
+//       list such as "0-7,16-23"), number of threads (threads)
+//       processor for each thread (cpus, room for threads values)
+//PROC:  Gives thread i the i-th processor of the list or policy. Threads
+//       wrap round to the start if there are fewer processors than threads
+//OUT:   0 on success (-1 if spec is invalid or no processor is usable)
+int chooseAffinity(const char *spec, int threads, int *cpus)
+{
+    int count = 0;
+    int i = 0;
+    int *order = malloc(CPU_SETSIZE * sizeof(int));
+    if(order == NULL)
+        return -1;
+    if(strcmp(spec, AFFINITY_COMPACT) == 0)
+        count = placeCpus(0, order, CPU_SETSIZE);
+    else if(strcmp(spec, AFFINITY_SCATTER) == 0)
+        count = placeCpus(1, order, CPU_SETSIZE);
+    else
+        count = parseCpuList(spec, order, CPU_SETSIZE);
+    for(i = 0; i < threads && count > 0; i++)
+        cpus[i] = order[i % count];
+    free(order);
+    return (count > 0) ? 0 : -1;
+}
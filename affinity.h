@@ -0,0 +1,13 @@
+// Choice of the processors to pin solver threads to
+// Candidate Number: 11066
+
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+// Automatic policies, anything else is read as a list such as "0-7,16-23"
+#define AFFINITY_COMPACT "compact" // Fill one socket's cores before the next
+#define AFFINITY_SCATTER "scatter" // Deal threads out across the sockets
+
+int chooseAffinity(const char *spec, int threads, int *cpus);
+
+#endif
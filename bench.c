@@ -0,0 +1,150 @@
+// Benchmark timing, statistics and reports shared by both solvers
+// Candidate Number: 11066
+//
+// Throughput is given in lattice updates: one update works out one
+// interior cell once. Multigrid cycles count the smoothing sweeps on the
+// finest level only. Memory bandwidth is modelled from the traffic each
+// update must cause when the grid does not fit in cache (8 bytes a
+// double): Jacobi reads the source, writes the destination and fetches the
+// destination's lines before writing them; red-black updates pass over
+// the grid once per colour, reading and writing every line each time; a
+// wavefront block streams the grid once for all of its sweeps. Single
+// precision sweeps move half as many bytes (the double precision residual
+// passes of --dtype mixed are not counted).
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bench.h"
+#include "multigrid.h"
+
+
+//wallSeconds
+//OUT: Seconds on a monotonic clock, for timing intervals
+double wallSeconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+
+//compareTimes
+//INPUT: Two times (a, b, doubles)
+//OUT:   Order for qsort, shortest first
+static int compareTimes(const void *a, const void *b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+
+//summariseTimes
+//INPUT: Seconds taken by each trial (times, sorted in place), number of
+//       trials (trials, at least 1), summary to fill in (stats)
+//OUT:   N/A (stats holds the median, 95th percentile, minimum and mean)
+void summariseTimes(double *times, int trials, struct benchStats *stats)
+{
+    int i = 0;
+    int rank = (95 * trials + 99) / 100; // Nearest rank, counted from 1
+    double total = 0;
+    qsort(times, trials, sizeof(double), &compareTimes);
+    for(i = 0; i < trials; i++)
+        total += times[i];
+    stats->trials = trials;
+    stats->median = (trials % 2 == 1) ? times[trials/2]
+            : (times[trials/2 - 1] + times[trials/2]) / 2;
+    stats->p95 = times[rank - 1];
+    stats->min = times[0];
+    stats->mean = total / trials;
+}
+
+
+//updateBytes
+//INPUT: Solver parameters (opts)
+//OUT:   Bytes of memory traffic modelled for each lattice update
+static double updateBytes(const struct options *opts)
+{
+    double scale = (opts->dtype == ELEMENT_DOUBLE) ? 1 : 0.5;
+    switch(opts->method)
+    {
+        case METHOD_JACOBI:
+            return 24 * scale;
+        case METHOD_WAVEFRONT:
+            return 24.0 / opts->blockSweeps;
+        case METHOD_GAUSS_SEIDEL:
+            return 16;
+        default:
+            return 32 * scale;
+    }
+}
+
+
+//fillBenchRecord
+//INPUT: Record holding the iterations and times (record), solver
+//       parameters (opts)
+//OUT:   N/A (the record's throughput and bandwidth are worked out)
+void fillBenchRecord(struct benchRecord *record, const struct options *opts)
+{
+    double updates = (double)(opts->rows - 2) * (opts->cols - 2)
+            * record->iterations;
+    if(opts->method == METHOD_VCYCLE || opts->method == METHOD_FMG)
+        updates *= MG_PRE_SWEEPS + MG_POST_SWEEPS;
+    record->glups = updates / record->stats.median / 1e9;
+    record->bandwidth = updates * updateBytes(opts) / record->stats.median
+            / 1e9;
+}
+
+
+//writeBenchReport
+//INPUT: Result to report (record), solver parameters (opts) naming the
+//       report file and its format
+//PROC:  Appends one CSV row (with a header if the file is new) or one
+//       JSON object on a line of its own
+//OUT:   0 on success (-1 if the file could not be written)
+int writeBenchReport(const struct benchRecord *record,
+        const struct options *opts)
+{
+    FILE *file = fopen(opts->report, "a");
+    if(file == NULL)
+    {
+        printf("Unable to open %s for writing\n", opts->report);
+        return -1;
+    }
+    if(opts->reportFormat == REPORT_JSON)
+        fprintf(file, "{\"solver\": \"%s\", \"method\": \"%s\", "
+                "\"rows\": %d, \"cols\": %d, \"processes\": %d, "
+                "\"threads\": %d, \"trials\": %d, \"warmup\": %d, "
+                "\"iterations\": %d, \"converged\": %s, "
+                "\"median_s\": %.9f, \"p95_s\": %.9f, \"min_s\": %.9f, "
+                "\"mean_s\": %.9f, \"glups\": %.6f, \"model_gbs\": %.6f, "
+                "\"dtype\": \"%s\"}\n",
+                record->solver, methodName(opts->method), opts->rows,
+                opts->cols, record->processes, record->threads,
+                record->stats.trials, opts->warmup, record->iterations,
+                record->converged ? "true" : "false", record->stats.median,
+                record->stats.p95, record->stats.min, record->stats.mean,
+                record->glups, record->bandwidth, elementName(opts->dtype));
+    else
+    {
+        if(ftell(file) == 0)
+            fprintf(file, "solver,method,rows,cols,processes,threads,"
+                    "trials,warmup,iterations,converged,median_s,p95_s,"
+                    "min_s,mean_s,glups,model_gbs,dtype\n");
+        fprintf(file, "%s,%s,%d,%d,%d,%d,%d,%d,%d,%d,%.9f,%.9f,%.9f,%.9f,"
+                "%.6f,%.6f,%s\n", record->solver, methodName(opts->method),
+                opts->rows, opts->cols, record->processes, record->threads,
+                record->stats.trials, opts->warmup, record->iterations,
+                record->converged, record->stats.median, record->stats.p95,
+                record->stats.min, record->stats.mean, record->glups,
+                record->bandwidth, elementName(opts->dtype));
+    }
+    if(fclose(file) != 0)
+    {
+        printf("Unable to write %s\n", opts->report);
+        return -1;
+    }
+    return 0;
+}
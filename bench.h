@@ -0,0 +1,38 @@
+// Benchmark timing, statistics and reports shared by both solvers
+// Candidate Number: 11066
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "options.h"
+
+//Struct summarising the times of repeated trials
+struct benchStats
+{
+    int trials;
+    double median; // Seconds
+    double p95; // Seconds, nearest rank
+    double min; // Seconds
+    double mean; // Seconds
+};
+
+//Struct holding one benchmark result
+struct benchRecord
+{
+    const char *solver; // "shared" or "distributed"
+    int processes; // MPI processes (1 for the shared solver)
+    int threads; // Threads in each process
+    int iterations; // Sweeps or cycles in the last trial
+    int converged; // Non zero if the last trial met the precision
+    struct benchStats stats;
+    double glups; // Giga lattice updates per second at the median time
+    double bandwidth; // Modelled memory traffic in GB/s at the median
+};
+
+double wallSeconds(void);
+void summariseTimes(double *times, int trials, struct benchStats *stats);
+void fillBenchRecord(struct benchRecord *record, const struct options *opts);
+int writeBenchReport(const struct benchRecord *record,
+        const struct options *opts);
+
+#endif
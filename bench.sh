@@ -0,0 +1,152 @@
+#!/bin/sh
+# Benchmark suite for the shared and distributed solvers
+# Candidate Number: 11066
+#
+# Builds both solvers and the compare tool, runs each solver over the grid sizes, thread and process
+# counts and methods below, and writes to $OUT:
+#   strong.csv, weak.csv  one row per run, as written by --report
+#   scaling.csv           each run with its speedup and parallel efficiency
+#   results.json          the same as a JSON array
+# Every run does a fixed number of sweeps (or cycles), so runs are
+# comparable between releases. Efficiency compares GLUP/s per thread with
+# the run using the fewest threads (threads times processes) in its group.
+# Strong scaling keeps the grid size; weak scaling grows it with the
+# number of threads, starting from WEAK_SIZE. ZLIB=1 builds everything
+# with -DRELAX_ZLIB -lz, so solution files can be compressed.
+#
+# Usage: [VARIABLE=value ...] ./bench.sh
+
+SIZES=${SIZES:-"512 1024 2048"}
+THREADS=${THREADS:-"1 2 4"}
+RANKS=${RANKS:-"1 2 4"}
+METHODS=${METHODS:-"jacobi sor wavefront"}
+WEAK_SIZE=${WEAK_SIZE:-1024}
+SWEEPS=${SWEEPS:-200}
+TRIALS=${TRIALS:-5}
+WARMUP=${WARMUP:-1}
+OUT=${OUT:-bench-results}
+MPIRUN=${MPIRUN:-mpirun}
+MPIFLAGS=${MPIFLAGS:-}
+CC=${CC:-gcc}
+MPICC=${MPICC:-mpicc}
+CFLAGS=${CFLAGS:--O2}
+ZLIB=${ZLIB:-0}
+
+set -e
+cd "$(dirname "$0")"
+mkdir -p "$OUT"
+rm -f "$OUT/strong.csv" "$OUT/weak.csv"
+
+ZFLAGS=
+ZLIBS=
+if [ "$ZLIB" = 1 ]; then
+    ZFLAGS=-DRELAX_ZLIB
+    ZLIBS=-lz
+fi
+$CC $CFLAGS $ZFLAGS -o "$OUT/shared" shared.c solver.c tiles.c flags.c \
+        grid.c sweep.c sor.c multigrid.c pool.c wavefront.c affinity.c \
+        options.c bench.c trace.c convergence.c mixed.c checkpoint.c \
+        output.c stencil.c -lpthread -lm $ZLIBS
+$MPICC $CFLAGS $ZFLAGS -o "$OUT/distributed" distributed.c grid.c sweep.c \
+        sor.c multigrid.c pool.c options.c bench.c trace.c \
+        convergence.c mixed.c checkpoint.c output.c stencil.c -lpthread -lm \
+        $ZLIBS
+$CC $CFLAGS $ZFLAGS -o "$OUT/compare" compare.c output.c -lm $ZLIBS
+
+# run REPORT SOLVER PROCESSES THREADS SIZE METHOD
+run()
+{
+    set -- "$@" --precision 1e-300 --max-iterations "$SWEEPS" \
+            --trials "$TRIALS" --warmup "$WARMUP" --format none
+    report=$1 solver=$2 processes=$3 threads=$4 size=$5 method=$6
+    shift 6
+    echo "$solver: $method on ${size}x${size}, $processes x $threads"
+    status=0
+    if [ "$solver" = shared ]; then
+        "$OUT/shared" -s "$size" -t "$threads" -m "$method" \
+                --report "$report" "$@" > /dev/null || status=$?
+    else
+        $MPIRUN $MPIFLAGS -np "$processes" "$OUT/distributed" -s "$size" \
+                -t "$threads" -m "$method" --report "$report" "$@" \
+                > /dev/null || status=$?
+    fi
+    # Every run stops at the sweep limit, which exits with status 2
+    [ "$status" -eq 0 ] || [ "$status" -eq 2 ]
+}
+
+for method in $METHODS; do
+    for size in $SIZES; do
+        for t in $THREADS; do
+            run "$OUT/strong.csv" shared 1 "$t" "$size" "$method"
+        done
+        for r in $RANKS; do
+            run "$OUT/strong.csv" distributed "$r" 1 "$size" "$method"
+        done
+    done
+    # Cells per thread stay the same as the thread count grows
+    for t in $THREADS; do
+        size=$(awk -v n="$WEAK_SIZE" -v p="$t" \
+                'BEGIN { printf "%d", (n-2) * sqrt(p) + 2.5 }')
+        run "$OUT/weak.csv" shared 1 "$t" "$size" "$method"
+    done
+    for r in $RANKS; do
+        size=$(awk -v n="$WEAK_SIZE" -v p="$r" \
+                'BEGIN { printf "%d", (n-2) * sqrt(p) + 2.5 }')
+        run "$OUT/weak.csv" distributed "$r" 1 "$size" "$method"
+    done
+done
+
+# Speedup and efficiency against the first run with the fewest threads of
+# each group: solver, method and size (strong) or solver and method (weak)
+awk -F, -v OFS=, '
+    FNR == 1 {
+        mode = (FILENAME ~ /weak\.csv$/) ? "weak" : "strong"
+        if(NR == 1)
+            print "mode,solver,method,rows,cols,processes,threads," \
+                    "iterations,median_s,p95_s,glups,model_gbs,speedup," \
+                    "efficiency"
+        next
+    }
+    {
+        group = mode "," $1 "," $2
+        if(mode == "strong")
+            group = group "," $3 "," $4
+        par = $5 * $6
+        if(!(group in basePar) || par < basePar[group])
+        {
+            basePar[group] = par
+            baseRate[group] = $15
+        }
+        n++
+        line[n] = mode "," $1 "," $2 "," $3 "," $4 "," $5 "," $6 "," $9 \
+                "," $11 "," $12 "," $15 "," $16
+        lineGroup[n] = group
+        linePar[n] = par
+        lineRate[n] = $15
+    }
+    END {
+        for(i = 1; i <= n; i++)
+        {
+            g = lineGroup[i]
+            speedup = lineRate[i] / baseRate[g]
+            print line[i], sprintf("%.4f", speedup),
+                    sprintf("%.4f", speedup * basePar[g] / linePar[i])
+        }
+    }' "$OUT/strong.csv" "$OUT/weak.csv" > "$OUT/scaling.csv"
+
+awk -F, '
+    NR == 1 { for(i = 1; i <= NF; i++) name[i] = $i; print "["; next }
+    {
+        if(NR > 2)
+            print ","
+        printf "  {"
+        for(i = 1; i <= NF; i++)
+        {
+            value = ($i ~ /^[0-9.eE+-]+$/) ? $i : "\"" $i "\""
+            printf "%s\"%s\": %s", (i > 1) ? ", " : "", name[i], value
+        }
+        printf "}"
+    }
+    END { print ""; print "]" }' "$OUT/scaling.csv" > "$OUT/results.json"
+
+echo "Results in $OUT/scaling.csv and $OUT/results.json"
@@ -0,0 +1,252 @@
+// Snapshots of the matrix and solver state, for restarts and warm starts
+// Candidate Number: 11066
+//
+// A snapshot file is a SNAPSHOT_HEADER byte header followed by the whole
+// matrix as rows of native doubles, so the same file serves either solver
+// at any thread or process count. The shared solver maps the file and
+// copies rows straight into (or out of) the mapping; the MPI solver has
+// every process read or write its own block with MPI-IO. A snapshot is
+// written to FILE.tmp and renamed over FILE once complete, so FILE always
+// holds the latest whole snapshot, even if the job is killed part way.
+//
+// A solve with checkpoints runs as segments of --checkpoint-interval
+// sweeps, with a snapshot after each. Restarting from the snapshot picks
+// up its sweep count and convergence reference; an initial guess only
+// takes its matrix.
+
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "checkpoint.h"
+
+_Static_assert(sizeof(struct snapshotHeader) == SNAPSHOT_HEADER,
+        "snapshot header must be SNAPSHOT_HEADER bytes");
+
+
+//runSegments
+//INPUT: Solver parameters (opts), convergence test carried between
+//       segments (test), sweeps (or cycles) already taken (iterations),
+//       non zero if the matrix already holds a solution to improve (warm),
+//       solver and snapshot writer for the matrix (solve, save, both given
+//       context), where to report whether the precision was met
+//       (converged)
+//PROC:  Without --checkpoint, solves once. Otherwise solves in segments
+//       of opts->checkpointInterval sweeps, writing a snapshot after each
+//       one, the last included. Full multigrid would throw away the
+//       matrix it starts from, so later segments (and warm starts) run
+//       V-cycles instead
+//OUT:   Sweeps (or cycles) taken in total, iterations included (-1 if a
+//       segment could not be solved)
+int runSegments(const struct options *opts, struct convergence *test,
+        int iterations, int warm, segmentFunct solve, snapshotFunct save,
+        void *context, int *converged)
+{
+    struct options segment = *opts;
+    struct snapshotHeader header;
+    int checkpoints = (opts->checkpoint[0] != '\0');
+    *converged = 0;
+    if(warm && segment.method == METHOD_FMG)
+        segment.method = METHOD_VCYCLE;
+    for(;;)
+    {
+        int remaining = (opts->maxIterations == 0) ? 0
+                : opts->maxIterations - iterations;
+        //A limit of 0 would mean no limit, so a restart at the limit stops
+        if(opts->maxIterations != 0 && remaining <= 0)
+            return iterations;
+        segment.maxIterations = remaining;
+        if(checkpoints && (remaining == 0
+                || remaining > opts->checkpointInterval))
+            segment.maxIterations = opts->checkpointInterval;
+        int taken = solve(context, &segment, test, converged);
+        if(taken < 0)
+            return -1;
+        iterations += taken;
+        if(!checkpoints)
+            return iterations;
+        initSnapshotHeader(&header, opts, iterations, test->reference);
+        if(save(context, &header) != 0)
+            printf("Unable to write checkpoint %s, carrying on\n",
+                    opts->checkpoint);
+        if(*converged || !underLimit(iterations, opts->maxIterations))
+            return iterations;
+        if(segment.method == METHOD_FMG)
+            segment.method = METHOD_VCYCLE;
+    }
+}
+
+
+//initSnapshotHeader
+//INPUT: Header to fill in (header), solver parameters (opts), sweeps (or
+//       cycles) taken (iterations), first norm of a relative convergence
+//       test (reference, negative if none)
+//OUT:   N/A (header describes the snapshot)
+void initSnapshotHeader(struct snapshotHeader *header,
+        const struct options *opts, int iterations, double reference)
+{
+    memset(header, 0, sizeof(struct snapshotHeader));
+    memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+    header->rows = opts->rows;
+    header->cols = opts->cols;
+    header->iterations = iterations;
+    header->method = opts->method;
+    header->reference = reference;
+}
+
+
+//checkSnapshotHeader
+//INPUT: Header read from a file (header), solver parameters (opts), name
+//       of the file (fileName)
+//PROC:  Prints why the snapshot cannot be used, if it cannot
+//OUT:   0 if the snapshot holds a matrix of the size being solved (-1
+//       otherwise)
+int checkSnapshotHeader(const struct snapshotHeader *header,
+        const struct options *opts, const char *fileName)
+{
+    if(memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0)
+    {
+        printf("%s is not a snapshot\n", fileName);
+        return -1;
+    }
+    if(header->rows != opts->rows || header->cols != opts->cols)
+    {
+        printf("%s holds a %dx%d matrix, not %dx%d\n", fileName,
+                header->rows, header->cols, opts->rows, opts->cols);
+        return -1;
+    }
+    return 0;
+}
+
+
+//readSnapshotHeader
+//INPUT: Snapshot file (fileName), where to put its header (header)
+//OUT:   0 on success (-1 if the file could not be read)
+int readSnapshotHeader(const char *fileName, struct snapshotHeader *header)
+{
+    FILE *file = fopen(fileName, "rb");
+    if(file == NULL)
+    {
+        printf("Unable to open snapshot %s\n", fileName);
+        return -1;
+    }
+    size_t got = fread(header, sizeof(struct snapshotHeader), 1, file);
+    fclose(file);
+    if(got != 1)
+    {
+        printf("%s is too short to be a snapshot\n", fileName);
+        return -1;
+    }
+    return 0;
+}
+
+
+//writeSnapshotHeader
+//INPUT: Snapshot file whose cells are already written (fileName), header
+//       to write in front of them (header)
+//OUT:   0 on success (-1 if the file could not be written)
+int writeSnapshotHeader(const char *fileName,
+        const struct snapshotHeader *header)
+{
+    FILE *file = fopen(fileName, "r+b");
+    if(file == NULL)
+        return -1;
+    if(fwrite(header, sizeof(struct snapshotHeader), 1, file) != 1)
+    {
+        fclose(file);
+        return -1;
+    }
+    //On disk before the rename makes this the latest snapshot
+    if(fflush(file) != 0 || fsync(fileno(file)) != 0)
+    {
+        fclose(file);
+        return -1;
+    }
+    return (fclose(file) == 0) ? 0 : -1;
+}
+
+
+//mapSnapshot
+//INPUT: Snapshot file (fileName), size of its matrix (rows, cols),
+//       non zero to create (or replace) the file for writing (writable)
+//PROC:  Maps the whole file into memory, sizing a new file first
+//OUT:   Pointer to the first cell, rows*cols doubles in row order after
+//       the header (NULL on failure)
+double *mapSnapshot(const char *fileName, int rows, int cols, int writable)
+{
+    size_t bytes = SNAPSHOT_HEADER + (size_t)rows * cols * sizeof(double);
+    int fd = writable ? open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644)
+            : open(fileName, O_RDONLY);
+    void *map = MAP_FAILED;
+    if(fd < 0)
+        return NULL;
+    if(writable && ftruncate(fd, bytes) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    if(!writable && lseek(fd, 0, SEEK_END) < (off_t)bytes)
+    {
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+            MAP_SHARED, fd, 0);
+    //The mapping keeps the file open
+    close(fd);
+    if(map == MAP_FAILED)
+        return NULL;
+    return (double *)((char *)map + SNAPSHOT_HEADER);
+}
+
+
+//unmapSnapshot
+//INPUT: Cells returned by mapSnapshot (cells), size of the matrix (rows,
+//       cols), header to put in front of them (header, NULL if the file
+//       was mapped for reading)
+//PROC:  Writes the header and the mapping back to the file before
+//       unmapping it
+//OUT:   0 on success (-1 if the file could not be written)
+int unmapSnapshot(double *cells, int rows, int cols,
+        const struct snapshotHeader *header)
+{
+    size_t bytes = SNAPSHOT_HEADER + (size_t)rows * cols * sizeof(double);
+    void *map = (char *)cells - SNAPSHOT_HEADER;
+    int result = 0;
+    if(header != NULL)
+    {
+        memcpy(map, header, sizeof(struct snapshotHeader));
+        if(msync(map, bytes, MS_SYNC) != 0)
+            result = -1;
+    }
+    if(munmap(map, bytes) != 0)
+        result = -1;
+    return result;
+}
+
+
+//snapshotTemp
+//INPUT: Snapshot file (fileName), where to put the name (temp, with room
+//       for OPTIONS_STRING + 4 characters)
+//OUT:   N/A (temp holds the name a new snapshot is written under)
+void snapshotTemp(const char *fileName, char *temp)
+{
+    sprintf(temp, "%s.tmp", fileName);
+}
+
+
+//commitSnapshot
+//INPUT: Complete snapshot (temp), file it replaces (fileName)
+//OUT:   0 on success (-1 if the snapshot could not be renamed)
+int commitSnapshot(const char *temp, const char *fileName)
+{
+    if(rename(temp, fileName) != 0)
+    {
+        printf("Unable to rename %s to %s\n", temp, fileName);
+        return -1;
+    }
+    return 0;
+}
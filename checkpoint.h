@@ -0,0 +1,56 @@
+// Snapshots of the matrix and solver state, for restarts and warm starts
+// Candidate Number: 11066
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+#include "options.h"
+
+// Bytes before the first cell of a snapshot file
+#define SNAPSHOT_HEADER 64
+
+// First bytes of every snapshot file
+#define SNAPSHOT_MAGIC "RELAXSNP"
+
+//Struct at the start of a snapshot file, followed by the whole matrix as
+//rows of native doubles, boundary included
+struct snapshotHeader
+{
+    char magic[8]; // SNAPSHOT_MAGIC, not terminated
+    int rows; // Rows in the matrix, boundary included
+    int cols; // Columns in the matrix, boundary included
+    int iterations; // Sweeps (or cycles) taken to reach this matrix
+    int method; // enum sweepMethod that took them
+    double reference; // First norm of a relative convergence test, or
+                      // negative if none was taken
+    char unused[SNAPSHOT_HEADER - 8 - 4*sizeof(int) - sizeof(double)];
+};
+
+// Solves up to opts->maxIterations sweeps (or cycles), updating test, and
+// returns the number taken (-1 if the solve could not be set up)
+typedef int (*segmentFunct)(void *context, const struct options *opts,
+        struct convergence *test, int *converged);
+
+// Writes a snapshot of the current matrix with the given header, returning
+// 0 on success
+typedef int (*snapshotFunct)(void *context,
+        const struct snapshotHeader *header);
+
+int runSegments(const struct options *opts, struct convergence *test,
+        int iterations, int warm, segmentFunct solve, snapshotFunct save,
+        void *context, int *converged);
+void initSnapshotHeader(struct snapshotHeader *header,
+        const struct options *opts, int iterations, double reference);
+int checkSnapshotHeader(const struct snapshotHeader *header,
+        const struct options *opts, const char *fileName);
+int readSnapshotHeader(const char *fileName, struct snapshotHeader *header);
+int writeSnapshotHeader(const char *fileName,
+        const struct snapshotHeader *header);
+double *mapSnapshot(const char *fileName, int rows, int cols, int writable);
+int unmapSnapshot(double *cells, int rows, int cols,
+        const struct snapshotHeader *header);
+void snapshotTemp(const char *fileName, char *temp);
+int commitSnapshot(const char *temp, const char *fileName);
+
+#endif
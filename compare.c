@@ -0,0 +1,179 @@
+// Reads solution files and compares them with a reference
+// Candidate Number: 11066
+// Build: gcc -O2 -o compare compare.c output.c -lm
+//        (add -DRELAX_ZLIB -lz to read compressed files, see output.h)
+//
+// Given one solution file, prints what its header says about it. Given
+// two, streams both a row at a time and reports the largest difference
+// between their cells, so a run can be checked against a stored
+// reference without either matrix being held whole. Exits as cmp does:
+// 0 if the files match within the tolerance, 1 if they differ and 2 if
+// either cannot be read.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <getopt.h>
+#include "output.h"
+
+// Exit status for files that differ, and for files that cannot be read
+#define COMPARE_DIFFER 1
+#define COMPARE_TROUBLE 2
+
+//Function prototypes
+void printHeader(const char *fileName, const struct solutionHeader *header);
+int compareSolutions(struct solutionReader *file,
+        struct solutionReader *reference, double tolerance);
+
+
+int main(int argc, char **argv)
+{
+    static const struct option longOptions[] =
+    {
+        {"tolerance", required_argument, NULL, 't'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    double tolerance = 0; // Largest difference accepted between cells
+    struct solutionReader *readers[2] = {NULL, NULL};
+    char *end = NULL;
+    int key = 0;
+    int files = 0;
+    int i = 0;
+    while((key = getopt_long(argc, argv, "t:h", longOptions, NULL)) != -1)
+    {
+        if(key == 't')
+        {
+            tolerance = strtod(optarg, &end);
+            if(end == optarg || *end != '\0' || !(tolerance >= 0))
+            {
+                printf("Invalid value for tolerance: %s\n", optarg);
+                return COMPARE_TROUBLE;
+            }
+            continue;
+        }
+        printf("Usage: %s [--tolerance X] FILE [REFERENCE]\n", argv[0]);
+        printf("  -t, --tolerance X  largest difference between cells to "
+                "accept (0)\n");
+        return (key == 'h') ? EXIT_SUCCESS : COMPARE_TROUBLE;
+    }
+    files = argc - optind;
+    if(files < 1 || files > 2)
+    {
+        printf("Usage: %s [--tolerance X] FILE [REFERENCE]\n", argv[0]);
+        return COMPARE_TROUBLE;
+    }
+
+    for(i = 0; i<files; i++)
+    {
+        readers[i] = openSolutionReader(argv[optind + i]);
+        if(readers[i] == NULL)
+        {
+            if(i > 0)
+                closeSolutionReader(readers[0]);
+            return COMPARE_TROUBLE;
+        }
+        printHeader(argv[optind + i], &readers[i]->header);
+    }
+    if(files == 1)
+    {
+        closeSolutionReader(readers[0]);
+        return EXIT_SUCCESS;
+    }
+    int status = compareSolutions(readers[0], readers[1], tolerance);
+    closeSolutionReader(readers[0]);
+    closeSolutionReader(readers[1]);
+    return status;
+}
+
+
+//printHeader
+//INPUT: Name of a solution file (fileName), its header (header)
+//PROC:  Prints the size, sweeps and residual the header gives
+//OUT:   N/A
+void printHeader(const char *fileName, const struct solutionHeader *header)
+{
+    printf("%s: %dx%d doubles, %d iterations (%s), largest residual %g, "
+            "precision %g, %s\n", fileName, header->rows, header->cols,
+            header->iterations,
+            header->converged ? "converged" : "not converged",
+            header->residual, header->precision,
+            header->compressed ? "compressed" : "uncompressed");
+}
+
+
+//compareSolutions
+//INPUT: Solution to check (file), solution to check it against
+//       (reference), largest difference between cells to accept
+//       (tolerance)
+//PROC:  Reads both a row at a time, keeping the largest difference
+//       between cells and where it is. A cell that is not a number only
+//       matches another that is not a number
+//OUT:   0 if every cell is within tolerance, COMPARE_DIFFER if not and
+//       COMPARE_TROUBLE if the files cannot be compared
+int compareSolutions(struct solutionReader *file,
+        struct solutionReader *reference, double tolerance)
+{
+    int rows = file->header.rows;
+    int cols = file->header.cols;
+    int worstRow = 0;
+    int worstCol = 0;
+    double worst = 0;
+    double squares = 0;
+    long differing = 0;
+    int i = 0;
+    int j = 0;
+    if(reference->header.rows != rows || reference->header.cols != cols)
+    {
+        printf("Sizes differ: %dx%d against %dx%d\n", rows, cols,
+                reference->header.rows, reference->header.cols);
+        return COMPARE_DIFFER;
+    }
+    double *row = malloc(2 * (size_t)cols * sizeof(double));
+    if(row == NULL)
+    {
+        printf("Unable to allocate two rows of %d cells\n", cols);
+        return COMPARE_TROUBLE;
+    }
+    double *expected = row + cols;
+
+    for(i = 0; i<rows; i++)
+    {
+        if(readSolutionRow(file, row) != 0
+                || readSolutionRow(reference, expected) != 0)
+        {
+            printf("Unable to read row %d, a file is short or damaged\n", i);
+            free(row);
+            return COMPARE_TROUBLE;
+        }
+        for(j = 0; j<cols; j++)
+        {
+            double difference = fabs(row[j] - expected[j]);
+            if(isnan(row[j]) && isnan(expected[j]))
+                difference = 0;
+            else if(isnan(difference))
+                difference = INFINITY;
+            if(difference != 0)
+                differing++;
+            squares += difference * difference;
+            if(difference > worst)
+            {
+                worst = difference;
+                worstRow = i;
+                worstCol = j;
+            }
+        }
+    }
+    free(row);
+
+    if(differing == 0)
+    {
+        printf("Identical\n");
+        return EXIT_SUCCESS;
+    }
+    printf("%ld of %ld cells differ, largest difference %g at row %d, "
+            "column %d, root mean square %g\n", differing,
+            (long)rows * cols, worst, worstRow, worstCol,
+            sqrt(squares / ((double)rows * cols)));
+    return (worst <= tolerance) ? EXIT_SUCCESS : COMPARE_DIFFER;
+}
@@ -0,0 +1,95 @@
+// Convergence tests: largest change, residual norms and relative tolerance
+// Candidate Number: 11066
+//
+// Residuals are in the same units as a Jacobi update, r = (neighbours)/4 -
+// u, so the largest residual is the change the next Jacobi sweep would
+// make. Each thread works out the norm of its own cells: the largest
+// residual for NORM_LINF, or the sum of squares for NORM_L2, which are
+// reduced with a maximum or a sum and then finished by finishNorm.
+// Residuals cost a pass over the matrix, so they are only worked out when
+// a check is due (see --check-interval).
+
+#include <math.h>
+#include "convergence.h"
+#include "options.h"
+
+// Names accepted by --norm, in the order of enum convergenceNorm
+static const char *normNames[] = {"delta", "linf", "l2"};
+
+
+//initConvergence
+//INPUT: Test to set up (test), solver parameters (opts)
+//OUT:   N/A (test holds the norm, precision and size of the matrix)
+void initConvergence(struct convergence *test, const struct options *opts)
+{
+    test->norm = opts->norm;
+    test->precision = opts->precision;
+    test->relative = opts->relative;
+    test->reference = -1;
+    test->cells = (double)(opts->rows - 2) * (opts->cols - 2);
+}
+
+
+//bandResidual
+//INPUT: Grid (g) with current values around the band, rows (startRow up
+//       to but not including endRow) and columns (startCol up to but not
+//       including endCol) to measure, norm to work towards (norm)
+//OUT:   Largest absolute residual in the band, or for NORM_L2 the sum of
+//       the squared residuals
+double bandResidual(const struct grid *g, int startRow, int endRow,
+        int startCol, int endCol, enum convergenceNorm norm)
+{
+    double result = 0;
+    int a = 0;
+    int b = 0;
+    for(a = startRow; a<endRow; a++)
+    {
+        const double *up = GRID_ROW(g, a-1);
+        const double *mid = GRID_ROW(g, a);
+        const double *down = GRID_ROW(g, a+1);
+        for(b = startCol; b<endCol; b++)
+        {
+            double r = (up[b] + mid[b-1] + down[b] + mid[b+1]) * 0.25
+                    - mid[b];
+            if(norm == NORM_L2)
+                result += r*r;
+            else if(fabs(r) > result)
+                result = fabs(r);
+        }
+    }
+    return result;
+}
+
+
+//finishNorm
+//INPUT: Test (test), band values reduced over every thread (reduced)
+//OUT:   The norm of the whole matrix
+double finishNorm(const struct convergence *test, double reduced)
+{
+    if(test->norm == NORM_L2)
+        return sqrt(reduced / test->cells);
+    return reduced;
+}
+
+
+//hasConverged
+//INPUT: Test (test), norm of the whole matrix at this check (norm)
+//PROC:  Keeps the first norm seen as the reference for a relative test
+//OUT:   Non zero if the norm is within precision
+int hasConverged(struct convergence *test, double norm)
+{
+    if(test->reference < 0)
+        test->reference = norm;
+    if(test->relative)
+        return norm <= test->precision * test->reference;
+    return norm <= test->precision;
+}
+
+
+//normName
+//INPUT: Quantity compared with the precision (norm)
+//OUT:   Name of the norm as given to --norm
+const char *normName(enum convergenceNorm norm)
+{
+    return normNames[norm];
+}
@@ -0,0 +1,37 @@
+// Convergence tests: largest change, residual norms and relative tolerance
+// Candidate Number: 11066
+
+#ifndef CONVERGENCE_H
+#define CONVERGENCE_H
+
+#include "grid.h"
+
+struct options;
+
+// Quantity compared with the precision at each check
+enum convergenceNorm
+{
+    NORM_DELTA, // Largest change made by the last sweep (original)
+    NORM_LINF, // Largest absolute residual
+    NORM_L2 // Root mean square residual
+};
+
+//Struct holding the convergence test. Every thread (and worker) keeps its
+//own copy, which stays identical as they all see the same norms
+struct convergence
+{
+    enum convergenceNorm norm;
+    double precision; // Norm to accept, or its fraction of the first norm
+    int relative; // Non zero to compare with the norm at the first check
+    double reference; // Norm at the first check (negative until then)
+    double cells; // Interior cells of the whole matrix, for NORM_L2
+};
+
+void initConvergence(struct convergence *test, const struct options *opts);
+double bandResidual(const struct grid *g, int startRow, int endRow,
+        int startCol, int endCol, enum convergenceNorm norm);
+double finishNorm(const struct convergence *test, double reduced);
+int hasConverged(struct convergence *test, double norm);
+const char *normName(enum convergenceNorm norm);
+
+#endif
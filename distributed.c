@@ -1,253 +1,2334 @@
-// Matrix relaxation using MPI
-// Candidate Number: 11066
-
-// Included libraries
-#include <mpi.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <math.h>
-#include <time.h>
-
-// Function prototypes
-void allocateSections (int cores, int arrayRows, int* borders);
-double** createMatrix(int borderValue, int arrayRows);
-void printMatrix(int arrayRows, double** myMatrix);
-void calcMatrix(int startPoint, int endPoint, double** myMatrix, int world_size,
-        int world_rank, double precision, int arrayRows);
-
-int main(int argc, char** argv) {
-    // Initialize the MPI environment
-    MPI_Init(NULL, NULL);
-    
-    // Find thread rank
-    int world_rank;
-    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
-    
-    // Find world size
-    int world_size;
-    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
-
-    // Get processor name
-    char processor_name[MPI_MAX_PROCESSOR_NAME];
-    int name_len;
-    MPI_Get_processor_name(processor_name, &name_len);
-
-    // Timing variables
-    time_t begin;
-    time_t end;
-    
-    // ENTER MATRIX PARAMETERS
-    int arrayRows = 500; // Width and height of matrix
-    double precision = 0.001; // Precision of matrix
-  
-    double **myMatrix = createMatrix(12, arrayRows);
-    int *borderArray = malloc((world_size+1) * sizeof(int *));
-    allocateSections(world_size, arrayRows, borderArray);
-    //printf("BORDER ARRAY: %d", borderArray[world_rank]);
-    
-    begin = time(NULL);
-    calcMatrix(borderArray[world_rank], borderArray[world_rank+1], 
-            myMatrix,world_size, world_rank, precision, arrayRows);
-    int j = 0;
-    if(world_rank == 0)
-    {
-        //Recv sections from threads
-        for(j=1;j<world_size;j++){
-            int blockSize = borderArray[j+1] - borderArray[j];
-            //Store recv data in correct section of matrix
-            MPI_Recv(&myMatrix[borderArray[j]][0], blockSize*arrayRows
-                    + (2*(blockSize-1)), MPI_DOUBLE, j, 0, MPI_COMM_WORLD,
-                    MPI_STATUS_IGNORE);
-        }
-        //printMatrix(arrayRows, myMatrix);
-        end = time(NULL);
-        printf("\nCompleted processing array of %dx%d elements with precision "
-                "%f\n",arrayRows, arrayRows, precision);
-        printf("\nComputation took %d seconds", end-begin);
-        printf("\nComputation used %d threads", world_size);
-
-    }
-    MPI_Finalize();
-}
-
-//allocateSections
-//INPUT:   sections (number of sections for array to be divided in)
-//         arrayRows (size of array to be divided)
-//PROC: Take matrix dimensions and return array of row borders for each thread
-//OUTPUT: borders (array of row borders for each thread)
-void allocateSections (int sections, int arrayRows, int* borders)
-{   
-    //Calculate quotient and extra values
-    int quot = arrayRows / sections;
-    int extra = arrayRows % sections;
-    int j = 0;
-    
-    borders[0] = 1;
-    borders[1] = quot;
-    
-    for (j = 1; j < sections; j++)
-    {
-        // Place next border at least quot ahead of current border
-        borders[j+1] = borders[j] + quot;
-        
-        //If remainder values that need to be shared across border distance
-        //still exist
-        if (j < extra) 
-            borders[j+1] ++; //Increment next border value
-    }
-    // Avoid placing border value on boundary
-    if(borders[sections] == arrayRows)
-        borders[sections] --;
-                  
-    //Test code print border ranges
-    //for (j = 0; j < sections+1; j++)
-        //printf("\n\nBORDERS: %d\n", borders[j]);
-}
-
-//createMatrix
-//INPUT: Value to be placed on the boundaries of the matrix (borderValue)
-//       Size of the matrix (arrayRows)
-//PROC:  Creates a dynamically sized array with boundary values (borderValue)
-//OUT:   The created array exists in memory
-double** createMatrix(int borderValue, int arrayRows)
-{
-    int i = 0;
-    int j = 0;
-    double **myMatrix;
-    //Dynamically generate array for values
-    myMatrix = calloc(arrayRows, sizeof(double *));
-    for(i=0; i<arrayRows; i++)
-    {
-        myMatrix[i] = calloc(arrayRows, sizeof(double *));
-    }
-    //Fill outside of array with values
-    for(i=0; i<arrayRows;i++)
-    {
-        for(j=0; j<arrayRows; j++)
-        {
-            if( j==0 || i==0 || j == arrayRows-1 || i == arrayRows-1)
-                myMatrix[i][j] = borderValue;
-        }
-    }
-    return myMatrix;
-}
-
-
-//printMatrix
-// Prints the content of the main matrix
-// INPUT: arrayRows (size of matrix)
-// PROC: Prints the content of the matrix
-// OUT: (N/A)
-void printMatrix(int arrayRows, double** myMatrix)
-{
-    //Function variables
-    int i = 0;
-    int j = 0;
-    
-    //Print preprocessed array
-    for (i = 0; i<arrayRows; i++)
-    {
-        for (j = 0; j<arrayRows; j++)
-        {
-            printf("%f  ", myMatrix[i][j]);
-        }
-        printf("\n");
-    }
-}
-
-// calcMatrix
-// Main function to perform matrix calculation
-// INPUT: start (start row of allocated section) 
-//        end (end row of allocated section)
-//        myMatrix (threads local matrix to calculate values with)
-//        world_size (number of threads in the world)
-//        world_rank (thread rank in the world)
-//        precision (precision / accuracy to work towards)
-//        arrayRows (number of row and columns in the entire matrix)
-// PROC:  Calculates the allocated section of the matrix
-// OUT:   N/A (The processed section of the matrix to be sent to root thread)
-void calcMatrix(int start, int end, double** myMatrix, int world_size, 
-        int world_rank, double precision, int arrayRows)
-{
-    printf("\nThread %d has started and has the following properties \n "
-                "Section: %d\nstartPoint: %d\nendPoint: %d\nprecision: %lf\n"
-                "array total rows: %d\ntotal threads: %d\n\n", world_rank,
-            world_rank, start, end, precision, arrayRows, world_size);
-    
-    int a = 0;
-    int b = 0;
-    int c = 0;
-    int f = 0;
-    int globalPrecisionNotMet; //Sum of all thread precisionNotMet status
-    double *recRow = malloc(arrayRows * sizeof(double *));
-    
-    do{
-        int precisionNotMet = 0; //Individual thread precisionNotMet status
-        globalPrecisionNotMet = 0;
-        for(a = start; a<end-1; a++) //Iterate through all allocated rows
-        {
-            for(b = 1; b<arrayRows-1; b++){ //Iterate through all columns
-                double oldValue = myMatrix[a][b];
-                myMatrix[a][b] = (myMatrix[a-1][b] + myMatrix[a][b-1]
-                            + myMatrix[a+1][b] + myMatrix[a][b+1]) / 4;
-                if((fabs(oldValue - myMatrix[a][b]) > precision))
-                    precisionNotMet = 1;
-            }
-       }
-        // Code for exchange
-
-        // Thread ahead sends computed top row so previous thread can use it 
-        // to calc bottom row 
-        if(world_rank != 0) // Thread 0 computes top section, can't send data up
-            MPI_Ssend(&myMatrix[start][0], arrayRows, MPI_DOUBLE, 
-                    world_rank-1, 0, MPI_COMM_WORLD);
-
-        if(world_rank!= (world_size-1)){ //End thread has no data to recv
-                                         //from below
-            //Recv computed top row from prev thread
-            MPI_Recv(recRow, arrayRows, MPI_DOUBLE, world_rank+1, 0, 
-                    MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            for(c=1; c<arrayRows-1; c++) //Write recv data to local matrix
-                myMatrix[end][c] = recRow[c];
-            }
-        // Calculate final allocated row using received values
-        for(c=1; c<arrayRows-1; c++){
-            double oldValue = myMatrix[a][b];
-            myMatrix[end-1][c] = (myMatrix[end-2][c] + myMatrix[end-1][c-1]
-            + myMatrix[end][c] + myMatrix[end-1][c+1]) / 4;
-            if((fabs(oldValue - myMatrix[a][b]) > precision))
-                precisionNotMet = 1;
-        }
-        // Thread behind sends back computed bottom row so next thread 
-        // can use it to calc top row
-        if(world_rank!= (world_size-1))
-            MPI_Ssend(&myMatrix[end-1][0], arrayRows, MPI_DOUBLE, 
-                    world_rank+1, 0, MPI_COMM_WORLD);
-        if(world_rank!=0){
-            //Recv computed top row from prev thread
-            MPI_Recv(recRow, arrayRows, MPI_DOUBLE, world_rank-1, 0, 
-                    MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            for(c=1; c<arrayRows-1; c++) //Write recv data to local matrix
-                myMatrix[start-1][c] = recRow[c];
-        }
-        //if(precisionNotMet == 0)
-        //    printf("\nPrecision MET on thread %d\n", world_rank);
-        MPI_Barrier(MPI_COMM_WORLD); //Ensure all threads are on same iteration
-        
-        //Sum all precisionNotMet together - store in globalPrecisionNotMet
-        //When globalPrecisionNotMet is 0, all threads have reached precision
-        MPI_Allreduce(&precisionNotMet, &globalPrecisionNotMet, 1, MPI_INT, 
-                MPI_SUM, MPI_COMM_WORLD);
-        
-  }while(globalPrecisionNotMet != 0);
-  printf("\nPRECISION MET ON ALL THREADS\n");
-  
-  //Send computed section back to main thread (thread 0)
-  int blockSize = end - start;
-  MPI_Barrier(MPI_COMM_WORLD); //Ensure all threads have exited while loop
-  if(world_rank != 0) //Thread 0 doesn't need to recv its own data
-      //Offset of (2*(blockSize-1)) added to compensate for pairs of 0's
-      //at the end of each sent row
-    MPI_Ssend(&myMatrix[start][0], blockSize*arrayRows + (2*(blockSize-1)), 
-            MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
-}
+// Matrix relaxation using MPI
+// Candidate Number: 11066
+// Build: mpicc -O2 -o distributed distributed.c grid.c sweep.c sor.c multigrid.c pool.c options.c bench.c trace.c convergence.c mixed.c checkpoint.c output.c stencil.c -lpthread -lm
+//        (add -DRELAX_TRACE for --trace, see trace.h, and -DRELAX_ZLIB -lz
+//        for --format compressed, see output.h)
+
+// Included libraries
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "grid.h"
+#include "sweep.h"
+#include "sor.h"
+#include "multigrid.h"
+#include "pool.h"
+#include "options.h"
+#include "bench.h"
+#include "trace.h"
+#include "convergence.h"
+#include "mixed.h"
+#include "checkpoint.h"
+#include "output.h"
+#include "stencil.h"
+
+// Multigrid levels are gathered onto thread 0 once any thread's band of
+// a level would have fewer rows than this
+#define MG_MIN_BAND_ROWS 2
+
+//Struct describing the block of the matrix updated by this thread. The
+//threads form a 2D process grid, each owning one block of rows and columns.
+//A thread only stores its block (see createLocalMatrix): local row i and
+//column j hold global row i + rowOffset and column j + colOffset
+struct block
+{
+    MPI_Comm comm; // Cartesian communicator over every thread
+    int rank; // This thread's rank in comm, the same as in MPI_COMM_WORLD
+    int dims[2]; // Threads down and across the process grid
+    int coords[2]; // This thread's row and column in the process grid
+    int rows; // Rows in the whole matrix, boundary included
+    int cols; // Columns in the whole matrix, boundary included
+    int *rowBorders; // Global row borders of each process grid row
+    int *colBorders; // Global column borders of each process grid column
+    int rowOffset; // Global row of local row 0
+    int colOffset; // Global column of local column 0
+    int startRow; // First local row updated by this thread
+    int endRow; // One past the last local row updated
+    int startCol; // First local column updated by this thread
+    int endCol; // One past the last local column updated
+    int up, down, left, right; // Neighbouring threads, or MPI_PROC_NULL
+};
+
+// Global index of local row i (or column j) of a block, and back again
+#define GLOBAL_ROW(block, i) ((i) + (block)->rowOffset)
+#define GLOBAL_COL(block, j) ((j) + (block)->colOffset)
+#define LOCAL_ROW(block, i) ((i) - (block)->rowOffset)
+#define LOCAL_COL(block, j) ((j) - (block)->colOffset)
+
+//Struct holding the requests that swap a grid's edge rows and columns
+//with the neighbouring threads, set up once and restarted every sweep
+struct halo
+{
+    // Receives into the rows above and below and the columns either side
+    // of the block, then sends of its first and last rows and columns
+    MPI_Request requests[8];
+    MPI_Datatype column; // One column of the block's rows
+};
+
+//Struct holding what a span update needs besides its row and columns
+struct spanUpdate
+{
+    struct grid *matrix; // Grid read (and updated, for in place updates)
+    struct grid *next; // Grid written by Jacobi updates
+    int colour; // Cells updated by red-black updates
+    double omega; // Over-relaxation factor for red-black updates
+    int parity; // Global row plus column of local cell (0, 0)
+    struct gridf *matrixFloat; // As matrix, for single precision updates
+    struct gridf *nextFloat; // As next, for single precision updates
+    const struct gridf *rhs; // Added to every single precision update,
+                             // NULL for none
+    const struct stencil *stencil; // General update of the block's cells,
+                                   // NULL for the average of the neighbours
+};
+
+// Update of columns from up to but not including to of row a, returning
+// the largest absolute change
+typedef double (*spanFunct)(const struct spanUpdate *update, int a,
+        int from, int to);
+
+// Residual norm of rows startRow up to but not including endRow and
+// columns startCol up to but not including endCol of matrix
+typedef double (*residualFunct)(const struct spanUpdate *update,
+        const struct grid *matrix, int startRow, int endRow, int startCol,
+        int endCol, enum convergenceNorm norm);
+
+//Struct holding a convergence check whose reduction over every thread
+//runs during the following sweep
+struct pendingCheck
+{
+    MPI_Request request;
+    double local; // This thread's value, as passed to MPI_Iallreduce
+    double global; // Every thread's values reduced, once request completes
+};
+
+//Struct shared by the workers running one thread's sweeps. Worker 0 is the
+//thread that called MPI_Init_thread, and the only one making MPI calls
+struct sweepTeam
+{
+    struct block *block;
+    struct pool *pool; // Workers, one band of the block's interior each
+    struct spanUpdate update; // Grids and settings the sweeps start with
+    spanFunct span; // Update the workers apply
+    residualFunct residual; // Residual of that update, for the checks
+    struct halo halos[2]; // Halo of each grid a sweep can write
+    struct convergence test; // Worker 0's copy of the convergence test
+    struct pendingCheck check; // Check reduced while the next sweep runs
+    int done; // Non zero once a check has met the test
+    int checkInterval; // Sweeps between convergence checks
+    int maxIterations; // Sweeps allowed, 0 for no limit
+    double globalDelta; // Largest change made by any thread in the last
+                        // sweep, while omega adapts
+    struct omegaEstimate estimate; // Over-relaxation factor for red-black
+    int iterations; // Sweeps completed
+};
+
+//Struct passed to each worker of a sweepTeam
+struct workerArgs
+{
+    struct sweepTeam *team;
+    int worker;
+};
+
+//Struct passed to solveSegment and saveSnapshot by runSegments
+struct solveContext
+{
+    struct block *block;
+    struct grid *matrix; // This thread's block of the matrix
+    struct pool *pool;
+    const char *checkpoint; // Snapshot file kept up to date
+};
+
+//Struct passed to the multigrid operations of each thread
+struct rankTeam
+{
+    int world_rank;
+    int world_size;
+    int up; // Rank holding the band above (or MPI_PROC_NULL)
+    int down; // Rank holding the band below (or MPI_PROC_NULL)
+    int *counts; // Doubles each rank sends when agglomerating
+    int *displs; // Where each rank's rows start in the agglomerated level
+    struct mgLevel *serial; // Agglomerated levels (thread 0 only)
+    int serialCount;
+};
+
+// Function prototypes
+void allocateSections (int cores, int arrayRows, int* borders);
+struct grid *createMatrix(const struct options *opts);
+void printMatrix(struct grid *myMatrix, FILE *file);
+void chooseDims(int threads, int rows, int cols, int dims[2]);
+void createBlock(struct block *block, int rows, int cols, int world_size,
+        int dims[2]);
+struct grid *createLocalMatrix(const struct block *block,
+        const struct options *opts);
+void gatherBlocks(const struct block *block, struct grid *local,
+        struct grid *matrix);
+struct stencil *createBlockStencil(const struct block *block,
+        const struct grid *local, const struct options *opts);
+void writeBlocks(const struct block *block, struct grid *local,
+        const char *fileName, MPI_Offset header);
+void readBlocks(const struct block *block, struct grid *local,
+        const char *fileName, MPI_Offset header);
+void blockRegion(const struct block *block, int processRow,
+        int processCol, int start[2], int end[2]);
+void streamBlocks(const struct block *block, struct grid *local,
+        struct solutionWriter *writer);
+int writeSolution(const struct block *block, struct grid *local,
+        const struct options *opts, int iterations, int converged);
+void freeBlock(struct block *block);
+int calcMatrix(struct block *block, struct grid *myMatrix,
+        const struct options *opts, struct convergence *test,
+        int *converged);
+int calcMatrixJacobi(struct block *block, struct grid *myMatrix,
+        const struct options *opts, struct pool *pool,
+        struct convergence *test, int *converged);
+int calcMatrixRedBlack(struct block *block, struct grid *myMatrix,
+        const struct options *opts, struct pool *pool,
+        struct convergence *test, int *converged);
+int calcMatrixFloat(struct block *block, struct grid *myMatrix,
+        const struct options *opts, struct pool *pool,
+        struct convergence *test, int *converged);
+void runTeam(struct sweepTeam *team, poolTask task);
+int checkTeam(struct sweepTeam *team, int worker, const struct grid *matrix,
+        double maxDelta, int due, int pending, int last);
+void startCheck(struct pendingCheck *check, const struct convergence *test,
+        double local, MPI_Comm comm);
+int finishCheck(struct pendingCheck *check, struct convergence *test);
+void *jacobiWorker(void *argsStruct);
+void *redBlackWorker(void *argsStruct);
+int calcMatrixMultigrid(struct block *block, struct grid *myMatrix,
+        const struct options *opts, struct convergence *test,
+        int *converged);
+void exchangeRows(struct grid *matrix, int start, int end, int up, int down);
+void initHalo(struct halo *halo, struct grid *matrix,
+        const struct block *block);
+void initHaloFloat(struct halo *halo, struct gridf *matrix,
+        const struct block *block);
+void initHaloRows(struct halo *halo, char *row0, int pitch,
+        MPI_Datatype type, const struct block *block);
+void beginHalo(struct halo *halo);
+void endHalo(struct halo *halo);
+void freeHalo(struct halo *halo);
+double sweepEdge(const struct block *block, spanFunct funct,
+        const struct spanUpdate *update);
+double sweepInterior(const struct block *block, spanFunct funct,
+        const struct spanUpdate *update, int part, int parts);
+double gaussSeidelSpan(const struct spanUpdate *update, int a, int from,
+        int to);
+double jacobiSpan(const struct spanUpdate *update, int a, int from, int to);
+double colourSpan(const struct spanUpdate *update, int a, int from, int to);
+double jacobiSpanStencil(const struct spanUpdate *update, int a, int from,
+        int to);
+double colourSpanStencil(const struct spanUpdate *update, int a, int from,
+        int to);
+double jacobiSpanFloat(const struct spanUpdate *update, int a, int from,
+        int to);
+double colourSpanFloat(const struct spanUpdate *update, int a, int from,
+        int to);
+double spanResidual(const struct spanUpdate *update,
+        const struct grid *matrix, int startRow, int endRow, int startCol,
+        int endCol, enum convergenceNorm norm);
+double spanResidualStencil(const struct spanUpdate *update,
+        const struct grid *matrix, int startRow, int endRow, int startCol,
+        int endCol, enum convergenceNorm norm);
+void rankExchange(void *context, struct mgLevel *level, struct grid *g);
+double rankReduceMax(void *context, double value);
+double rankReduceSum(void *context, double value);
+void rankAgglomerate(void *context, struct mgLevel *levels, int level,
+        enum mgSchedule schedule);
+void serialExchange(void *context, struct mgLevel *level, struct grid *g);
+double serialReduceMax(void *context, double value);
+int solveSegment(void *context, const struct options *opts,
+        struct convergence *test, int *converged);
+int saveSnapshot(void *context, const struct snapshotHeader *header);
+int loadSnapshot(const char *fileName, const struct options *opts,
+        const struct block *block, struct grid *myMatrix,
+        struct snapshotHeader *header);
+
+int main(int argc, char** argv) {
+    // Initialize the MPI environment. Only the main thread of each
+    // process makes MPI calls, the other workers just sweep
+    int provided;
+    MPI_Init_thread(NULL, NULL, MPI_THREAD_FUNNELED, &provided);
+    
+    // Find thread rank
+    int world_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    
+    // Find world size
+    int world_size;
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+
+    // Get processor name
+    char processor_name[MPI_MAX_PROCESSOR_NAME];
+    int name_len;
+    MPI_Get_processor_name(processor_name, &name_len);
+
+    // Default parameters, see --help for the options changing them
+    struct options opts;
+    initOptions(&opts);
+    opts.rows = 500; // Height of matrix
+    opts.cols = 500; // Width of matrix
+    opts.precision = 0.001; // Precision of matrix
+    opts.method = METHOD_SOR; // Update ordering
+    opts.threads = 1; // Threads sharing each process's block (pthreads)
+    opts.borderValue = 12;
+    //Every process reads the same command line; thread 0 reports problems
+    int status = parseOptions(&opts, argc, argv, world_rank == 0);
+    if(status != 0)
+    {
+        MPI_Finalize();
+        return (status == OPTIONS_HELP) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if(opts.batch > 0)
+    {
+        if(world_rank == 0)
+            printf("Batches are only solved by the shared solver\n");
+        MPI_Finalize();
+        return EXIT_FAILURE;
+    }
+    enum sweepMethod method = opts.method;
+    int workers = opts.threads;
+  
+    struct block myBlock;
+    int dims[2] = {opts.dims[0], opts.dims[1]}; // Process grid shape
+    //Multigrid coarsens whole rows at a time, so it keeps to bands of rows
+    if(method == METHOD_VCYCLE || method == METHOD_FMG)
+    {
+        if(dims[1] > 1 && world_rank == 0)
+            printf("Multigrid uses a single column of processes\n");
+        dims[1] = 1;
+    }
+    createBlock(&myBlock, opts.rows, opts.cols, world_size, dims);
+    //Each thread only stores its own block and the cells around it
+    struct grid *myMatrix = createLocalMatrix(&myBlock, &opts);
+    
+    //Gauss-Seidel and multigrid sweep each block on the main thread alone
+    if(method != METHOD_JACOBI && method != METHOD_WAVEFRONT
+            && method != METHOD_RED_BLACK && method != METHOD_SOR)
+        workers = 1;
+    if(workers > 1 && provided < MPI_THREAD_FUNNELED)
+    {
+        if(world_rank == 0)
+            printf("MPI library is not thread safe, using 1 worker\n");
+        workers = 1;
+    }
+    //Workers are started once; the main thread is worker 0
+    struct pool *myPool = createPool(workers, NULL);
+    if(myPool == NULL)
+    {
+        printf("Unable to start %d workers\n", workers);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    
+    const char *isa = initSweepKernels();
+    if(world_rank == 0)
+        printf("Using %s sweep kernels on a %dx%d process grid with %d "
+                "workers each\n", isa, myBlock.dims[0], myBlock.dims[1],
+                workers);
+    
+    //Each trial starts from a fresh block, warmup trials first. A trial
+    //takes as long as its slowest thread
+    struct benchRecord record;
+    struct snapshotHeader snapshot;
+    struct convergence test;
+    struct solveContext context = {&myBlock, myMatrix, myPool,
+            opts.checkpoint};
+    double *times = malloc(opts.trials * sizeof(double));
+    const char *start = (opts.restart[0] != '\0') ? opts.restart
+            : opts.initial; // Snapshot to start from, "" for none
+    int converged = 0;
+    int iterations = 0;
+    int resumed = 0; // Sweeps (or cycles) taken before this run
+    int trial = 0;
+    if(times == NULL)
+    {
+        printf("Unable to allocate times for %d trials\n", opts.trials);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    //Every thread's timeline starts together, and covers every trial
+    TRACE_THREAD(world_rank, 0);
+    MPI_Barrier(myBlock.comm);
+    traceStart();
+    for(trial = -opts.warmup; trial < opts.trials; trial++)
+    {
+        if(trial > -opts.warmup)
+        {
+            freeGrid(myMatrix);
+            myMatrix = createLocalMatrix(&myBlock, &opts);
+            context.matrix = myMatrix;
+        }
+        initConvergence(&test, &opts);
+        if(start[0] != '\0')
+        {
+            if(loadSnapshot(start, &opts, &myBlock, myMatrix, &snapshot)
+                    != 0)
+            {
+                MPI_Finalize();
+                return EXIT_FAILURE;
+            }
+            //A restart carries on the solve the snapshot was taken from
+            if(opts.restart[0] != '\0')
+            {
+                resumed = snapshot.iterations;
+                test.reference = snapshot.reference;
+            }
+            if(trial == -opts.warmup && world_rank == 0)
+                printf("Starting from %s, taken after %d iterations of "
+                        "%s\n", start, snapshot.iterations,
+                        methodName(snapshot.method));
+        }
+        MPI_Barrier(myBlock.comm);
+        double solveStart = TRACE_NOW();
+        double begin = MPI_Wtime();
+        iterations = runSegments(&opts, &test, resumed, start[0] != '\0',
+                &solveSegment, &saveSnapshot, &context, &converged);
+        double elapsed = MPI_Wtime() - begin;
+        TRACE_SPAN("solve", solveStart);
+        double slowest = 0;
+        MPI_Reduce(&elapsed, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0,
+                myBlock.comm);
+        if(trial >= 0)
+            times[trial] = slowest;
+    }
+    if(world_rank == 0)
+    {
+        const char *units = (method == METHOD_VCYCLE || method == METHOD_FMG)
+                ? "multigrid cycles" : "sweeps";
+        if(converged)
+            printf("Converged after %d %s\n", iterations, units);
+        else
+            printf("Stopped after %d %s without converging\n", iterations,
+                    units);
+    }
+    
+    struct grid *wholeMatrix = NULL;
+    double outputStart = TRACE_NOW();
+    if(opts.format == OUTPUT_BINARY || opts.format == OUTPUT_COMPRESSED)
+    {
+        //Edge cells written by this thread show their Neumann conditions
+        finishConditions(myMatrix, &opts, myBlock.rowOffset,
+                myBlock.colOffset);
+        if(writeSolution(&myBlock, myMatrix, &opts, iterations, converged)
+                != 0)
+            status = EXIT_FAILURE;
+    }
+    else if(opts.format == OUTPUT_TEXT)
+    {
+        //Send computed blocks to main thread (thread 0), the only one to
+        //hold the whole matrix
+        if(world_rank == 0)
+            wholeMatrix = createMatrix(&opts);
+        gatherBlocks(&myBlock, myMatrix, wholeMatrix);
+        if(world_rank == 0)
+            finishConditions(wholeMatrix, &opts, 0, 0);
+    }
+    TRACE_SPAN("output", outputStart);
+    
+    //Threads add their timelines to the trace file one after another
+    if(opts.trace[0] != '\0')
+    {
+        int traceStatus = 0;
+        int r = 0;
+        for(r = 0; r < world_size; r++)
+        {
+            if(r == world_rank)
+                traceStatus = traceWrite(opts.trace, r == 0,
+                        r == world_size-1);
+            MPI_Barrier(myBlock.comm);
+        }
+        if(traceStatus != 0)
+            status = EXIT_FAILURE;
+    }
+    if(world_rank == 0)
+    {
+        if(wholeMatrix != NULL)
+        {
+            FILE *file = (opts.outputFile[0] != '\0')
+                    ? fopen(opts.outputFile, "w") : stdout;
+            if(file == NULL)
+                printf("Unable to open %s for writing\n", opts.outputFile);
+            else
+            {
+                printMatrix(wholeMatrix, file);
+                if(file != stdout)
+                    fclose(file);
+            }
+        }
+        record.solver = "distributed";
+        record.processes = world_size;
+        record.threads = workers;
+        record.iterations = iterations - resumed;
+        record.converged = converged;
+        summariseTimes(times, opts.trials, &record.stats);
+        fillBenchRecord(&record, &opts);
+        printf("\nCompleted processing array of %dx%d elements with precision "
+                "%f\n", opts.rows, opts.cols, opts.precision);
+        printf("\nComputation took %.6f seconds", record.stats.median);
+        if(opts.trials > 1)
+            printf(" (median of %d trials, p95 %.6f seconds)", opts.trials,
+                    record.stats.p95);
+        printf("\nComputation used %d threads", world_size);
+        printf("\nThroughput %.3f GLUP/s, modelled bandwidth %.2f GB/s\n",
+                record.glups, record.bandwidth);
+        if(opts.report[0] != '\0' && writeBenchReport(&record, &opts) != 0)
+            status = EXIT_FAILURE;
+    }
+    free(times);
+    freePool(myPool);
+    freeBlock(&myBlock);
+    freeGrid(myMatrix);
+    freeGrid(wholeMatrix);
+    MPI_Finalize();
+    if(status != 0)
+        return EXIT_FAILURE;
+    return converged ? EXIT_SUCCESS : EXIT_NOT_CONVERGED;
+}
+
+//allocateSections
+//INPUT:   sections (number of sections for array to be divided in)
+//         arrayRows (size of array to be divided)
+//PROC: Take matrix dimensions and return array of row borders for each thread
+//OUTPUT: borders (array of row borders for each thread)
+void allocateSections (int sections, int arrayRows, int* borders)
+{   
+    //Calculate quotient and extra values over the interior rows only, the
+    //boundary rows never being updated
+    int quot = (arrayRows-2) / sections;
+    int extra = (arrayRows-2) % sections;
+    int j = 0;
+    
+    borders[0] = 1;
+    
+    for (j = 0; j < sections; j++)
+    {
+        // Place next border quot ahead of current border
+        borders[j+1] = borders[j] + quot;
+        
+        //The first extra sections take one remainder row each, so blocks
+        //differ by at most a row and the last ends at arrayRows-1
+        if (j < extra) 
+            borders[j+1] ++; //Increment next border value
+    }
+                  
+    //Test code print border ranges
+    //for (j = 0; j < sections+1; j++)
+        //printf("\n\nBORDERS: %d\n", borders[j]);
+}
+
+//createMatrix
+//INPUT: Options giving the size and boundary conditions (opts)
+//PROC:  Creates a contiguous zeroed grid with its edges and held cells set
+//       (see applyConditions)
+//OUT:   The created array exists in memory
+struct grid *createMatrix(const struct options *opts)
+{
+    struct grid *myMatrix = createGrid(opts->rows, opts->cols, 0);
+    if(myMatrix == NULL)
+    {
+        printf("Unable to allocate a %dx%d array\n", opts->rows, opts->cols);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    applyConditions(myMatrix, opts, 0, 0);
+    return myMatrix;
+}
+
+
+//printMatrix
+// Prints the content of the main matrix
+// INPUT: myMatrix (matrix to be printed), file (where to print it)
+// PROC: Prints the content of the matrix
+// OUT: (N/A)
+void printMatrix(struct grid *myMatrix, FILE *file)
+{
+    //Function variables
+    int i = 0;
+    int j = 0;
+    
+    //Print preprocessed array
+    for (i = 0; i<myMatrix->rows; i++)
+    {
+        for (j = 0; j<myMatrix->cols; j++)
+        {
+            fprintf(file, "%f  ", GRID_AT(myMatrix, i, j));
+        }
+        fprintf(file, "\n");
+    }
+}
+
+// chooseDims
+// INPUT: threads (threads to arrange in a process grid)
+//        rows, cols (interior rows and columns of the matrix)
+//        dims (threads down and across, any non zero entry is kept)
+// PROC:  Tries every way of factoring threads into dims[0] x dims[1] and
+//        keeps the one with the shortest block edges, so the fewest values
+//        are exchanged each sweep. Ties go to more rows of threads, whose
+//        halos are contiguous rows
+// OUT:   N/A (dims holds the process grid shape)
+void chooseDims(int threads, int rows, int cols, int dims[2])
+{
+    int best = 0;
+    double bestEdge = 0;
+    int p = 0;
+    for(p = 1; p <= threads; p++)
+    {
+        int q = threads / p;
+        double edge = (double)rows / p + (double)cols / q;
+        if(p * q != threads || p > rows || q > cols
+                || (dims[0] != 0 && dims[0] != p)
+                || (dims[1] != 0 && dims[1] != q))
+            continue;
+        if(best == 0 || edge <= bestEdge)
+        {
+            best = p;
+            bestEdge = edge;
+        }
+    }
+    if(best == 0)
+    {
+        printf("Unable to arrange %d threads over a %dx%d matrix\n", threads,
+                rows, cols);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    dims[0] = best;
+    dims[1] = threads / best;
+}
+
+
+// createBlock
+// INPUT: block (to fill in), size of the whole matrix (rows, cols)
+//        world_size (number of threads), dims (process grid shape, 0 to
+//        choose)
+// PROC:  Creates the Cartesian communicator over the process grid and
+//        works out this thread's block and its neighbours. World ranks are
+//        kept, so thread 0 is still the root
+// OUT:   N/A (block and dims are filled in)
+void createBlock(struct block *block, int rows, int cols, int world_size,
+        int dims[2])
+{
+    int periods[2] = {0, 0};
+    int rank = 0;
+    chooseDims(world_size, rows-2, cols-2, dims);
+    block->dims[0] = dims[0];
+    block->dims[1] = dims[1];
+    block->rows = rows;
+    block->cols = cols;
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &block->comm);
+    MPI_Comm_rank(block->comm, &rank);
+    block->rank = rank;
+    MPI_Cart_coords(block->comm, rank, 2, block->coords);
+    MPI_Cart_shift(block->comm, 0, 1, &block->up, &block->down);
+    MPI_Cart_shift(block->comm, 1, 1, &block->left, &block->right);
+    
+    block->rowBorders = malloc((dims[0]+1) * sizeof(int));
+    block->colBorders = malloc((dims[1]+1) * sizeof(int));
+    allocateSections(dims[0], rows, block->rowBorders);
+    allocateSections(dims[1], cols, block->colBorders);
+    
+    //Local rows start at the block's first row, with a ghost row either
+    //side in the grid's halo. Local columns start one before the block's
+    //first column, so the ghost columns are ordinary columns
+    int startRow = block->rowBorders[block->coords[0]];
+    int startCol = block->colBorders[block->coords[1]];
+    block->rowOffset = startRow;
+    block->colOffset = startCol - 1;
+    block->startRow = 0;
+    block->endRow = block->rowBorders[block->coords[0]+1] - startRow;
+    block->startCol = 1;
+    block->endCol = block->colBorders[block->coords[1]+1] - startCol + 1;
+}
+
+
+// createLocalMatrix
+// INPUT: block (this thread's block), opts (boundary conditions)
+// PROC:  Allocates the block with a ghost row and column on every side,
+//        and sets any ghost cells on the edge of the whole matrix, and any
+//        held cells, to their values (see applyConditions). The other
+//        ghost cells are filled by halo exchanges
+// OUT:   This thread's part of the matrix
+struct grid *createLocalMatrix(const struct block *block,
+        const struct options *opts)
+{
+    struct grid *local = createGrid(block->endRow - block->startRow,
+            block->endCol - block->startCol + 2, 1);
+    if(local == NULL)
+    {
+        printf("Unable to allocate a %dx%d block\n",
+                block->endRow - block->startRow,
+                block->endCol - block->startCol);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    applyConditions(local, opts, block->rowOffset, block->colOffset);
+    return local;
+}
+
+
+// createBlockStencil
+// INPUT: block (this thread's block), local (its part of the matrix), opts
+//        (boundary conditions)
+// PROC:  Works out the general update of the block's cells, if the
+//        conditions need one (see needsStencil)
+// OUT:   The block's stencil (NULL when the plain average applies)
+struct stencil *createBlockStencil(const struct block *block,
+        const struct grid *local, const struct options *opts)
+{
+    struct stencil *stencil = NULL;
+    if(!needsStencil(opts))
+        return NULL;
+    stencil = createStencil(local, opts, block->rowOffset, block->colOffset);
+    if(stencil == NULL)
+    {
+        printf("Unable to allocate the stencil of a %dx%d block\n",
+                local->rows, local->cols);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    return stencil;
+}
+
+
+// gatherBlocks
+// INPUT: block (this thread's block), local (this thread's processed
+//        block), matrix (whole matrix on thread 0, NULL elsewhere)
+// PROC:  Packs each thread's block into consecutive values and collects
+//        them on thread 0 with one MPI_Gatherv. Each block is placed in
+//        the receive buffer after the blocks of the lower ranks, then
+//        thread 0 copies it into place in the matrix
+// OUT:   N/A (thread 0's matrix holds every block)
+void gatherBlocks(const struct block *block, struct grid *local,
+        struct grid *matrix)
+{
+    int rank = 0;
+    int size = 0;
+    int i = 0;
+    int j = 0;
+    int coords[2];
+    int width = block->endCol - block->startCol;
+    int height = block->endRow - block->startRow;
+    int *counts = NULL;
+    int *displs = NULL;
+    double *all = NULL;
+    double *packed = malloc((size_t)width * height * sizeof(double));
+    MPI_Comm_rank(block->comm, &rank);
+    MPI_Comm_size(block->comm, &size);
+    if(packed == NULL)
+    {
+        printf("Unable to allocate a %dx%d block to gather\n", height, width);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    for(i = 0; i<height; i++)
+        memcpy(packed + (size_t)i * width,
+                GRID_ROW(local, block->startRow + i) + block->startCol,
+                width * sizeof(double));
+    
+    if(rank == 0)
+    {
+        //Thread 0 briefly holds the interior twice, packed and in place
+        counts = malloc(size * sizeof(int));
+        displs = malloc(size * sizeof(int));
+        all = malloc((size_t)(block->rows-2) * (block->cols-2)
+                * sizeof(double));
+        if(counts == NULL || displs == NULL || all == NULL)
+        {
+            printf("Unable to allocate space to gather the matrix\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        for(j = 0; j<size; j++)
+        {
+            MPI_Cart_coords(block->comm, j, 2, coords);
+            counts[j] = (block->rowBorders[coords[0]+1]
+                    - block->rowBorders[coords[0]])
+                    * (block->colBorders[coords[1]+1]
+                    - block->colBorders[coords[1]]);
+            displs[j] = (j == 0) ? 0 : displs[j-1] + counts[j-1];
+        }
+    }
+    MPI_Gatherv(packed, width * height, MPI_DOUBLE, all, counts, displs,
+            MPI_DOUBLE, 0, block->comm);
+    free(packed);
+    if(rank != 0)
+        return;
+    
+    for(j = 0; j<size; j++)
+    {
+        MPI_Cart_coords(block->comm, j, 2, coords);
+        int startRow = block->rowBorders[coords[0]];
+        int startCol = block->colBorders[coords[1]];
+        int blockWidth = block->colBorders[coords[1]+1] - startCol;
+        int blockHeight = block->rowBorders[coords[0]+1] - startRow;
+        for(i = 0; i<blockHeight; i++)
+            memcpy(GRID_ROW(matrix, startRow + i) + startCol,
+                    all + displs[j] + (size_t)i * blockWidth,
+                    blockWidth * sizeof(double));
+    }
+    free(all);
+    free(counts);
+    free(displs);
+}
+
+
+// writeBlocks
+// INPUT: block (this thread's block), local (this thread's processed
+//        block), fileName (file to write the whole matrix to), header
+//        (bytes left before the matrix for a header, 0 for none)
+// PROC:  Every thread writes its own block straight into one shared file
+//        with a collective MPI-IO write, so no thread holds more than its
+//        block. Threads on the edge of the process grid also write the
+//        boundary cells next to their block. The file holds the whole
+//        matrix as rows of native doubles, boundary included
+// OUT:   N/A (the matrix is in fileName)
+void writeBlocks(const struct block *block, struct grid *local,
+        const char *fileName, MPI_Offset header)
+{
+    int sizes[2] = {block->rows, block->cols};
+    int subsizes[2];
+    int starts[2];
+    int firstRow = block->startRow;
+    int lastRow = block->endRow;
+    int firstCol = block->startCol;
+    int lastCol = block->endCol;
+    MPI_Datatype fileType;
+    MPI_Datatype memType;
+    MPI_File file;
+    
+    if(GLOBAL_ROW(block, firstRow) == 1)
+        firstRow--;
+    if(GLOBAL_ROW(block, lastRow) == block->rows-1)
+        lastRow++;
+    if(GLOBAL_COL(block, firstCol) == 1)
+        firstCol--;
+    if(GLOBAL_COL(block, lastCol) == block->cols-1)
+        lastCol++;
+    subsizes[0] = lastRow - firstRow;
+    subsizes[1] = lastCol - firstCol;
+    starts[0] = GLOBAL_ROW(block, firstRow);
+    starts[1] = GLOBAL_COL(block, firstCol);
+    
+    //Where the region sits in the file, and in the local grid
+    MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C,
+            MPI_DOUBLE, &fileType);
+    MPI_Type_commit(&fileType);
+    MPI_Type_vector(subsizes[0], subsizes[1], local->pitch, MPI_DOUBLE,
+            &memType);
+    MPI_Type_commit(&memType);
+    
+    if(MPI_File_open(block->comm, fileName, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+            MPI_INFO_NULL, &file) != MPI_SUCCESS)
+    {
+        printf("Unable to open %s for writing\n", fileName);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    //Drops anything left over from a larger matrix
+    MPI_File_set_size(file, header + (MPI_Offset)block->rows * block->cols
+            * sizeof(double));
+    MPI_File_set_view(file, header, MPI_DOUBLE, fileType, "native",
+            MPI_INFO_NULL);
+    MPI_File_write_at_all(file, 0, GRID_ROW(local, firstRow) + firstCol, 1,
+            memType, MPI_STATUS_IGNORE);
+    MPI_File_close(&file);
+    MPI_Type_free(&fileType);
+    MPI_Type_free(&memType);
+}
+
+
+// readBlocks
+// INPUT: block (this thread's block), local (this thread's block, to
+//        fill in), fileName (file holding the whole matrix as writeBlocks
+//        leaves it), header (bytes before the matrix)
+// PROC:  Every thread reads its own block, and the neighbours' cells
+//        around it, with a collective MPI-IO read, so the first sweep
+//        finds the halo already in place. Cells on the matrix's boundary
+//        keep their value
+// OUT:   N/A (the block and its halo are in local)
+void readBlocks(const struct block *block, struct grid *local,
+        const char *fileName, MPI_Offset header)
+{
+    int sizes[2] = {block->rows, block->cols};
+    int subsizes[2];
+    int starts[2];
+    int firstRow = block->startRow;
+    int lastRow = block->endRow;
+    int firstCol = block->startCol;
+    int lastCol = block->endCol;
+    MPI_Datatype fileType;
+    MPI_Datatype memType;
+    MPI_File file;
+    
+    if(GLOBAL_ROW(block, firstRow) > 1)
+        firstRow--;
+    if(GLOBAL_ROW(block, lastRow) < block->rows-1)
+        lastRow++;
+    if(GLOBAL_COL(block, firstCol) > 1)
+        firstCol--;
+    if(GLOBAL_COL(block, lastCol) < block->cols-1)
+        lastCol++;
+    subsizes[0] = lastRow - firstRow;
+    subsizes[1] = lastCol - firstCol;
+    starts[0] = GLOBAL_ROW(block, firstRow);
+    starts[1] = GLOBAL_COL(block, firstCol);
+    
+    MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C,
+            MPI_DOUBLE, &fileType);
+    MPI_Type_commit(&fileType);
+    MPI_Type_vector(subsizes[0], subsizes[1], local->pitch, MPI_DOUBLE,
+            &memType);
+    MPI_Type_commit(&memType);
+    
+    if(MPI_File_open(block->comm, fileName, MPI_MODE_RDONLY, MPI_INFO_NULL,
+            &file) != MPI_SUCCESS)
+    {
+        printf("Unable to open %s for reading\n", fileName);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    MPI_File_set_view(file, header, MPI_DOUBLE, fileType, "native",
+            MPI_INFO_NULL);
+    MPI_File_read_at_all(file, 0, GRID_ROW(local, firstRow) + firstCol, 1,
+            memType, MPI_STATUS_IGNORE);
+    MPI_File_close(&file);
+    MPI_Type_free(&fileType);
+    MPI_Type_free(&memType);
+}
+
+
+// blockRegion
+// INPUT: block (any thread's block), row and column of a thread in the
+//        process grid (processRow, processCol), where to put the region
+//        (start, end)
+// PROC:  Works out the global rows and columns of that thread's block,
+//        widened to take in the boundary cells next to it
+// OUT:   N/A (the region covers rows start[0] up to end[0] and columns
+//        start[1] up to end[1])
+void blockRegion(const struct block *block, int processRow,
+        int processCol, int start[2], int end[2])
+{
+    start[0] = block->rowBorders[processRow] - (processRow == 0);
+    end[0] = block->rowBorders[processRow+1]
+            + (processRow == block->dims[0]-1);
+    start[1] = block->colBorders[processCol] - (processCol == 0);
+    end[1] = block->colBorders[processCol+1]
+            + (processCol == block->dims[1]-1);
+}
+
+
+// streamBlocks
+// INPUT: block (this thread's block), local (this thread's processed
+//        block), writer (solution file open on thread 0, NULL elsewhere)
+// PROC:  Thread 0 collects one row of the process grid at a time from the
+//        threads holding it and streams its rows into the writer, so it
+//        only ever holds one band of the matrix. Each thread sends its
+//        block, and the boundary cells next to it, once
+// OUT:   N/A (thread 0 has written every row of the matrix)
+void streamBlocks(const struct block *block, struct grid *local,
+        struct solutionWriter *writer)
+{
+    int start[2];
+    int end[2];
+    int coords[2];
+    int processRow = 0;
+    int processCol = 0;
+    int i = 0;
+    double *band = NULL;
+    double *packed = NULL;
+    blockRegion(block, block->coords[0], block->coords[1], start, end);
+    int width = end[1] - start[1];
+    int height = end[0] - start[0];
+    
+    if(block->rank != 0)
+    {
+        packed = malloc((size_t)width * height * sizeof(double));
+        if(packed == NULL)
+        {
+            printf("Unable to allocate a %dx%d block to send\n", height,
+                    width);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        for(i = 0; i<height; i++)
+            memcpy(packed + (size_t)i * width,
+                    GRID_ROW(local, LOCAL_ROW(block, start[0] + i))
+                    + LOCAL_COL(block, start[1]), width * sizeof(double));
+        MPI_Send(packed, width * height, MPI_DOUBLE, 0, block->coords[0],
+                block->comm);
+        free(packed);
+        return;
+    }
+    
+    //The first and last bands also hold a boundary row
+    int tallest = 0;
+    for(processRow = 0; processRow < block->dims[0]; processRow++)
+    {
+        blockRegion(block, processRow, 0, start, end);
+        if(end[0] - start[0] > tallest)
+            tallest = end[0] - start[0];
+    }
+    band = malloc((size_t)tallest * block->cols * sizeof(double));
+    packed = malloc((size_t)tallest * block->cols * sizeof(double));
+    if(band == NULL || packed == NULL)
+    {
+        printf("Unable to allocate a %dx%d band to write\n", tallest,
+                block->cols);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    for(processRow = 0; processRow < block->dims[0]; processRow++)
+    {
+        for(processCol = 0; processCol < block->dims[1]; processCol++)
+        {
+            int sender = 0;
+            coords[0] = processRow;
+            coords[1] = processCol;
+            MPI_Cart_rank(block->comm, coords, &sender);
+            blockRegion(block, processRow, processCol, start, end);
+            width = end[1] - start[1];
+            height = end[0] - start[0];
+            if(sender == 0)
+                for(i = 0; i<height; i++)
+                    memcpy(packed + (size_t)i * width,
+                            GRID_ROW(local, LOCAL_ROW(block, start[0] + i))
+                            + LOCAL_COL(block, start[1]),
+                            width * sizeof(double));
+            else
+                MPI_Recv(packed, width * height, MPI_DOUBLE, sender,
+                        processRow, block->comm, MPI_STATUS_IGNORE);
+            for(i = 0; i<height; i++)
+                memcpy(band + (size_t)i * block->cols + start[1],
+                        packed + (size_t)i * width, width * sizeof(double));
+        }
+        for(i = 0; i<height; i++)
+            writeSolutionRow(writer, band + (size_t)i * block->cols);
+    }
+    free(band);
+    free(packed);
+}
+
+
+// writeSolution
+// INPUT: block (this thread's block), local (this thread's processed
+//        block), opts (output format and file, and the precision worked
+//        towards), iterations (sweeps or cycles taken), converged (whether
+//        the precision was met)
+// PROC:  Swaps the block's edges so the largest residual of the whole
+//        matrix can be put in the header (see output.h). Uncompressed
+//        files are written by every thread at once (see writeBlocks) with
+//        the header added by thread 0; compressed files are streamed
+//        through thread 0 a band at a time (see streamBlocks)
+// OUT:   0 on success (-1 if the file could not be written), the same on
+//        every thread
+int writeSolution(const struct block *block, struct grid *local,
+        const struct options *opts, int iterations, int converged)
+{
+    struct solutionHeader header;
+    struct solutionWriter *writer = NULL;
+    struct halo halo;
+    double residual = 0;
+    int result = 0;
+    initHalo(&halo, local, block);
+    beginHalo(&halo);
+    endHalo(&halo);
+    freeHalo(&halo);
+    struct stencil *stencil = createBlockStencil(block, local, opts);
+    double largest = (stencil != NULL) ? stencilResidual(stencil, local,
+            block->startRow, block->endRow, block->startCol, block->endCol,
+            NORM_LINF) : bandResidual(local, block->startRow, block->endRow,
+            block->startCol, block->endCol, NORM_LINF);
+    freeStencil(stencil);
+    MPI_Reduce(&largest, &residual, 1, MPI_DOUBLE, MPI_MAX, 0, block->comm);
+    initSolutionHeader(&header, block->rows, block->cols,
+            opts->format == OUTPUT_COMPRESSED, iterations, converged,
+            residual, opts->precision);
+    
+    if(opts->format == OUTPUT_BINARY)
+    {
+        writeBlocks(block, local, opts->outputFile, SOLUTION_HEADER);
+        if(block->rank == 0)
+            result = writeSolutionHeader(opts->outputFile, &header);
+    }
+    else
+    {
+        if(block->rank == 0)
+        {
+            writer = openSolution(opts->outputFile, &header);
+            if(writer == NULL)
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        streamBlocks(block, local, writer);
+        if(block->rank == 0 && closeSolution(writer) != 0)
+        {
+            printf("Unable to write %s\n", opts->outputFile);
+            result = -1;
+        }
+    }
+    MPI_Bcast(&result, 1, MPI_INT, 0, block->comm);
+    return result;
+}
+
+
+// solveSegment
+// INPUT: context (a struct solveContext, giving this thread's block and
+//        workers), opts (solver parameters), test (convergence test,
+//        carried from one call to the next), converged (where to report
+//        whether the precision was met)
+// PROC:  Solves this thread's block for up to opts->maxIterations sweeps
+//        with the method opts gives (see runSegments). Halo rows are
+//        swapped after every sweep, so blocked Jacobi sweeps run one at a
+//        time here
+// OUT:   Number of sweeps (or multigrid cycles) taken
+int solveSegment(void *context, const struct options *opts,
+        struct convergence *test, int *converged)
+{
+    struct solveContext *solve = (struct solveContext*)context;
+    enum sweepMethod method = opts->method;
+    if(opts->dtype != ELEMENT_DOUBLE)
+        return calcMatrixFloat(solve->block, solve->matrix, opts,
+                solve->pool, test, converged);
+    if(method == METHOD_JACOBI || method == METHOD_WAVEFRONT)
+        return calcMatrixJacobi(solve->block, solve->matrix, opts,
+                solve->pool, test, converged);
+    if(method == METHOD_RED_BLACK || method == METHOD_SOR)
+        return calcMatrixRedBlack(solve->block, solve->matrix, opts,
+                solve->pool, test, converged);
+    if(method == METHOD_VCYCLE || method == METHOD_FMG)
+        return calcMatrixMultigrid(solve->block, solve->matrix, opts, test,
+                converged);
+    return calcMatrix(solve->block, solve->matrix, opts, test, converged);
+}
+
+
+// saveSnapshot
+// INPUT: context (a struct solveContext, giving this thread's block and
+//        the checkpoint file), header (describing the snapshot)
+// PROC:  Every thread writes its block into a new file beside the
+//        checkpoint (see writeBlocks), then thread 0 fills in the header
+//        and renames the file over the checkpoint
+// OUT:   0 on success (-1 if the snapshot could not be written), the same
+//        on every thread
+int saveSnapshot(void *context, const struct snapshotHeader *header)
+{
+    struct solveContext *solve = (struct solveContext*)context;
+    char temp[OPTIONS_STRING + 4];
+    int result = 0;
+    double spanStart = TRACE_NOW();
+    snapshotTemp(solve->checkpoint, temp);
+    writeBlocks(solve->block, solve->matrix, temp, SNAPSHOT_HEADER);
+    if(solve->block->rank == 0)
+    {
+        result = writeSnapshotHeader(temp, header);
+        if(result == 0)
+            result = commitSnapshot(temp, solve->checkpoint);
+    }
+    MPI_Bcast(&result, 1, MPI_INT, 0, solve->block->comm);
+    TRACE_SPAN("checkpoint", spanStart);
+    return result;
+}
+
+
+// loadSnapshot
+// INPUT: fileName (snapshot file), opts (solver parameters), block (this
+//        thread's block), myMatrix (this thread's block of the matrix),
+//        header (where to put the snapshot's header)
+// PROC:  Thread 0 reads and checks the header and passes it on, then every
+//        thread reads its block and halo (see readBlocks). The boundary
+//        keeps the value given by the options
+// OUT:   0 on success (-1 if the snapshot could not be used), the same on
+//        every thread
+int loadSnapshot(const char *fileName, const struct options *opts,
+        const struct block *block, struct grid *myMatrix,
+        struct snapshotHeader *header)
+{
+    int result = 0;
+    if(block->rank == 0)
+        result = (readSnapshotHeader(fileName, header) != 0
+                || checkSnapshotHeader(header, opts, fileName) != 0)
+                ? -1 : 0;
+    MPI_Bcast(&result, 1, MPI_INT, 0, block->comm);
+    if(result != 0)
+        return result;
+    MPI_Bcast(header, sizeof(struct snapshotHeader), MPI_BYTE, 0,
+            block->comm);
+    readBlocks(block, myMatrix, fileName, SNAPSHOT_HEADER);
+    return 0;
+}
+
+
+// freeBlock
+// INPUT: block (from createBlock)
+void freeBlock(struct block *block)
+{
+    MPI_Comm_free(&block->comm);
+    free(block->rowBorders);
+    free(block->colBorders);
+}
+
+
+// calcMatrix
+// Main function to perform matrix calculation
+// INPUT: block (this thread's block of the matrix and its neighbours)
+//        myMatrix (threads local matrix to calculate values with)
+//        opts (precision / accuracy to work towards, sweeps between
+//        convergence checks and sweeps allowed)
+//        test (convergence test, carried from one call to the next)
+//        converged (where to report whether the precision was met)
+// PROC:  Calculates the allocated block of the matrix, updating the
+//        interior while the edge rows and columns are swapped with the
+//        neighbours
+// OUT:   Number of sweeps taken (The processed block of the matrix is left
+//        in myMatrix)
+int calcMatrix(struct block *block, struct grid *myMatrix,
+        const struct options *opts, struct convergence *test,
+        int *converged)
+{
+    double precision = opts->precision;
+    int iterations = 0;
+    int rank = 0;
+    int size = 0;
+    MPI_Comm_rank(block->comm, &rank);
+    MPI_Comm_size(block->comm, &size);
+    printf("\nThread %d has started and has the following properties \n "
+                "Block: %d, %d\nRows: %d to %d\nColumns: %d to %d\n"
+                "precision: %lf\narray total rows: %d\ntotal threads: %d\n\n",
+            rank, block->coords[0], block->coords[1],
+            GLOBAL_ROW(block, block->startRow), GLOBAL_ROW(block, block->endRow),
+            GLOBAL_COL(block, block->startCol), GLOBAL_COL(block, block->endCol),
+            precision, block->rows, size);
+    
+    //Each check is reduced over every thread while the next sweep runs
+    struct pendingCheck check;
+    int pending = 0;
+    int done = 0;
+    struct spanUpdate update = {myMatrix, NULL, 0, 1, 0};
+    struct halo halo;
+    initHalo(&halo, myMatrix, block);
+    TRACE_THREAD(rank, 0);
+    
+    do{
+        double maxDelta = 0; //Largest change made to this thread's block
+        
+        // Code for exchange
+        
+        // Post this block's edges and the receives for the rows and
+        // columns around it, then work on the cells that need neither
+        double spanStart = TRACE_NOW();
+        beginHalo(&halo);
+        maxDelta = sweepInterior(block, &gaussSeidelSpan, &update, 0, 1);
+        TRACE_SPAN("sweep", spanStart);
+        
+        // Calculate the edges once the neighbours' values have arrived
+        spanStart = TRACE_NOW();
+        endHalo(&halo);
+        TRACE_SPAN("halo wait", spanStart);
+        spanStart = TRACE_NOW();
+        double edgeDelta = sweepEdge(block, &gaussSeidelSpan, &update);
+        if(edgeDelta > maxDelta)
+            maxDelta = edgeDelta;
+        TRACE_SPAN("sweep", spanStart);
+        
+        //The check started after the last sweep has had this sweep to
+        //complete. The last sweep allowed is checked straight away
+        iterations++;
+        if(pending)
+            done = finishCheck(&check, test);
+        pending = 0;
+        if(checkDue(iterations, opts->checkInterval, opts->maxIterations)
+                && !done)
+        {
+            //Edge cells read the neighbours' edges from before this sweep,
+            //so their residuals trail the rest by a sweep
+            double local = (test->norm == NORM_DELTA) ? maxDelta
+                    : bandResidual(myMatrix, block->startRow, block->endRow,
+                    block->startCol, block->endCol, test->norm);
+            startCheck(&check, test, local, block->comm);
+            pending = underLimit(iterations, opts->maxIterations);
+            if(!pending)
+                done = finishCheck(&check, test);
+        }
+  }while(!done && underLimit(iterations, opts->maxIterations));
+  freeHalo(&halo);
+  *converged = done;
+  if(*converged)
+      printf("\nPRECISION MET ON ALL THREADS\n");
+  return iterations;
+}
+
+
+// calcMatrixJacobi
+// Jacobi version of calcMatrix: reads one buffer and writes the other, so
+// every row goes through the vectorised kernel
+// INPUT: As calcMatrix, plus the workers to share the block between (pool)
+// PROC:  Calculates the allocated block of the matrix. The edges are
+//        worked out first and sent to the neighbouring threads while the
+//        workers work out the interior (see jacobiWorker)
+// OUT:   Number of sweeps taken (The processed block of the matrix is left
+//        in myMatrix)
+int calcMatrixJacobi(struct block *block, struct grid *myMatrix,
+        const struct options *opts, struct pool *pool,
+        struct convergence *test, int *converged)
+{
+    int a = 0;
+    struct sweepTeam team;
+    struct grid *spare = createGrid(myMatrix->rows, myMatrix->cols,
+            myMatrix->halo);
+    struct spanUpdate update = {myMatrix, spare, 0, 1, 0};
+    //The kernel and its residual are chosen once, the plain average unless
+    //the conditions need the general update
+    struct stencil *stencil = createBlockStencil(block, myMatrix, opts);
+    update.stencil = stencil;
+    team.block = block;
+    team.pool = pool;
+    team.update = update;
+    team.span = (stencil != NULL) ? &jacobiSpanStencil : &jacobiSpan;
+    team.residual = (stencil != NULL) ? &spanResidualStencil : &spanResidual;
+    team.test = *test;
+    team.checkInterval = opts->checkInterval;
+    team.maxIterations = opts->maxIterations;
+    copyGrid(spare, myMatrix);
+    initHalo(&team.halos[0], myMatrix, block);
+    initHalo(&team.halos[1], spare, block);
+    
+    runTeam(&team, &jacobiWorker);
+    freeHalo(&team.halos[0]);
+    freeHalo(&team.halos[1]);
+    
+    //Leave the final values of this block, and the halo swapped after the
+    //last sweep, in myMatrix so a later solve can carry on from them
+    if(team.update.matrix != myMatrix)
+        for(a = block->startRow-1; a<=block->endRow; a++)
+            memcpy(GRID_ROW(myMatrix, a) + block->startCol-1,
+                    GRID_ROW(team.update.matrix, a) + block->startCol-1,
+                    (block->endCol - block->startCol + 2) * sizeof(double));
+    freeGrid(spare);
+    freeStencil(stencil);
+    *test = team.test;
+    *converged = team.done;
+    return team.iterations;
+}
+
+
+// calcMatrixRedBlack
+// Red-black version of calcMatrix: updates all red cells of the block,
+// swaps edges, then does the same for the black cells. Results do not
+// depend on the number of threads or workers
+// INPUT: As calcMatrix (opts also giving the over-relaxation factor for
+//        METHOD_SOR), plus the workers to share the block between (pool)
+// PROC:  Calculates the allocated block of the matrix in place (see
+//        redBlackWorker)
+// OUT:   Number of sweeps taken (The processed block of the matrix is left
+//        in myMatrix)
+int calcMatrixRedBlack(struct block *block, struct grid *myMatrix,
+        const struct options *opts, struct pool *pool,
+        struct convergence *test, int *converged)
+{
+    struct sweepTeam team;
+    struct spanUpdate update = {myMatrix, NULL, COLOUR_RED, 1,
+            block->rowOffset + block->colOffset};
+    struct stencil *stencil = createBlockStencil(block, myMatrix, opts);
+    update.stencil = stencil;
+    team.block = block;
+    team.pool = pool;
+    team.update = update;
+    team.span = (stencil != NULL) ? &colourSpanStencil : &colourSpan;
+    team.residual = (stencil != NULL) ? &spanResidualStencil : &spanResidual;
+    team.test = *test;
+    team.checkInterval = opts->checkInterval;
+    team.maxIterations = opts->maxIterations;
+    //Red-black is SOR with no over-relaxation
+    initOmega(&team.estimate, (opts->method == METHOD_SOR) ? opts->omega : 1,
+            block->rows, block->cols);
+    initHalo(&team.halos[0], myMatrix, block);
+    
+    runTeam(&team, &redBlackWorker);
+    freeHalo(&team.halos[0]);
+    freeStencil(stencil);
+    *test = team.test;
+    *converged = team.done;
+    return team.iterations;
+}
+
+
+// calcMatrixFloat
+// Single precision version of calcMatrixJacobi and calcMatrixRedBlack. The
+// float grids are half the size, and so are the edges swapped each sweep
+// INPUT: As calcMatrixRedBlack, opts also giving the method (jacobi,
+//        red-black or sor) and precision (ELEMENT_FLOAT or ELEMENT_MIXED)
+// PROC:  For ELEMENT_FLOAT, rounds the block to single precision, sweeps
+//        it until the largest change is within precision and copies the
+//        result back.
+//        For ELEMENT_MIXED, the main thread swaps the double precision
+//        block's edges and works out its residual; once the residual norm
+//        of the whole matrix meets the test it stops, and otherwise the
+//        workers sweep a single precision correction from zero (see
+//        mixed.h) that is then added to the block. Sweeps of every
+//        correction count towards the sweeps allowed
+// OUT:   Number of sweeps taken (The processed block of the matrix is left
+//        in myMatrix)
+int calcMatrixFloat(struct block *block, struct grid *myMatrix,
+        const struct options *opts, struct pool *pool,
+        struct convergence *test, int *converged)
+{
+    int jacobi = (opts->method == METHOD_JACOBI);
+    int rows = myMatrix->rows;
+    int cols = myMatrix->cols;
+    int iterations = 0;
+    int done = 0;
+    struct sweepTeam team;
+    struct convergence outer;
+    struct halo halo;
+    struct gridf *matrix = reserveGridFloat(rows, cols, 1);
+    struct gridf *spare = jacobi ? reserveGridFloat(rows, cols, 1) : NULL;
+    struct gridf *rhs = (opts->dtype == ELEMENT_MIXED)
+            ? reserveGridFloat(rows, cols, 1) : NULL;
+    if(matrix == NULL || (jacobi && spare == NULL)
+            || (opts->dtype == ELEMENT_MIXED && rhs == NULL))
+    {
+        printf("Unable to allocate a single precision %dx%d block\n", rows,
+                cols);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    struct spanUpdate update = {NULL, NULL, COLOUR_RED, 1,
+            block->rowOffset + block->colOffset, matrix, spare, rhs};
+    team.block = block;
+    team.pool = pool;
+    team.update = update;
+    team.span = jacobi ? &jacobiSpanFloat : &colourSpanFloat;
+    team.residual = &spanResidual;
+    team.test = *test;
+    team.checkInterval = opts->checkInterval;
+    team.maxIterations = opts->maxIterations;
+    initHaloFloat(&team.halos[0], matrix, block);
+    if(jacobi)
+        initHaloFloat(&team.halos[1], spare, block);
+    
+    if(rhs == NULL)
+    {
+        //Ghost cells on the matrix's edge keep the border value
+        narrowRows(matrix, myMatrix, -1, rows+1);
+        if(jacobi)
+            copyGridFloatRows(spare, matrix, -1, rows+1);
+        initOmega(&team.estimate, (opts->method == METHOD_SOR)
+                ? opts->omega : 1, block->rows, block->cols);
+        runTeam(&team, jacobi ? &jacobiWorker : &redBlackWorker);
+        //The halo comes back too, but the matrix's edge keeps its double
+        //value
+        widenRows(myMatrix, team.update.matrixFloat,
+                block->startRow - (GLOBAL_ROW(block, block->startRow) > 1),
+                block->endRow + (GLOBAL_ROW(block, block->endRow)
+                < block->rows-1),
+                block->startCol - (GLOBAL_COL(block, block->startCol) > 1),
+                block->endCol + (GLOBAL_COL(block, block->endCol)
+                < block->cols-1));
+        iterations = team.iterations;
+        done = team.done;
+        *test = team.test;
+    }
+    else
+    {
+        //Corrections are zero on the matrix's edge
+        outer = team.test;
+        copyGridFloatRows(matrix, NULL, -1, rows+1);
+        if(jacobi)
+            copyGridFloatRows(spare, NULL, -1, rows+1);
+        initHalo(&halo, myMatrix, block);
+        for(;;)
+        {
+            double spanStart = TRACE_NOW();
+            beginHalo(&halo);
+            endHalo(&halo);
+            TRACE_SPAN("halo wait", spanStart);
+            spanStart = TRACE_NOW();
+            double local = residualRows(myMatrix, rhs, block->startRow,
+                    block->endRow, block->startCol, block->endCol,
+                    outer.norm);
+            TRACE_SPAN("refine", spanStart);
+            double global = 0;
+            spanStart = TRACE_NOW();
+            MPI_Allreduce(&local, &global, 1, MPI_DOUBLE,
+                    (outer.norm == NORM_L2) ? MPI_SUM : MPI_MAX, block->comm);
+            TRACE_SPAN("allreduce", spanStart);
+            double norm = finishNorm(&outer, global);
+            TRACE_COUNTER("norm", norm);
+            done = hasConverged(&outer, norm);
+            if(done || !underLimit(iterations, opts->maxIterations))
+                break;
+            
+            //Each correction starts from the grids it was set up with
+            initCorrection(&team.test, &outer, norm);
+            team.maxIterations = (opts->maxIterations == 0) ? 0
+                    : opts->maxIterations - iterations;
+            team.update = update;
+            initOmega(&team.estimate, (opts->method == METHOD_SOR)
+                    ? opts->omega : 1, block->rows, block->cols);
+            runTeam(&team, jacobi ? &jacobiWorker : &redBlackWorker);
+            iterations += team.iterations;
+            spanStart = TRACE_NOW();
+            addCorrection(myMatrix, team.update.matrixFloat, block->startRow,
+                    block->endRow, block->startCol, block->endCol);
+            copyGridFloatRows(matrix, NULL, -1, rows+1);
+            if(jacobi)
+                copyGridFloatRows(spare, NULL, -1, rows+1);
+            TRACE_SPAN("refine", spanStart);
+        }
+        freeHalo(&halo);
+        *test = outer;
+    }
+    freeHalo(&team.halos[0]);
+    if(jacobi)
+        freeHalo(&team.halos[1]);
+    freeGridFloat(matrix);
+    freeGridFloat(spare);
+    freeGridFloat(rhs);
+    *converged = done;
+    return iterations;
+}
+
+
+// runTeam
+// INPUT: team (shared state of the sweeps), task (worker thread function)
+// PROC:  Runs task on every worker of team->pool, the calling thread
+//        acting as worker 0
+// OUT:   N/A (returns once every worker has finished)
+void runTeam(struct sweepTeam *team, poolTask task)
+{
+    int workers = poolThreads(team->pool);
+    int i = 0;
+    struct workerArgs *args = malloc(workers * sizeof(struct workerArgs));
+    if(args == NULL)
+    {
+        printf("Unable to allocate arguments for %d workers\n", workers);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    for(i = 0; i<workers; i++)
+    {
+        args[i].team = team;
+        args[i].worker = i;
+    }
+    team->globalDelta = HUGE_VAL;
+    team->done = 0;
+    team->iterations = 0;
+    runPool(team->pool, task, args, sizeof(struct workerArgs));
+    free(args);
+}
+
+
+// checkTeam
+// INPUT: team (shared state of the sweeps), worker (calling worker),
+//        matrix (grid holding the latest values, with a current halo),
+//        maxDelta (largest change made to the block by the last sweep),
+//        whether the last sweep is checked (due), whether the check before
+//        it is still being reduced (pending), and whether no sweep follows
+//        (last)
+// PROC:  Worker 0 finishes the pending check, whose reduction ran during
+//        the last sweep, then starts the reduction for this one. The last
+//        sweep allowed is checked straight away. Residual norms are worked
+//        out by every worker over its share of the block's rows first
+// OUT:   Non zero once a check has met the test, the same on every worker
+int checkTeam(struct sweepTeam *team, int worker, const struct grid *matrix,
+        double maxDelta, int due, int pending, int last)
+{
+    struct block *block = team->block;
+    struct convergence *test = &team->test;
+    int workers = poolThreads(team->pool);
+    double local = maxDelta;
+    double spanStart = TRACE_NOW();
+    if(due && test->norm != NORM_DELTA)
+    {
+        int rows = block->endRow - block->startRow;
+        int startRow = block->startRow + rows * worker / workers;
+        int endRow = block->startRow + rows * (worker+1) / workers;
+        local = team->residual(&team->update, matrix, startRow, endRow,
+                block->startCol, block->endCol, test->norm);
+        if(test->norm == NORM_L2)
+            local = poolReduceSum(team->pool, worker, local);
+        else
+            local = poolReduceMax(team->pool, worker, local);
+    }
+    if(worker == 0)
+    {
+        if(pending)
+            team->done = finishCheck(&team->check, test);
+        if(due && !team->done)
+        {
+            startCheck(&team->check, test, local, block->comm);
+            if(last)
+                team->done = finishCheck(&team->check, test);
+        }
+    }
+    poolBarrier(team->pool, worker);
+    TRACE_SPAN("barrier", spanStart);
+    return team->done;
+}
+
+
+// startCheck
+// INPUT: check (where to hold the reduction), test (convergence test),
+//        local (this thread's largest change, or its residual norm before
+//        finishNorm), comm (every thread)
+// PROC:  Starts reducing every thread's value without waiting for it
+// OUT:   N/A (finishCheck must be called before check is reused)
+void startCheck(struct pendingCheck *check, const struct convergence *test,
+        double local, MPI_Comm comm)
+{
+    check->local = local;
+    MPI_Iallreduce(&check->local, &check->global, 1, MPI_DOUBLE,
+            (test->norm == NORM_L2) ? MPI_SUM : MPI_MAX, comm,
+            &check->request);
+}
+
+
+// finishCheck
+// INPUT: check (started by startCheck), test (convergence test)
+// PROC:  Waits for the reduction to complete
+// OUT:   Non zero if the norm of the whole matrix meets the test
+int finishCheck(struct pendingCheck *check, struct convergence *test)
+{
+    double spanStart = TRACE_NOW();
+    MPI_Wait(&check->request, MPI_STATUS_IGNORE);
+    TRACE_SPAN("allreduce", spanStart);
+    double norm = finishNorm(test, check->global);
+    TRACE_COUNTER("norm", norm);
+    return hasConverged(test, norm);
+}
+
+
+// jacobiWorker (worker thread function)
+// INPUT: Worker's arguments (argsStruct, a struct workerArgs)
+// PROC:  Runs Jacobi sweeps over this worker's band of the block's
+//        interior until a check meets the convergence test (see
+//        checkTeam), or the sweeps allowed are done.
+//        Worker 0 also works out the block's edges and makes the MPI
+//        calls, swapping the edges while the other workers carry on
+// OUT:   N/A (worker 0 leaves the grid holding the result in
+//        team->update.matrix, or matrixFloat, and the number of sweeps in
+//        team->iterations)
+void *jacobiWorker(void *argsStruct)
+{
+    struct workerArgs *args = (struct workerArgs*)argsStruct;
+    struct sweepTeam *team = args->team;
+    struct block *block = team->block;
+    int worker = args->worker;
+    int workers = poolThreads(team->pool);
+    struct spanUpdate update = team->update;
+    struct halo *srcHalo = &team->halos[0];
+    struct halo *dstHalo = &team->halos[1];
+    int iterations = 0;
+    int pending = 0;
+    int done = 0;
+    TRACE_THREAD(block->rank, worker);
+    
+    do{
+        double maxDelta = 0;
+        double spanStart = TRACE_NOW();
+        if(worker == 0)
+        {
+            maxDelta = sweepEdge(block, team->span, &update);
+            beginHalo(dstHalo);
+        }
+        double interiorDelta = sweepInterior(block, team->span, &update,
+                worker, workers);
+        if(interiorDelta > maxDelta)
+            maxDelta = interiorDelta;
+        TRACE_SPAN("sweep", spanStart);
+        if(worker == 0)
+        {
+            spanStart = TRACE_NOW();
+            endHalo(dstHalo);
+            TRACE_SPAN("halo wait", spanStart);
+        }
+        //Also keeps the next sweep from reading a band still being written
+        spanStart = TRACE_NOW();
+        maxDelta = poolReduceMax(team->pool, worker, maxDelta);
+        TRACE_SPAN("barrier", spanStart);
+        
+        //Next sweep reads what this one wrote
+        struct grid *swap = update.matrix;
+        update.matrix = update.next;
+        update.next = swap;
+        struct gridf *swapFloat = update.matrixFloat;
+        update.matrixFloat = update.nextFloat;
+        update.nextFloat = swapFloat;
+        struct halo *swapHalo = srcHalo;
+        srcHalo = dstHalo;
+        dstHalo = swapHalo;
+        
+        iterations++;
+        int due = checkDue(iterations, team->checkInterval,
+                team->maxIterations);
+        int last = !underLimit(iterations, team->maxIterations);
+        if(!due && !pending)
+            continue;
+        done = checkTeam(team, worker, update.matrix, maxDelta, due, pending,
+                last);
+        pending = due && !done && !last;
+    }while(!done && underLimit(iterations, team->maxIterations));
+    
+    if(worker == 0)
+    {
+        team->update = update;
+        team->iterations = iterations;
+    }
+    return NULL;
+}
+
+
+// redBlackWorker (worker thread function)
+// INPUT: Worker's arguments (argsStruct, a struct workerArgs)
+// PROC:  Runs red-black sweeps over this worker's band of the block's
+//        interior until a check meets the convergence test (see
+//        checkTeam). Worker 0 also works out the block's edges, makes the
+//        MPI calls and picks the next over-relaxation factor
+// OUT:   N/A (worker 0 leaves the number of sweeps in team->iterations)
+void *redBlackWorker(void *argsStruct)
+{
+    struct workerArgs *args = (struct workerArgs*)argsStruct;
+    struct sweepTeam *team = args->team;
+    struct block *block = team->block;
+    int worker = args->worker;
+    int workers = poolThreads(team->pool);
+    struct spanUpdate update = team->update;
+    int iterations = 0;
+    int pending = 0;
+    int done = 0;
+    TRACE_THREAD(block->rank, worker);
+    
+    do{
+        double maxDelta = 0;
+        //Read before worker 0 can next change the estimate
+        int adapting = !team->estimate.frozen;
+        update.omega = team->estimate.omega;
+        for(update.colour = COLOUR_RED; update.colour <= COLOUR_BLACK;
+                update.colour++)
+        {
+            //Edges first, so they travel while the interior is worked on.
+            //The other colour reads the edges just updated
+            double spanStart = TRACE_NOW();
+            if(worker == 0)
+            {
+                double edgeDelta = sweepEdge(block, team->span, &update);
+                beginHalo(&team->halos[0]);
+                if(edgeDelta > maxDelta)
+                    maxDelta = edgeDelta;
+            }
+            double interiorDelta = sweepInterior(block, team->span,
+                    &update, worker, workers);
+            if(interiorDelta > maxDelta)
+                maxDelta = interiorDelta;
+            TRACE_SPAN("sweep", spanStart);
+            if(worker == 0)
+            {
+                spanStart = TRACE_NOW();
+                endHalo(&team->halos[0]);
+                TRACE_SPAN("halo wait", spanStart);
+            }
+            //The other colour reads cells from every band
+            spanStart = TRACE_NOW();
+            if(update.colour == COLOUR_RED)
+                poolBarrier(team->pool, worker);
+            else
+                maxDelta = poolReduceMax(team->pool, worker, maxDelta);
+            TRACE_SPAN("barrier", spanStart);
+        }
+        
+        iterations++;
+        int due = checkDue(iterations, team->checkInterval,
+                team->maxIterations);
+        int last = !underLimit(iterations, team->maxIterations);
+        //Every thread sees the same largest change, so adaptive omega
+        //stays in step everywhere. It needs the change after every sweep
+        if(adapting && worker == 0)
+        {
+            double spanStart = TRACE_NOW();
+            MPI_Allreduce(&maxDelta, &team->globalDelta, 1, MPI_DOUBLE,
+                    MPI_MAX, block->comm);
+            TRACE_SPAN("allreduce", spanStart);
+            nextOmega(&team->estimate, team->globalDelta);
+        }
+        if(due || pending)
+        {
+            done = checkTeam(team, worker, update.matrix, maxDelta, due,
+                    pending, last);
+            pending = due && !done && !last;
+        }
+        else if(adapting)
+        {
+            double spanStart = TRACE_NOW();
+            poolBarrier(team->pool, worker);
+            TRACE_SPAN("barrier", spanStart);
+        }
+    }while(!done && underLimit(iterations, team->maxIterations));
+    if(worker == 0)
+        team->iterations = iterations;
+    return NULL;
+}
+
+
+// sweepEdge
+// INPUT: block (this thread's block), funct (update to apply), update
+//        (grids and settings for funct)
+// PROC:  Applies funct to the first and last rows and columns of the
+//        block, the cells the neighbouring threads need
+// OUT:   Largest absolute change made
+double sweepEdge(const struct block *block, spanFunct funct,
+        const struct spanUpdate *update)
+{
+    int a = 0;
+    double maxDelta = funct(update, block->startRow, block->startCol,
+            block->endCol);
+    double delta = 0;
+    if(block->endRow-1 != block->startRow)
+    {
+        delta = funct(update, block->endRow-1, block->startCol,
+                block->endCol);
+        if(delta > maxDelta)
+            maxDelta = delta;
+    }
+    for(a = block->startRow+1; a<block->endRow-1; a++)
+    {
+        delta = funct(update, a, block->startCol, block->startCol+1);
+        if(delta > maxDelta)
+            maxDelta = delta;
+        if(block->endCol-1 != block->startCol)
+        {
+            delta = funct(update, a, block->endCol-1, block->endCol);
+            if(delta > maxDelta)
+                maxDelta = delta;
+        }
+    }
+    return maxDelta;
+}
+
+
+// sweepInterior
+// INPUT: As sweepEdge, plus which of parts equal bands of rows to update
+//        (part, 0 to parts-1)
+// PROC:  Applies funct to the band's cells not on the block's edge; none
+//        of them read the halo
+// OUT:   Largest absolute change made
+double sweepInterior(const struct block *block, spanFunct funct,
+        const struct spanUpdate *update, int part, int parts)
+{
+    int a = 0;
+    double maxDelta = 0;
+    int rows = block->endRow - block->startRow - 2;
+    if(block->endCol - block->startCol < 3 || rows < 1)
+        return 0;
+    int first = block->startRow+1 + rows * part / parts;
+    int last = block->startRow+1 + rows * (part+1) / parts;
+    for(a = first; a<last; a++)
+    {
+        double delta = funct(update, a, block->startCol+1, block->endCol-1);
+        if(delta > maxDelta)
+            maxDelta = delta;
+    }
+    return maxDelta;
+}
+
+
+// gaussSeidelSpan
+// INPUT: update (update->matrix is updated in place), row a, columns from
+//        up to but not including to
+// PROC:  Gauss-Seidel update of the given cells of row a
+// OUT:   Largest absolute change made to a cell
+double gaussSeidelSpan(const struct spanUpdate *update, int a, int from,
+        int to)
+{
+    double *up = GRID_ROW(update->matrix, a-1);
+    double *row = GRID_ROW(update->matrix, a);
+    double *down = GRID_ROW(update->matrix, a+1);
+    double maxDelta = 0;
+    int b = 0;
+    for(b = from; b<to; b++){ //Iterate through the columns
+        double oldValue = row[b];
+        row[b] = (up[b] + row[b-1] + down[b] + row[b+1]) / 4;
+        if(fabs(oldValue - row[b]) > maxDelta)
+            maxDelta = fabs(oldValue - row[b]);
+    }
+    return maxDelta;
+}
+
+
+// jacobiSpan
+// INPUT: As gaussSeidelSpan, reading update->matrix and writing
+//        update->next
+// OUT:   Largest absolute change made to a cell
+double jacobiSpan(const struct spanUpdate *update, int a, int from, int to)
+{
+    //The kernel updates columns 1 .. cols-2 of the rows it is given
+    return jacobiRow(GRID_ROW(update->matrix, a-1) + from-1,
+            GRID_ROW(update->matrix, a) + from-1,
+            GRID_ROW(update->matrix, a+1) + from-1,
+            GRID_ROW(update->next, a) + from-1, to - from + 2);
+}
+
+
+// colourSpan
+// INPUT: As gaussSeidelSpan, updating the cells of update->colour by
+//        update->omega
+// OUT:   Largest absolute change made to a cell
+double colourSpan(const struct spanUpdate *update, int a, int from, int to)
+{
+    //Colour comes from the global row and column, not the local ones
+    return colourRow(GRID_ROW(update->matrix, a-1) + from-1,
+            GRID_ROW(update->matrix, a) + from-1,
+            GRID_ROW(update->matrix, a+1) + from-1, NULL, to - from + 2,
+            COLOUR_FIRST(a + from-1 + update->parity, update->colour),
+            update->omega);
+}
+
+
+// jacobiSpanStencil
+// INPUT: As jacobiSpan, applying update->stencil's general update
+// OUT:   Largest absolute change made to a cell
+double jacobiSpanStencil(const struct spanUpdate *update, int a, int from,
+        int to)
+{
+    return stencilJacobiRow(update->stencil, update->matrix, update->next, a,
+            from, to);
+}
+
+
+// colourSpanStencil
+// INPUT: As colourSpan, applying update->stencil's general update
+// OUT:   Largest absolute change made to a cell
+double colourSpanStencil(const struct spanUpdate *update, int a, int from,
+        int to)
+{
+    return stencilColourRow(update->stencil, update->matrix, a, from, to,
+            update->parity, update->colour, update->omega);
+}
+
+
+// spanResidual
+// INPUT: Update the residual is of (update), grid to measure (matrix),
+//        rows (startRow up to but not including endRow) and columns
+//        (startCol up to but not including endCol) to measure, norm to
+//        take (norm)
+// OUT:   As bandResidual, for the average of the neighbours
+double spanResidual(const struct spanUpdate *update,
+        const struct grid *matrix, int startRow, int endRow, int startCol,
+        int endCol, enum convergenceNorm norm)
+{
+    return bandResidual(matrix, startRow, endRow, startCol, endCol, norm);
+}
+
+
+// spanResidualStencil
+// INPUT: As spanResidual
+// OUT:   As stencilResidual, for update->stencil's general update
+double spanResidualStencil(const struct spanUpdate *update,
+        const struct grid *matrix, int startRow, int endRow, int startCol,
+        int endCol, enum convergenceNorm norm)
+{
+    return stencilResidual(update->stencil, matrix, startRow, endRow,
+            startCol, endCol, norm);
+}
+
+
+// jacobiSpanFloat
+// INPUT: As jacobiSpan, reading update->matrixFloat and writing
+//        update->nextFloat, adding update->rhs to every update
+// OUT:   Largest absolute change made to a cell
+double jacobiSpanFloat(const struct spanUpdate *update, int a, int from,
+        int to)
+{
+    return jacobiRowFloat(GRID_ROW(update->matrixFloat, a-1) + from-1,
+            GRID_ROW(update->matrixFloat, a) + from-1,
+            GRID_ROW(update->matrixFloat, a+1) + from-1,
+            (update->rhs != NULL) ? GRID_ROW(update->rhs, a) + from-1 : NULL,
+            GRID_ROW(update->nextFloat, a) + from-1, to - from + 2);
+}
+
+
+// colourSpanFloat
+// INPUT: As colourSpan, updating update->matrixFloat in place and adding
+//        update->rhs to every update
+// OUT:   Largest absolute change made to a cell
+double colourSpanFloat(const struct spanUpdate *update, int a, int from,
+        int to)
+{
+    return colourRowFloat(GRID_ROW(update->matrixFloat, a-1) + from-1,
+            GRID_ROW(update->matrixFloat, a) + from-1,
+            GRID_ROW(update->matrixFloat, a+1) + from-1,
+            (update->rhs != NULL) ? GRID_ROW(update->rhs, a) + from-1 : NULL,
+            to - from + 2,
+            COLOUR_FIRST(a + from-1 + update->parity, update->colour),
+            update->omega);
+}
+
+
+// exchangeRows
+// INPUT: matrix (grid holding this section and the rows either side)
+//        start, end (first and one past the last row of this section)
+//        up, down (ranks holding the sections above and below, or
+//        MPI_PROC_NULL at the edge of the matrix)
+// PROC:  Sends the first row up for the row below the previous section,
+//        and the last row down for the row above the next section. All
+//        four transfers are in flight together
+// OUT:   N/A (rows start-1 and end hold the neighbours' edge rows)
+void exchangeRows(struct grid *matrix, int start, int end, int up, int down)
+{
+    int arrayCols = matrix->cols;
+    MPI_Request requests[4];
+    MPI_Irecv(GRID_ROW(matrix, start-1), arrayCols, MPI_DOUBLE, up, 1,
+            MPI_COMM_WORLD, &requests[0]);
+    MPI_Irecv(GRID_ROW(matrix, end), arrayCols, MPI_DOUBLE, down, 0,
+            MPI_COMM_WORLD, &requests[1]);
+    MPI_Isend(GRID_ROW(matrix, start), arrayCols, MPI_DOUBLE, up, 0,
+            MPI_COMM_WORLD, &requests[2]);
+    MPI_Isend(GRID_ROW(matrix, end-1), arrayCols, MPI_DOUBLE, down, 1,
+            MPI_COMM_WORLD, &requests[3]);
+    MPI_Waitall(4, requests, MPI_STATUSES_IGNORE);
+}
+
+
+// initHalo
+// INPUT: halo (requests to set up), matrix (grid whose edges are swapped),
+//        block (this thread's block and neighbours)
+// PROC:  Sets up the halo of a grid of doubles (see initHaloRows)
+// OUT:   N/A (halo is ready for beginHalo)
+void initHalo(struct halo *halo, struct grid *matrix,
+        const struct block *block)
+{
+    initHaloRows(halo, (char*)GRID_ROW(matrix, 0), matrix->pitch, MPI_DOUBLE,
+            block);
+}
+
+
+// initHaloFloat
+// INPUT: As initHalo, for a grid of floats
+// PROC:  Sets up the halo of a grid of floats, whose messages are half the
+//        size of a grid of doubles' (see initHaloRows)
+// OUT:   N/A (halo is ready for beginHalo)
+void initHaloFloat(struct halo *halo, struct gridf *matrix,
+        const struct block *block)
+{
+    initHaloRows(halo, (char*)GRID_ROW(matrix, 0), matrix->pitch, MPI_FLOAT,
+            block);
+}
+
+
+// initHaloRows
+// INPUT: halo (requests to set up), row0 (start of local row 0 of the
+//        grid whose edges are swapped), pitch (elements between rows),
+//        type (MPI type of an element), block (this thread's block and
+//        neighbours)
+// PROC:  Creates persistent requests that send the block's first and last
+//        rows and columns to the neighbours and receive theirs around the
+//        block. Rows are contiguous; columns are strided by the row pitch
+// OUT:   N/A (halo is ready for beginHalo)
+void initHaloRows(struct halo *halo, char *row0, int pitch,
+        MPI_Datatype type, const struct block *block)
+{
+    int width = block->endCol - block->startCol;
+    int size = 0;
+    MPI_Type_size(type, &size);
+    MPI_Type_vector(block->endRow - block->startRow, 1, pitch, type,
+            &halo->column);
+    MPI_Type_commit(&halo->column);
+    ptrdiff_t row = (ptrdiff_t)pitch * size; // Bytes between rows
+    char *above = row0 + (block->startRow-1) * row;
+    char *first = row0 + block->startRow * row;
+    char *last = row0 + (block->endRow-1) * row;
+    char *below = row0 + block->endRow * row;
+    //Tags give the direction of travel: up 0, down 1, left 2, right 3
+    MPI_Recv_init(above + block->startCol * size, width, type, block->up, 1,
+            block->comm, &halo->requests[0]);
+    MPI_Recv_init(below + block->startCol * size, width, type, block->down,
+            0, block->comm, &halo->requests[1]);
+    MPI_Recv_init(first + (block->startCol-1) * size, 1, halo->column,
+            block->left, 3, block->comm, &halo->requests[2]);
+    MPI_Recv_init(first + block->endCol * size, 1, halo->column, block->right,
+            2, block->comm, &halo->requests[3]);
+    MPI_Send_init(first + block->startCol * size, width, type, block->up, 0,
+            block->comm, &halo->requests[4]);
+    MPI_Send_init(last + block->startCol * size, width, type, block->down, 1,
+            block->comm, &halo->requests[5]);
+    MPI_Send_init(first + block->startCol * size, 1, halo->column,
+            block->left, 2, block->comm, &halo->requests[6]);
+    MPI_Send_init(first + (block->endCol-1) * size, 1, halo->column,
+            block->right, 3, block->comm, &halo->requests[7]);
+}
+
+
+// beginHalo
+// INPUT: halo (requests from initHalo)
+// PROC:  Starts sending the block's edges and receiving the neighbours'.
+//        The edges may be read, but not written, until endHalo
+void beginHalo(struct halo *halo)
+{
+    MPI_Startall(8, halo->requests);
+}
+
+
+// endHalo
+// INPUT: halo (requests started by beginHalo)
+// PROC:  Waits for the transfers to finish
+// OUT:   N/A (the rows and columns around the block hold the neighbours'
+//        edges)
+void endHalo(struct halo *halo)
+{
+    MPI_Waitall(8, halo->requests, MPI_STATUSES_IGNORE);
+}
+
+
+// freeHalo
+// INPUT: halo (requests from initHalo, not in flight)
+void freeHalo(struct halo *halo)
+{
+    int i = 0;
+    for(i = 0; i<8; i++)
+        MPI_Request_free(&halo->requests[i]);
+    MPI_Type_free(&halo->column);
+}
+
+
+// calcMatrixMultigrid
+// Multigrid version of calcMatrix. Each thread holds its band of every
+// level plus one halo row either side; coarse bands sit under the fine
+// band, so restriction and prolongation only need the halo rows. Once a
+// level gets too thin to split, it and every coarser level are gathered
+// onto thread 0 and cycled there alone
+// INPUT: block (this thread's block, the threads forming a single column
+//        of the process grid)
+//        myMatrix (this thread's block, used as its band of the finest
+//        level)
+//        opts (largest residual to accept, METHOD_VCYCLE or METHOD_FMG,
+//        and the cycles allowed)
+//        test (convergence test, carried from one call to the next)
+//        converged (where to report whether the precision was met)
+// PROC:  Runs multigrid cycles until the largest residual is within
+//        precision
+// OUT:   Number of cycles run (The processed section of the matrix is
+//        left in myMatrix)
+int calcMatrixMultigrid(struct block *block, struct grid *myMatrix,
+        const struct options *opts, struct convergence *test,
+        int *converged)
+{
+    enum mgSchedule schedule = (opts->method == METHOD_FMG) ? MG_FMG
+            : MG_VCYCLE;
+    int world_rank = block->coords[0];
+    int world_size = block->dims[0];
+    int count = countLevels(block->rows, block->cols);
+    TRACE_THREAD(block->rank, 0);
+    int *starts = malloc(world_size * sizeof(int));
+    int *ends = malloc(world_size * sizeof(int));
+    struct mgLevel *levels = calloc(count, sizeof(struct mgLevel));
+    struct rankTeam team;
+    struct mgOps ops;
+    int rows = block->rows;
+    int cols = block->cols;
+    double lastRow = 1;
+    double lastCol = 1;
+    int agglomerateLevel = count;
+    int k = 0;
+    int l = 0;
+    
+    for(k = 0; k < world_size; k++)
+    {
+        starts[k] = block->rowBorders[k];
+        ends[k] = block->rowBorders[k+1];
+    }
+    //Build local levels down to the first one too thin to split
+    for(l = 0; l < count; l++)
+    {
+        int n = ends[world_rank] - starts[world_rank];
+        int thinnest = n;
+        for(k = 0; k < world_size; k++)
+            if(ends[k] - starts[k] < thinnest)
+                thinnest = ends[k] - starts[k];
+        
+        levels[l].rows = rows;
+        levels[l].cols = cols;
+        levels[l].lastRow = lastRow;
+        levels[l].lastCol = lastCol;
+        levels[l].rowOffset = starts[world_rank];
+        levels[l].startRow = starts[world_rank];
+        levels[l].endRow = ends[world_rank];
+        //The local matrix is laid out as the finest level's band
+        levels[l].u = (l > 0) ? createGrid(n, cols, 1) : myMatrix;
+        levels[l].r = createGrid(n, cols, 1);
+        levels[l].b = (l > 0) ? createGrid(n, cols, 1) : NULL;
+        if(world_size > 1 && (thinnest < MG_MIN_BAND_ROWS || l == count-1))
+        {
+            agglomerateLevel = l;
+            break;
+        }
+        
+        //Coarse row I sits on fine row 2I, so take the rows under the band
+        for(k = 0; k < world_size; k++)
+        {
+            starts[k] = (starts[k] + 1) / 2;
+            ends[k] = (ends[k] + 1) / 2;
+        }
+        lastRow = MG_COARSE_LAST(rows, lastRow);
+        lastCol = MG_COARSE_LAST(cols, lastCol);
+        rows = MG_COARSE(rows);
+        cols = MG_COARSE(cols);
+    }
+    
+    team.world_rank = world_rank;
+    team.world_size = world_size;
+    team.up = (world_rank != 0) ? world_rank-1 : MPI_PROC_NULL;
+    team.down = (world_rank != world_size-1) ? world_rank+1 : MPI_PROC_NULL;
+    team.counts = NULL;
+    team.displs = NULL;
+    team.serial = NULL;
+    team.serialCount = 0;
+    if(agglomerateLevel < count)
+    {
+        //Each thread sends its band, plus the boundary row beyond it for
+        //the first and last thread
+        int pitch = levels[agglomerateLevel].u->pitch;
+        team.counts = malloc(world_size * sizeof(int));
+        team.displs = malloc(world_size * sizeof(int));
+        for(k = 0; k < world_size; k++)
+        {
+            int first = (k == 0) ? 0 : starts[k];
+            int last = (k == world_size-1) ? rows : ends[k];
+            team.counts[k] = (last - first) * pitch;
+            team.displs[k] = first * pitch;
+        }
+        if(world_rank == 0)
+        {
+            team.serialCount = count - agglomerateLevel;
+            team.serial = createLevels(team.serialCount, rows, cols,
+                    lastRow, lastCol);
+            if(team.serial == NULL)
+            {
+                printf("Unable to allocate the serial multigrid levels\n");
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            team.serial[0].u = createGrid(rows, cols, 0);
+            team.serial[0].b = (agglomerateLevel > 0)
+                    ? createGrid(rows, cols, 0) : NULL;
+        }
+    }
+    ops.context = &team;
+    ops.exchange = &rankExchange;
+    ops.reduceMax = &rankReduceMax;
+    ops.reduceSum = &rankReduceSum;
+    ops.lead = (world_size == 1);
+    ops.agglomerateLevel = agglomerateLevel;
+    ops.agglomerate = &rankAgglomerate;
+    
+    double residual = 0;
+    int cycles = solveMultigrid(levels, count, &ops, schedule, test,
+            opts->maxIterations, &residual);
+    *converged = hasConverged(test, residual);
+    
+    for(l = 0; l < count && l <= agglomerateLevel; l++)
+    {
+        if(l > 0)
+            freeGrid(levels[l].u);
+        freeGrid(levels[l].r);
+        freeGrid(levels[l].b);
+    }
+    if(team.serial != NULL)
+    {
+        freeGrid(team.serial[0].u);
+        freeGrid(team.serial[0].b);
+        freeLevels(team.serial, team.serialCount);
+    }
+    free(team.counts);
+    free(team.displs);
+    free(levels);
+    free(starts);
+    free(ends);
+    return cycles;
+}
+
+
+// rankExchange
+// INPUT: context (this thread's rankTeam), level and one of its grids (g)
+// PROC:  Swaps the edge rows of this thread's band of g with the threads
+//        above and below
+// OUT:   N/A (the halo rows of g are current)
+void rankExchange(void *context, struct mgLevel *level, struct grid *g)
+{
+    struct rankTeam *team = (struct rankTeam*)context;
+    double spanStart = TRACE_NOW();
+    exchangeRows(g, 0, level->endRow - level->startRow, team->up, team->down);
+    TRACE_SPAN("halo wait", spanStart);
+}
+
+
+// rankReduceMax
+// INPUT: context (unused), value from this thread (value)
+// OUT:   Largest value from any thread
+double rankReduceMax(void *context, double value)
+{
+    double largest = 0;
+    double spanStart = TRACE_NOW();
+    MPI_Allreduce(&value, &largest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    TRACE_SPAN("allreduce", spanStart);
+    TRACE_COUNTER("norm", largest);
+    return largest;
+}
+
+
+// rankReduceSum
+// INPUT: context (unused), value from this thread (value)
+// OUT:   Sum of the values from every thread
+double rankReduceSum(void *context, double value)
+{
+    double sum = 0;
+    double spanStart = TRACE_NOW();
+    MPI_Allreduce(&value, &sum, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    TRACE_SPAN("allreduce", spanStart);
+    return sum;
+}
+
+
+// rankAgglomerate
+// INPUT: context (this thread's rankTeam), local levels (levels), level to
+//        agglomerate (level), schedule to run on it (schedule)
+// PROC:  Gathers every thread's band of u and b onto thread 0, which runs
+//        the schedule on its own copy of this level and the ones below.
+//        The result is scattered back into each band
+// OUT:   N/A (u on the level holds the coarse solution; halos are stale)
+void rankAgglomerate(void *context, struct mgLevel *levels, int level,
+        enum mgSchedule schedule)
+{
+    struct rankTeam *team = (struct rankTeam*)context;
+    struct mgLevel *mine = &levels[level];
+    struct mgLevel *whole = team->serial;
+    int rank = team->world_rank;
+    int first = (rank == 0) ? mine->startRow-1 : mine->startRow;
+    int count = team->counts[rank];
+    struct mgOps serialOps;
+    
+    MPI_Gatherv(LEVEL_ROW(mine, mine->u, first), count, MPI_DOUBLE,
+            (rank == 0) ? whole[0].u->data : NULL, team->counts,
+            team->displs, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if(mine->b != NULL)
+        MPI_Gatherv(LEVEL_ROW(mine, mine->b, first), count, MPI_DOUBLE,
+                (rank == 0) ? whole[0].b->data : NULL, team->counts,
+                team->displs, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if(rank == 0)
+    {
+        serialOps.context = NULL;
+        serialOps.exchange = &serialExchange;
+        serialOps.reduceMax = &serialReduceMax;
+        serialOps.reduceSum = &serialReduceMax; // As is the sum
+        serialOps.lead = 1;
+        serialOps.agglomerateLevel = team->serialCount;
+        serialOps.agglomerate = NULL;
+        if(schedule == MG_FMG)
+            fullMultigrid(whole, team->serialCount, 0, &serialOps);
+        else
+            vCycle(whole, team->serialCount, 0, &serialOps);
+    }
+    MPI_Scatterv((rank == 0) ? whole[0].u->data : NULL, team->counts,
+            team->displs, MPI_DOUBLE, LEVEL_ROW(mine, mine->u, first), count,
+            MPI_DOUBLE, 0, MPI_COMM_WORLD);
+}
+
+
+// serialExchange
+// Thread 0 holds agglomerated levels whole, so there is nothing to swap
+void serialExchange(void *context, struct mgLevel *level, struct grid *g)
+{
+}
+
+
+// serialReduceMax
+// Thread 0 holds agglomerated levels whole, so its value is the largest
+double serialReduceMax(void *context, double value)
+{
+    return value;
+}
@@ -0,0 +1,165 @@
+// Neighbour flags: bands of rows synchronised point to point, no barrier
+// Candidate Number: 11066
+//
+// A sweep of one band only reads the edge rows of the bands either side
+// of it, yet a barrier holds every thread until the slowest has finished.
+// Here each band counts the phases of the solve it has finished (a Jacobi
+// sweep, one colour of a red-black sweep, or the residual of a check) in
+// its own flag, published with a release store. Before starting a phase a
+// thread waits, with acquire loads, until both neighbours have finished
+// as many phases as it has. Its neighbours' edge rows are then those of
+// the last phase, and neither neighbour can get a whole phase ahead and
+// overwrite rows it still has to read. Bands further away are never waited
+// on, so threads drift apart in a pipeline, each at most one phase from
+// its neighbours.
+//
+// Convergence checks cannot avoid hearing from every band. Each thread
+// posts its norm in its flag and carries on; the check is reduced after
+// the following sweep, by which time the other bands have usually posted
+// theirs. Every thread adds the posted values up in band order, so all of
+// them reach the same decision after the same sweep and the sums do not
+// depend on timing. Each flag keeps two checks, as a fast thread can post
+// the next one before a slow one has read the last.
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include "flags.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FLAG_PAUSE() _mm_pause()
+#else
+#define FLAG_PAUSE()
+#endif
+
+
+//createBandFlags
+//INPUT: Number of bands, one per thread (bands)
+//OUT:   Pointer to the flags, no phase finished and no check posted (NULL
+//       on failure)
+struct bandFlags *createBandFlags(int bands)
+{
+    struct bandFlags *flags = malloc(sizeof(struct bandFlags));
+    int i = 0;
+    if(flags == NULL)
+        return NULL;
+    flags->bands = bands;
+    flags->spins = (bands <= sysconf(_SC_NPROCESSORS_ONLN)) ? FLAG_SPINS : 0;
+    flags->flags = aligned_alloc(FLAG_LINE, bands * sizeof(struct bandFlag));
+    if(flags->flags == NULL)
+    {
+        free(flags);
+        return NULL;
+    }
+    for(i = 0; i<bands; i++)
+    {
+        atomic_init(&flags->flags[i].phases, 0);
+        atomic_init(&flags->flags[i].checks[0], 0);
+        atomic_init(&flags->flags[i].checks[1], 0);
+        flags->flags[i].values[0] = 0;
+        flags->flags[i].values[1] = 0;
+    }
+    return flags;
+}
+
+
+//finishPhase
+//INPUT: Flags (flags), calling thread's band (band), phases it has now
+//       finished (phases)
+//PROC:  Publishes the count, along with every row the band wrote before it
+//OUT:   N/A
+void finishPhase(struct bandFlags *flags, int band, int phases)
+{
+    atomic_store_explicit(&flags->flags[band].phases, phases,
+            memory_order_release);
+}
+
+
+//waitFlag
+//INPUT: Flags (flags), counter to watch (counter), value to wait for
+//       (target)
+//PROC:  Polls the counter until it reaches target, spinning for a while
+//       and then giving up the processor between polls
+//OUT:   N/A
+static void waitFlag(const struct bandFlags *flags, atomic_int *counter,
+        int target)
+{
+    int i = 0;
+    for(i = 0; atomic_load_explicit(counter, memory_order_acquire) < target;
+            i++)
+    {
+        if(i < flags->spins)
+            FLAG_PAUSE();
+        else
+            sched_yield();
+    }
+}
+
+
+//waitNeighbours
+//INPUT: Flags (flags), calling thread's band (band), phases it has
+//       finished (phases)
+//PROC:  Waits until the bands above and below have finished as many
+//       phases, so the rows they wrote can be read and they will not
+//       write again until this band has finished its next phase
+//OUT:   N/A
+void waitNeighbours(struct bandFlags *flags, int band, int phases)
+{
+    if(band > 0)
+        waitFlag(flags, &flags->flags[band-1].phases, phases);
+    if(band < flags->bands-1)
+        waitFlag(flags, &flags->flags[band+1].phases, phases);
+}
+
+
+//postCheck
+//INPUT: Flags (flags), calling thread's band (band), number of the check
+//       counting from 1 (check), the band's norm (value)
+//PROC:  Posts the band's value, which is read by every thread once all
+//       have posted (see reduceCheck)
+//OUT:   N/A
+void postCheck(struct bandFlags *flags, int band, int check, double value)
+{
+    struct bandFlag *flag = &flags->flags[band];
+    flag->values[check & 1] = value;
+    atomic_store_explicit(&flag->checks[check & 1], check,
+            memory_order_release);
+}
+
+
+//reduceCheck
+//INPUT: Flags (flags), number of a check this thread has posted (check),
+//       non zero to add the values rather than take the largest (sum)
+//PROC:  Waits for every band to post the check, then reduces the values
+//       in band order
+//OUT:   Largest value (or sum of the values) posted for the check
+double reduceCheck(struct bandFlags *flags, int check, int sum)
+{
+    double reduced = 0;
+    int i = 0;
+    for(i = 0; i<flags->bands; i++)
+    {
+        struct bandFlag *flag = &flags->flags[i];
+        waitFlag(flags, &flag->checks[check & 1], check);
+        if(i == 0)
+            reduced = flag->values[check & 1];
+        else if(sum)
+            reduced += flag->values[check & 1];
+        else if(flag->values[check & 1] > reduced)
+            reduced = flag->values[check & 1];
+    }
+    return reduced;
+}
+
+
+//freeBandFlags
+//INPUT: Flags no thread is using (flags), may be NULL
+void freeBandFlags(struct bandFlags *flags)
+{
+    if(flags == NULL)
+        return;
+    free(flags->flags);
+    free(flags);
+}
@@ -0,0 +1,40 @@
+// Neighbour flags: bands of rows synchronised point to point, no barrier
+// Candidate Number: 11066
+
+#ifndef FLAGS_H
+#define FLAGS_H
+
+#include <stdatomic.h>
+
+// Bytes given to each band's flag
+#define FLAG_LINE 64
+
+// Polls of a flag before a waiting thread starts yielding its processor.
+// Threads only spin when each can have a processor to itself
+#define FLAG_SPINS 20000
+
+//Struct holding what one band publishes, alone on its cache line. Only
+//the band's own thread writes it
+struct bandFlag
+{
+    _Alignas(FLAG_LINE) atomic_int phases; // Phases of the solve finished
+    atomic_int checks[2]; // Last check posted to each half of values
+    double values[2]; // This band's norm for those checks
+};
+
+//Struct holding the flags of every band of one solve
+struct bandFlags
+{
+    int bands;
+    int spins; // Polls before yielding (FLAG_SPINS, or 0 if oversubscribed)
+    struct bandFlag *flags; // One per band, top to bottom
+};
+
+struct bandFlags *createBandFlags(int bands);
+void finishPhase(struct bandFlags *flags, int band, int phases);
+void waitNeighbours(struct bandFlags *flags, int band, int phases);
+void postCheck(struct bandFlags *flags, int band, int check, double value);
+double reduceCheck(struct bandFlags *flags, int check, int sum);
+void freeBandFlags(struct bandFlags *flags);
+
+#endif
@@ -0,0 +1,168 @@
+// Contiguous grid storage shared by the shared and distributed solvers
+// Candidate Number: 11066
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "grid.h"
+
+
+//reserveGrid
+//INPUT: As createGrid
+//PROC:  Makes one GRID_ALIGN aligned allocation for every row, with the row
+//       pitch padded so each row starts on an aligned boundary. The rows
+//       are not written, so on a NUMA machine each page is placed next to
+//       the first thread to write it
+//OUT:   Pointer to the uninitialised grid (NULL if allocation failed)
+struct grid *reserveGrid(int rows, int cols, int halo)
+{
+    struct grid *g = malloc(sizeof(struct grid));
+    if(g == NULL)
+        return NULL;
+
+    int perLine = GRID_ALIGN / sizeof(double); // Doubles per aligned block
+    g->rows = rows;
+    g->cols = cols;
+    g->halo = halo;
+    g->pitch = ((cols + perLine - 1) / perLine) * perLine;
+
+    size_t bytes = (size_t)(rows + 2*halo) * g->pitch * sizeof(double);
+    if(posix_memalign((void **)&g->data, GRID_ALIGN, bytes) != 0)
+    {
+        free(g);
+        return NULL;
+    }
+    return g;
+}
+
+
+//createGrid
+//INPUT: Number of rows and columns in the grid (rows, cols)
+//       Number of ghost rows to add above and below the grid (halo)
+//PROC:  Reserves the grid and zeroes it from the calling thread
+//OUT:   Pointer to the zero filled grid (NULL if allocation failed)
+struct grid *createGrid(int rows, int cols, int halo)
+{
+    struct grid *g = reserveGrid(rows, cols, halo);
+    if(g != NULL)
+        memset(g->data, 0, (size_t)(rows + 2*halo) * g->pitch
+                * sizeof(double));
+    return g;
+}
+
+
+//fillGridBorder
+//INPUT: Grid to be filled (g), value to place on its outer edge (borderValue)
+//PROC:  Sets the first and last rows and columns of the grid to borderValue
+//OUT:   N/A (the grid border is filled)
+void fillGridBorder(struct grid *g, double borderValue)
+{
+    int i = 0;
+    int j = 0;
+    for(j=0; j<g->cols; j++)
+    {
+        GRID_AT(g, 0, j) = borderValue;
+        GRID_AT(g, g->rows-1, j) = borderValue;
+    }
+    for(i=1; i<g->rows-1; i++)
+    {
+        GRID_AT(g, i, 0) = borderValue;
+        GRID_AT(g, i, g->cols-1) = borderValue;
+    }
+}
+
+
+//copyGrid
+//INPUT: Destination and source grids of the same shape (dst, src)
+//PROC:  Copies every row of src (halo rows included) into dst
+//OUT:   N/A (dst holds the same values as src)
+void copyGrid(struct grid *dst, const struct grid *src)
+{
+    memcpy(dst->data, src->data,
+            (size_t)(src->rows + 2*src->halo) * src->pitch * sizeof(double));
+}
+
+
+//copyGridRows
+//INPUT: Destination and source grids of the same shape (dst, src), rows to
+//       copy (startRow up to but not including endRow, halo rows allowed)
+//       or NULL src to zero the rows instead
+//PROC:  Copies (or zeroes) whole rows, padding included
+//OUT:   N/A (the rows of dst hold the same values as src)
+void copyGridRows(struct grid *dst, const struct grid *src, int startRow,
+        int endRow)
+{
+    size_t bytes = (size_t)(endRow - startRow) * dst->pitch * sizeof(double);
+    if(endRow <= startRow)
+        return;
+    if(src == NULL)
+        memset(GRID_ROW(dst, startRow), 0, bytes);
+    else
+        memcpy(GRID_ROW(dst, startRow), GRID_ROW(src, startRow), bytes);
+}
+
+
+//freeGrid
+//PROC: Frees the grid allocation and the grid struct
+void freeGrid(struct grid *g)
+{
+    if(g == NULL)
+        return;
+    free(g->data);
+    free(g);
+}
+
+
+//reserveGridFloat
+//INPUT: As createGrid
+//PROC:  As reserveGrid, for a grid of floats. Twice as many floats fit in
+//       each aligned block, so rows are padded to a multiple of 16
+//OUT:   Pointer to the uninitialised grid (NULL if allocation failed)
+struct gridf *reserveGridFloat(int rows, int cols, int halo)
+{
+    struct gridf *g = malloc(sizeof(struct gridf));
+    if(g == NULL)
+        return NULL;
+
+    int perLine = GRID_ALIGN / sizeof(float); // Floats per aligned block
+    g->rows = rows;
+    g->cols = cols;
+    g->halo = halo;
+    g->pitch = ((cols + perLine - 1) / perLine) * perLine;
+
+    size_t bytes = (size_t)(rows + 2*halo) * g->pitch * sizeof(float);
+    if(posix_memalign((void **)&g->data, GRID_ALIGN, bytes) != 0)
+    {
+        free(g);
+        return NULL;
+    }
+    return g;
+}
+
+
+//copyGridFloatRows
+//INPUT: As copyGridRows, for grids of floats
+//PROC:  Copies (or zeroes) whole rows, padding included
+//OUT:   N/A (the rows of dst hold the same values as src)
+void copyGridFloatRows(struct gridf *dst, const struct gridf *src,
+        int startRow, int endRow)
+{
+    size_t bytes = (size_t)(endRow - startRow) * dst->pitch * sizeof(float);
+    if(endRow <= startRow)
+        return;
+    if(src == NULL)
+        memset(GRID_ROW(dst, startRow), 0, bytes);
+    else
+        memcpy(GRID_ROW(dst, startRow), GRID_ROW(src, startRow), bytes);
+}
+
+
+//freeGridFloat
+//PROC: Frees the grid allocation and the grid struct
+void freeGridFloat(struct gridf *g)
+{
+    if(g == NULL)
+        return;
+    free(g->data);
+    free(g);
+}
@@ -0,0 +1,55 @@
+// Contiguous grid storage shared by the shared and distributed solvers
+// Candidate Number: 11066
+
+#ifndef GRID_H
+#define GRID_H
+
+#include <stddef.h>
+
+// Byte alignment of the allocation and of the start of every row
+#define GRID_ALIGN 64
+
+//Struct holding a grid in a single aligned allocation
+// Rows are pitch doubles apart (pitch rounded up to GRID_ALIGN) and halo
+// extra rows are allocated above row 0 and below row rows-1, so rows
+// -halo .. rows+halo-1 are all addressable
+struct grid
+{
+    double *data; // Start of the allocation (first halo row)
+    int rows; // Rows in the grid, boundary rows included
+    int cols; // Columns in the grid, boundary columns included
+    int pitch; // Doubles between the starts of consecutive rows
+    int halo; // Ghost rows allocated above and below the grid
+};
+
+//Struct holding a grid of floats, laid out as struct grid with pitch in
+//floats. Single precision sweeps use it (see mixed.h)
+struct gridf
+{
+    float *data; // Start of the allocation (first halo row)
+    int rows;
+    int cols;
+    int pitch; // Floats between the starts of consecutive rows
+    int halo;
+};
+
+// Pointer to the start of row i (i may be negative inside the halo), for
+// either kind of grid
+#define GRID_ROW(g, i) ((g)->data + ((ptrdiff_t)(i) + (g)->halo) * (g)->pitch)
+
+// Element in row i and column j
+#define GRID_AT(g, i, j) (GRID_ROW(g, i)[j])
+
+struct grid *reserveGrid(int rows, int cols, int halo);
+struct grid *createGrid(int rows, int cols, int halo);
+void fillGridBorder(struct grid *g, double borderValue);
+void copyGrid(struct grid *dst, const struct grid *src);
+void copyGridRows(struct grid *dst, const struct grid *src, int startRow,
+        int endRow);
+void freeGrid(struct grid *g);
+struct gridf *reserveGridFloat(int rows, int cols, int halo);
+void copyGridFloatRows(struct gridf *dst, const struct gridf *src,
+        int startRow, int endRow);
+void freeGridFloat(struct gridf *g);
+
+#endif
@@ -0,0 +1,169 @@
+// Single precision sweeps and mixed precision refinement
+// Candidate Number: 11066
+//
+// A float is half the size of a double, so a single precision sweep moves
+// half the bytes, fits twice the rows in cache and does twice the updates
+// per vector instruction. On its own it can only reach a largest change of
+// about 1e-7 of the matrix's values (ELEMENT_FLOAT). ELEMENT_MIXED keeps
+// the matrix u in double precision and repeatedly works out its residual
+// r = (neighbours)/4 - u in double, solves for the correction e with
+// e = (neighbours of e)/4 + r in single precision, then adds e to u. The
+// correction is small, so the float rounding only ever loses digits of a
+// small number, and u converges to the double precision answer.
+
+#include <math.h>
+#include <float.h>
+#include "mixed.h"
+
+// Names accepted by --dtype, in the order of enum elementType
+static const char *elementNames[] = {"double", "float", "mixed"};
+
+
+//elementName
+//INPUT: Precision of the sweeps (dtype)
+//OUT:   Name of the precision as given to --dtype
+const char *elementName(enum elementType dtype)
+{
+    return elementNames[dtype];
+}
+
+
+//narrowRows
+//INPUT: Grids of the same shape (dst, src), rows to convert (startRow up
+//       to but not including endRow, halo rows allowed)
+//PROC:  Rounds every cell of the rows of src to single precision
+//OUT:   N/A (the rows of dst hold src's values as floats)
+void narrowRows(struct gridf *dst, const struct grid *src, int startRow,
+        int endRow)
+{
+    int a = 0;
+    int b = 0;
+    for(a = startRow; a<endRow; a++)
+    {
+        const double *in = GRID_ROW(src, a);
+        float *out = GRID_ROW(dst, a);
+        for(b = 0; b<src->cols; b++)
+            out[b] = (float)in[b];
+    }
+}
+
+
+//widenRows
+//INPUT: Grids of the same shape (dst, src), rows (startRow up to but not
+//       including endRow) and columns (startCol up to but not including
+//       endCol) to convert
+//PROC:  Copies the cells of src into dst. Only the cells swept are
+//       copied, so boundary values keep their double precision
+//OUT:   N/A (the cells of dst hold src's values)
+void widenRows(struct grid *dst, const struct gridf *src, int startRow,
+        int endRow, int startCol, int endCol)
+{
+    int a = 0;
+    int b = 0;
+    for(a = startRow; a<endRow; a++)
+    {
+        const float *in = GRID_ROW(src, a);
+        double *out = GRID_ROW(dst, a);
+        for(b = startCol; b<endCol; b++)
+            out[b] = in[b];
+    }
+}
+
+
+//residualRows
+//INPUT: Matrix (u) with current values around the cells, where to put the
+//       right hand side of the correction (rhs, same shape as u), rows
+//       (startRow up to but not including endRow) and columns (startCol up
+//       to but not including endCol) to work on, norm to work towards
+//       (norm, NORM_DELTA is taken as NORM_LINF)
+//PROC:  Works out each cell's residual r in double precision and stores
+//       4r in rhs, the term the float kernels add to the neighbour sum
+//OUT:   As bandResidual: the largest absolute residual, or for NORM_L2
+//       the sum of the squared residuals
+double residualRows(const struct grid *u, struct gridf *rhs, int startRow,
+        int endRow, int startCol, int endCol, enum convergenceNorm norm)
+{
+    double result = 0;
+    int a = 0;
+    int b = 0;
+    for(a = startRow; a<endRow; a++)
+    {
+        const double *up = GRID_ROW(u, a-1);
+        const double *mid = GRID_ROW(u, a);
+        const double *down = GRID_ROW(u, a+1);
+        float *out = GRID_ROW(rhs, a);
+        for(b = startCol; b<endCol; b++)
+        {
+            double r = (up[b] + mid[b-1] + down[b] + mid[b+1]) * 0.25
+                    - mid[b];
+            out[b] = (float)(4*r);
+            if(norm == NORM_L2)
+                result += r*r;
+            else if(fabs(r) > result)
+                result = fabs(r);
+        }
+    }
+    return result;
+}
+
+
+//addCorrection
+//INPUT: Matrix (u), correction of the same shape (e), rows (startRow up
+//       to but not including endRow) and columns (startCol up to but not
+//       including endCol) to correct
+//OUT:   N/A (u holds u + e in the given cells)
+void addCorrection(struct grid *u, const struct gridf *e, int startRow,
+        int endRow, int startCol, int endCol)
+{
+    int a = 0;
+    int b = 0;
+    for(a = startRow; a<endRow; a++)
+    {
+        const float *in = GRID_ROW(e, a);
+        double *out = GRID_ROW(u, a);
+        for(b = startCol; b<endCol; b++)
+            out[b] += in[b];
+    }
+}
+
+
+//initCorrection
+//INPUT: Test to set up (inner), test of the double precision matrix
+//       (outer, checked at least once) and the norm it was just given
+//       (norm)
+//PROC:  The first Jacobi sweep of a correction changes it by the largest
+//       residual, and the largest change of the last sweep is about the
+//       largest residual left. So the correction is swept until its
+//       largest change is within MIXED_REDUCTION of the norm, or half of
+//       what the outer test needs, whichever is larger; going further
+//       would only sweep away float rounding, or overshoot the last step
+//OUT:   N/A (inner is an absolute test of the largest change)
+void initCorrection(struct convergence *inner,
+        const struct convergence *outer, double norm)
+{
+    double target = outer->precision;
+    if(outer->relative)
+        target *= outer->reference;
+    inner->norm = NORM_DELTA;
+    inner->precision = (MIXED_REDUCTION * norm > target / 2)
+            ? MIXED_REDUCTION * norm : target / 2;
+    inner->relative = 0;
+    inner->reference = -1;
+    inner->cells = 1;
+}
+
+
+//floatFloor
+//INPUT: Over-relaxation factor of the float sweeps (omega), largest size
+//       of a value held on the boundary (largest)
+//PROC:  Each float update is rounded by up to FLT_EPSILON of the values it
+//       works with. Over-relaxing by omega carries that rounding on to the
+//       following sweeps, where it adds up to about omega / (2 - omega)
+//       times as much, and the largest change settles at around half of
+//       that instead of shrinking
+//OUT:   Smallest precision float sweeps can be relied on to reach: the
+//       level the largest change settles at, times FLOAT_MARGIN
+double floatFloor(double omega, double largest)
+{
+    return FLOAT_MARGIN * FLT_EPSILON * largest * omega / (2 * (2 - omega));
+}
@@ -0,0 +1,43 @@
+// Single precision sweeps and mixed precision refinement
+// Candidate Number: 11066
+
+#ifndef MIXED_H
+#define MIXED_H
+
+#include "grid.h"
+#include "convergence.h"
+
+// Precision the sweeps are run in
+enum elementType
+{
+    ELEMENT_DOUBLE, // Every sweep in double precision (original)
+    ELEMENT_FLOAT, // Every sweep in single precision
+    ELEMENT_MIXED // Single precision corrections to a double precision
+                  // matrix
+};
+
+// Each single precision correction is swept until its largest change
+// falls to this fraction of the residual it corrects, well above the
+// rounding error of a float
+#define MIXED_REDUCTION 1e-3
+
+// Float SOR sweeps are only asked for a precision this many times the
+// level their largest change settles at (see floatFloor). Just above that
+// level they can take thousands of sweeps; at twice it they take about as
+// many as double sweeps
+#define FLOAT_MARGIN 2
+
+const char *elementName(enum elementType dtype);
+void narrowRows(struct gridf *dst, const struct grid *src, int startRow,
+        int endRow);
+void widenRows(struct grid *dst, const struct gridf *src, int startRow,
+        int endRow, int startCol, int endCol);
+double residualRows(const struct grid *u, struct gridf *rhs, int startRow,
+        int endRow, int startCol, int endCol, enum convergenceNorm norm);
+void addCorrection(struct grid *u, const struct gridf *e, int startRow,
+        int endRow, int startCol, int endCol);
+void initCorrection(struct convergence *inner,
+        const struct convergence *outer, double norm);
+double floatFloor(double omega, double largest);
+
+#endif
@@ -0,0 +1,641 @@
+// Geometric multigrid solver using red-black sweeps as the smoother
+// Candidate Number: 11066
+//
+// Levels are vertex centred: coarse row I sits on fine row 2I. Residuals are
+// restricted by full weighting and corrections prolonged bilinearly. Every
+// interval of a level is the same width except the last, which is narrower
+// when a level with an even number of rows or columns is halved: the last
+// coarse row then sits on the last fine row, one fine interval from the
+// one before. The cells next to that interval, and the transfers across
+// it, weight their neighbours by distance, so any size coarsens. Every
+// routine only touches the rows of its own worker's band, and calls
+// ops->exchange where it needs rows written by other workers, so the same
+// cycles run on one thread, on a team of threads or across MPI ranks.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "multigrid.h"
+#include "sweep.h"
+#include "sor.h"
+
+// Coarsening stops once a level has this many rows or columns
+#define MG_SMALLEST 3
+
+// The coarsest level is swept until its largest change falls by this factor
+#define MG_COARSE_REDUCTION 1e-6
+
+
+//countLevels
+//INPUT: Size of the finest level, boundary included (rows, cols)
+//PROC:  Halves the grid until either side reaches MG_SMALLEST
+//OUT:   Number of levels in the hierarchy
+int countLevels(int rows, int cols)
+{
+    int count = 1;
+    while(rows > MG_SMALLEST && cols > MG_SMALLEST)
+    {
+        rows = MG_COARSE(rows);
+        cols = MG_COARSE(cols);
+        count++;
+    }
+    return count;
+}
+
+
+//createLevels
+//INPUT: Number of levels (count), size of the finest level (rows, cols),
+//       width of its last intervals (lastRow, lastCol, 1 for a whole grid)
+//PROC:  Allocates whole level grids, each worker's band covering every
+//       interior row. The finest u and b are left for the caller to attach
+//OUT:   Array of count levels (NULL on failure)
+struct mgLevel *createLevels(int count, int rows, int cols, double lastRow,
+        double lastCol)
+{
+    struct mgLevel *levels = calloc(count, sizeof(struct mgLevel));
+    int l = 0;
+    if(levels == NULL)
+        return NULL;
+    for(l = 0; l<count; l++)
+    {
+        levels[l].rows = rows;
+        levels[l].cols = cols;
+        levels[l].lastRow = lastRow;
+        levels[l].lastCol = lastCol;
+        levels[l].rowOffset = 0;
+        levels[l].startRow = 1;
+        levels[l].endRow = rows-1;
+        levels[l].r = createGrid(rows, cols, 0);
+        if(l > 0)
+        {
+            levels[l].u = createGrid(rows, cols, 0);
+            levels[l].b = createGrid(rows, cols, 0);
+        }
+        if(levels[l].r == NULL || (l > 0 && (levels[l].u == NULL
+                || levels[l].b == NULL)))
+        {
+            freeLevels(levels, l+1);
+            return NULL;
+        }
+        lastRow = MG_COARSE_LAST(rows, lastRow);
+        lastCol = MG_COARSE_LAST(cols, lastCol);
+        rows = MG_COARSE(rows);
+        cols = MG_COARSE(cols);
+    }
+    return levels;
+}
+
+
+//freeLevels
+//INPUT: Levels from createLevels and how many there are (levels, count)
+//PROC:  Frees every level grid apart from the finest u and b
+void freeLevels(struct mgLevel *levels, int count)
+{
+    int l = 0;
+    for(l = 0; l<count; l++)
+    {
+        freeGrid(levels[l].r);
+        if(l > 0)
+        {
+            freeGrid(levels[l].u);
+            freeGrid(levels[l].b);
+        }
+    }
+    free(levels);
+}
+
+
+//cellWeights
+//INPUT: Level (level), row and column of an interior cell (a, j), where to
+//       put the weights of the neighbours above, below, left and right (w)
+//PROC:  Weights each neighbour by the width of the interval to it, so that
+//       the update is the discrete Laplacian of uneven intervals. Every
+//       weight is 1 away from a narrower last interval
+//OUT:   Sum of the weights, 4 away from a narrower last interval
+static double cellWeights(const struct mgLevel *level, int a, int j,
+        double w[4])
+{
+    double down = (a == level->rows-2) ? level->lastRow : 1;
+    double right = (j == level->cols-2) ? level->lastCol : 1;
+    w[0] = 2 / (1 + down);
+    w[1] = 2 / ((1 + down) * down);
+    w[2] = 2 / (1 + right);
+    w[3] = 2 / ((1 + right) * right);
+    return w[0] + w[1] + w[2] + w[3];
+}
+
+
+//updateCell
+//INPUT: Level (level), row and column of an interior cell (a, j),
+//       over-relaxation factor (omega)
+//PROC:  Moves the cell of u omega times the way to its update from its
+//       distance weighted neighbours (see cellWeights)
+//OUT:   Absolute change made to the cell
+static double updateCell(struct mgLevel *level, int a, int j, double omega)
+{
+    double w[4];
+    double total = cellWeights(level, a, j, w);
+    double *mid = LEVEL_ROW(level, level->u, a);
+    double sum = w[0] * LEVEL_ROW(level, level->u, a-1)[j]
+            + w[1] * LEVEL_ROW(level, level->u, a+1)[j]
+            + w[2] * mid[j-1] + w[3] * mid[j+1];
+    if(level->b != NULL)
+        sum += LEVEL_ROW(level, level->b, a)[j];
+    double change = omega * (sum / total - mid[j]);
+    mid[j] += change;
+    return fabs(change);
+}
+
+
+//sweepRows
+//INPUT: Level to update (level), rows to update (startRow up to but not
+//       including endRow), colour to update and over-relaxation (omega)
+//PROC:  Updates the cells of one colour in the given rows of u. Cells next
+//       to a narrower last interval are updated one at a time
+//OUT:   Largest absolute change made to any cell
+static double sweepRows(struct mgLevel *level, int startRow, int endRow,
+        int colour, double omega)
+{
+    //The vectorised kernel stops short of a narrower last column
+    int width = (level->lastCol != 1) ? level->cols-1 : level->cols;
+    double maxDelta = 0;
+    int a = 0;
+    int j = 0;
+    for(a = startRow; a<endRow; a++)
+    {
+        const double *rhs = (level->b != NULL) ? LEVEL_ROW(level, level->b, a)
+                : NULL;
+        int first = COLOUR_FIRST(a, colour);
+        double rowDelta = 0;
+        if(a == level->rows-2 && level->lastRow != 1)
+        {
+            for(j = first; j<level->cols-1; j += 2)
+            {
+                double delta = updateCell(level, a, j, omega);
+                if(delta > rowDelta)
+                    rowDelta = delta;
+            }
+        }
+        else
+        {
+            rowDelta = colourRow(LEVEL_ROW(level, level->u, a-1),
+                    LEVEL_ROW(level, level->u, a),
+                    LEVEL_ROW(level, level->u, a+1), rhs, width, first, omega);
+            j = level->cols-2;
+            if(width != level->cols && (j - first) % 2 == 0)
+            {
+                double delta = updateCell(level, a, j, omega);
+                if(delta > rowDelta)
+                    rowDelta = delta;
+            }
+        }
+        if(rowDelta > maxDelta)
+            maxDelta = rowDelta;
+    }
+    return maxDelta;
+}
+
+
+//smoothLevel
+//INPUT: Level to smooth (level), worker operations (ops), sweeps to run
+//PROC:  Runs red-black Gauss-Seidel sweeps over this worker's band,
+//       exchanging edge rows after each colour
+//OUT:   N/A (u is smoothed and its halo is current)
+static void smoothLevel(struct mgLevel *level, const struct mgOps *ops,
+        int sweeps)
+{
+    int s = 0;
+    int colour = 0;
+    for(s = 0; s<sweeps; s++)
+    {
+        for(colour = COLOUR_RED; colour <= COLOUR_BLACK; colour++)
+        {
+            sweepRows(level, level->startRow, level->endRow, colour, 1);
+            ops->exchange(ops->context, level, level->u);
+        }
+    }
+}
+
+
+//residualLevel
+//INPUT: Level to measure (level)
+//PROC:  Writes r = (neighbours + b) / 4 - u over this worker's band. Next
+//       to a narrower last interval r is a quarter of the weighted
+//       neighbours plus b less the weighted u (see cellWeights), the form
+//       the restriction expects
+//OUT:   Largest absolute residual in the band
+static double residualLevel(struct mgLevel *level)
+{
+    double maxResidual = 0;
+    int a = 0;
+    int j = 0;
+    for(a = level->startRow; a<level->endRow; a++)
+    {
+        const double *up = LEVEL_ROW(level, level->u, a-1);
+        const double *mid = LEVEL_ROW(level, level->u, a);
+        const double *down = LEVEL_ROW(level, level->u, a+1);
+        const double *rhs = (level->b != NULL) ? LEVEL_ROW(level, level->b, a)
+                : NULL;
+        double *res = LEVEL_ROW(level, level->r, a);
+        for(j = 1; j<level->cols-1; j++)
+        {
+            double sum = 0;
+            if((a == level->rows-2 && level->lastRow != 1)
+                    || (j == level->cols-2 && level->lastCol != 1))
+            {
+                double w[4];
+                double total = cellWeights(level, a, j, w);
+                sum = w[0]*up[j] + w[1]*down[j] + w[2]*mid[j-1]
+                        + w[3]*mid[j+1] - total*mid[j];
+                if(rhs != NULL)
+                    sum += rhs[j];
+                res[j] = sum * 0.25;
+            }
+            else
+            {
+                sum = up[j] + mid[j-1] + down[j] + mid[j+1];
+                if(rhs != NULL)
+                    sum += rhs[j];
+                res[j] = sum * 0.25 - mid[j];
+            }
+            if(fabs(res[j]) > maxResidual)
+                maxResidual = fabs(res[j]);
+        }
+    }
+    return maxResidual;
+}
+
+
+//finePosition
+//INPUT: Rows or columns of a level (n), width of its last interval (last),
+//       one of its rows or columns (k)
+//OUT:   Distance of k from row or column 0, in the level's spacing
+static double finePosition(int n, double last, int k)
+{
+    return (k < n-1) ? k : n-2 + last;
+}
+
+
+//transferWeights
+//INPUT: Rows or columns of the fine level (n), width of its last interval
+//       (last), interior coarse row or column (I), where to put the
+//       weights (w)
+//PROC:  Works out the full weighting of fine rows 2I-1, 2I and 2I+1 onto
+//       coarse row I: each fine row's share of the bilinear interpolation
+//       from I, times the width it stands for over the width I stands for.
+//       Away from a narrower last interval this is 1/4, 1/2, 1/4
+//OUT:   N/A (w holds the three weights)
+static void transferWeights(int n, double last, int I, double w[3])
+{
+    int i = 2*I;
+    int next = MG_FINE(I+1, n);
+    double left = finePosition(n, last, i) - finePosition(n, last, i-2);
+    double right = finePosition(n, last, next) - finePosition(n, last, i);
+    double width = (left + right) / 2;
+    w[0] = 0.5 * (left / 2) / width;
+    w[1] = ((finePosition(n, last, i+1) - finePosition(n, last, i-1)) / 2)
+            / width;
+    //With an even number of fine rows, row 2I+1 is the coarse boundary
+    w[2] = 0;
+    if(i+1 < next)
+        w[2] = ((finePosition(n, last, next) - finePosition(n, last, i+1))
+                / right) * ((finePosition(n, last, next)
+                - finePosition(n, last, i)) / 2) / width;
+}
+
+
+//restrictLevel
+//INPUT: Fine level and the grid to restrict from it (fine, from, NULL for
+//       zero), coarse level and the grid to write (coarse, to), factor
+//       applied to the full weighting average (scale)
+//PROC:  Full weighting of from onto this worker's band of to. A residual
+//       in update units becomes a coarse right hand side with scale 16, a
+//       fine right hand side with scale 4. Coarse cells next to a narrower
+//       last interval use the weights of transferWeights
+//OUT:   N/A (interior cells of the band of to are written)
+static void restrictLevel(struct mgLevel *fine, struct grid *from,
+        struct mgLevel *coarse, struct grid *to, double scale)
+{
+    int I = 0;
+    int J = 0;
+    int d = 0;
+    int e = 0;
+    double weight = scale / 16;
+    double rowWeights[3];
+    double colWeights[3];
+    double lastWeights[3];
+    int even = 0;
+    int evenCols = coarse->cols-1;
+    transferWeights(fine->cols, fine->lastCol, coarse->cols-2, lastWeights);
+    if(lastWeights[0] != 0.25 || lastWeights[1] != 0.5
+            || lastWeights[2] != 0.25)
+        evenCols = coarse->cols-2;
+    for(I = coarse->startRow; I<coarse->endRow; I++)
+    {
+        double *out = LEVEL_ROW(coarse, to, I);
+        if(from == NULL)
+        {
+            memset(out, 0, coarse->cols * sizeof(double));
+            continue;
+        }
+        int i = MG_FINE(I, fine->rows);
+        const double *up = LEVEL_ROW(fine, from, i-1);
+        const double *mid = LEVEL_ROW(fine, from, i);
+        const double *down = LEVEL_ROW(fine, from, i+1);
+        transferWeights(fine->rows, fine->lastRow, I, rowWeights);
+        even = (rowWeights[0] == 0.25 && rowWeights[1] == 0.5
+                && rowWeights[2] == 0.25);
+        for(J = 1; even && J<evenCols; J++)
+        {
+            int j = 2*J;
+            out[J] = weight * (4*mid[j]
+                    + 2*(up[j] + down[j] + mid[j-1] + mid[j+1])
+                    + up[j-1] + up[j+1] + down[j-1] + down[j+1]);
+        }
+        //Cells next to a narrower interval, weighted term by term
+        for(J = even ? evenCols : 1; J<coarse->cols-1; J++)
+        {
+            int j = 2*J;
+            const double *rows[3] = {up, mid, down};
+            const double *cw = lastWeights;
+            double sum = 0;
+            if(J != coarse->cols-2)
+            {
+                transferWeights(fine->cols, fine->lastCol, J, colWeights);
+                cw = colWeights;
+            }
+            for(d = 0; d<3; d++)
+                for(e = 0; e<3; e++)
+                    sum += rowWeights[d] * cw[e] * rows[d][j-1+e];
+            out[J] = scale * sum;
+        }
+    }
+}
+
+
+//prolongLevel
+//INPUT: Coarse level (coarse), fine level (fine), non zero to add the
+//       interpolated values to the fine u rather than replace it (add)
+//PROC:  Bilinear interpolation of the coarse u onto the interior of this
+//       worker's band of the fine u. The fine row or column just inside a
+//       narrower last interval is weighted by its distance to either
+//       coarse one
+//OUT:   N/A (fine u is corrected or replaced)
+static void prolongLevel(struct mgLevel *coarse, struct mgLevel *fine,
+        int add)
+{
+    int i = 0;
+    int j = 0;
+    //Only a fine level with an odd number of rows has a row between the
+    //last two coarse rows, its last interval away from the one before
+    double rowNear = (fine->rows % 2) ? fine->lastRow / (1 + fine->lastRow)
+            : 0.5;
+    double colNear = (fine->cols % 2) ? fine->lastCol / (1 + fine->lastCol)
+            : 0.5;
+    int evenCols = (colNear == 0.5) ? fine->cols-1 : fine->cols-2;
+    for(i = fine->startRow; i<fine->endRow; i++)
+    {
+        //Odd rows and columns sit halfway between two coarse ones
+        const double *near = LEVEL_ROW(coarse, coarse->u, i/2);
+        const double *far = LEVEL_ROW(coarse, coarse->u, (i+1)/2);
+        double *out = LEVEL_ROW(fine, fine->u, i);
+        double wNear = (i == fine->rows-2) ? rowNear : 0.5;
+        int last = (wNear == 0.5) ? evenCols : 1;
+        for(j = 1; j<last; j++)
+        {
+            int J0 = j/2;
+            int J1 = (j+1)/2;
+            double value = 0.25 * (near[J0] + near[J1] + far[J0] + far[J1]);
+            out[j] = add ? out[j] + value : value;
+        }
+        for(j = last; j<fine->cols-1; j++)
+        {
+            int J0 = j/2;
+            int J1 = (j+1)/2;
+            double cNear = (j == fine->cols-2) ? colNear : 0.5;
+            double value = wNear * (cNear * near[J0] + (1-cNear) * near[J1])
+                    + (1-wNear) * (cNear * far[J0] + (1-cNear) * far[J1]);
+            out[j] = add ? out[j] + value : value;
+        }
+    }
+}
+
+
+//zeroLevel
+//INPUT: Level (level) and one of its grids to clear (g)
+//PROC:  Zeroes this worker's band rows, plus the boundary rows next to it
+//OUT:   N/A (the band of g is zero)
+static void zeroLevel(struct mgLevel *level, struct grid *g)
+{
+    int first = level->startRow;
+    int last = level->endRow;
+    int a = 0;
+    if(first == last)
+        return;
+    if(first == 1)
+        first = 0;
+    if(last == level->rows-1)
+        last = level->rows;
+    for(a = first; a<last; a++)
+        memset(LEVEL_ROW(level, g, a), 0, level->cols * sizeof(double));
+}
+
+
+//injectBoundary
+//INPUT: Fine and coarse levels (fine, coarse)
+//PROC:  Copies the fine u boundary values sitting under the coarse
+//       boundary onto the coarse u, for this worker's band
+//OUT:   N/A (the coarse u has the fine problem's boundary)
+static void injectBoundary(struct mgLevel *fine, struct mgLevel *coarse)
+{
+    int I = 0;
+    int J = 0;
+    int last = coarse->cols-1;
+    if(coarse->startRow == coarse->endRow)
+        return;
+    for(I = coarse->startRow; I<coarse->endRow; I++)
+    {
+        const double *from = LEVEL_ROW(fine, fine->u, MG_FINE(I, fine->rows));
+        double *to = LEVEL_ROW(coarse, coarse->u, I);
+        to[0] = from[0];
+        to[last] = from[fine->cols-1];
+    }
+    //Whole boundary rows go with the first and last bands
+    if(coarse->startRow == 1)
+    {
+        const double *from = LEVEL_ROW(fine, fine->u, 0);
+        double *to = LEVEL_ROW(coarse, coarse->u, 0);
+        for(J = 0; J<coarse->cols; J++)
+            to[J] = from[MG_FINE(J, fine->cols)];
+    }
+    if(coarse->endRow == coarse->rows-1)
+    {
+        const double *from = LEVEL_ROW(fine, fine->u, fine->rows-1);
+        double *to = LEVEL_ROW(coarse, coarse->u, coarse->rows-1);
+        for(J = 0; J<coarse->cols; J++)
+            to[J] = from[MG_FINE(J, fine->cols)];
+    }
+}
+
+
+//coarsestSolve
+//INPUT: Coarsest level (level), worker operations (ops)
+//PROC:  The lead worker runs SOR sweeps with the optimal omega over the
+//       whole level until the largest change has fallen far enough
+//OUT:   N/A (u holds the coarsest solution on every worker)
+static void coarsestSolve(struct mgLevel *level, const struct mgOps *ops)
+{
+    if(ops->lead)
+    {
+        double omega = optimalOmega(level->rows, level->cols);
+        double firstDelta = -1;
+        double maxDelta = 0;
+        int sweeps = 0;
+        int limit = 10 * (level->rows + level->cols);
+        do
+        {
+            maxDelta = sweepRows(level, 1, level->rows-1, COLOUR_RED, omega);
+            double blackDelta = sweepRows(level, 1, level->rows-1,
+                    COLOUR_BLACK, omega);
+            if(blackDelta > maxDelta)
+                maxDelta = blackDelta;
+            if(firstDelta < 0)
+                firstDelta = maxDelta;
+            sweeps++;
+        }while(maxDelta > MG_COARSE_REDUCTION * firstDelta && sweeps < limit);
+    }
+    ops->exchange(ops->context, level, level->u);
+}
+
+
+//vCycle
+//INPUT: Hierarchy (levels, count), level to cycle on (level), worker
+//       operations (ops). The halo of the level's u must be current
+//PROC:  Smooths, corrects from the level below (recursively) and smooths
+//OUT:   N/A (u on the level is improved and its halo is current)
+void vCycle(struct mgLevel *levels, int count, int level,
+        const struct mgOps *ops)
+{
+    struct mgLevel *fine = &levels[level];
+    if(level == ops->agglomerateLevel)
+    {
+        ops->agglomerate(ops->context, levels, level, MG_VCYCLE);
+        ops->exchange(ops->context, fine, fine->u);
+        return;
+    }
+    if(level == count-1)
+    {
+        coarsestSolve(fine, ops);
+        return;
+    }
+    struct mgLevel *coarse = &levels[level+1];
+
+    smoothLevel(fine, ops, MG_PRE_SWEEPS);
+    residualLevel(fine);
+    ops->exchange(ops->context, fine, fine->r);
+    restrictLevel(fine, fine->r, coarse, coarse->b, 16);
+    zeroLevel(coarse, coarse->u);
+    ops->exchange(ops->context, coarse, coarse->u);
+
+    vCycle(levels, count, level+1, ops);
+
+    ops->exchange(ops->context, coarse, coarse->u);
+    prolongLevel(coarse, fine, 1);
+    ops->exchange(ops->context, fine, fine->u);
+    smoothLevel(fine, ops, MG_POST_SWEEPS);
+}
+
+
+//fullMultigrid
+//INPUT: As vCycle
+//PROC:  Solves the same problem on the level below (recursively), takes
+//       its interpolated solution as the starting guess, then runs one
+//       V-cycle. The interior of u is overwritten
+//OUT:   N/A (u on the level is solved to about discretisation accuracy)
+void fullMultigrid(struct mgLevel *levels, int count, int level,
+        const struct mgOps *ops)
+{
+    struct mgLevel *fine = &levels[level];
+    if(level == ops->agglomerateLevel)
+    {
+        ops->agglomerate(ops->context, levels, level, MG_FMG);
+        ops->exchange(ops->context, fine, fine->u);
+        return;
+    }
+    if(level == count-1)
+    {
+        coarsestSolve(fine, ops);
+        return;
+    }
+    struct mgLevel *coarse = &levels[level+1];
+
+    if(fine->b != NULL)
+        ops->exchange(ops->context, fine, fine->b);
+    restrictLevel(fine, fine->b, coarse, coarse->b, 4);
+    zeroLevel(coarse, coarse->u);
+    injectBoundary(fine, coarse);
+    ops->exchange(ops->context, coarse, coarse->u);
+
+    fullMultigrid(levels, count, level+1, ops);
+
+    ops->exchange(ops->context, coarse, coarse->u);
+    prolongLevel(coarse, fine, 0);
+    ops->exchange(ops->context, fine, fine->u);
+    vCycle(levels, count, level, ops);
+}
+
+
+//fineNorm
+//INPUT: Finest level (fine), worker operations (ops), test (test)
+//PROC:  Works out the residual of every worker's band and reduces it
+//OUT:   Residual norm of the whole finest level. A cycle changes every
+//       cell, so NORM_DELTA is measured as NORM_LINF
+static double fineNorm(struct mgLevel *fine, const struct mgOps *ops,
+        const struct convergence *test)
+{
+    double largest = residualLevel(fine);
+    double sum = 0;
+    int a = 0;
+    int j = 0;
+    if(test->norm != NORM_L2)
+        return ops->reduceMax(ops->context, largest);
+    for(a = fine->startRow; a<fine->endRow; a++)
+    {
+        const double *res = LEVEL_ROW(fine, fine->r, a);
+        for(j = 1; j<fine->cols-1; j++)
+            sum += res[j]*res[j];
+    }
+    return finishNorm(test, ops->reduceSum(ops->context, sum));
+}
+
+
+//solveMultigrid
+//INPUT: Hierarchy (levels, count), worker operations (ops), cycle
+//       schedule (schedule), residual norm to accept (test), cycles
+//       allowed (maxCycles, 0 for no limit), where to put the final
+//       residual norm (residual)
+//PROC:  Runs full multigrid if asked, then V-cycles until the residual
+//       norm on the finest level passes the test
+//OUT:   Number of cycles run (full multigrid counts as one)
+int solveMultigrid(struct mgLevel *levels, int count,
+        const struct mgOps *ops, enum mgSchedule schedule,
+        struct convergence *test, int maxCycles, double *residual)
+{
+    int cycles = 0;
+    ops->exchange(ops->context, &levels[0], levels[0].u);
+    if(schedule == MG_FMG)
+    {
+        fullMultigrid(levels, count, 0, ops);
+        cycles++;
+    }
+    *residual = fineNorm(&levels[0], ops, test);
+    while(!hasConverged(test, *residual)
+            && (maxCycles == 0 || cycles < maxCycles))
+    {
+        vCycle(levels, count, 0, ops);
+        cycles++;
+        *residual = fineNorm(&levels[0], ops, test);
+    }
+    return cycles;
+}
@@ -0,0 +1,90 @@
+// Geometric multigrid solver using red-black sweeps as the smoother
+// Candidate Number: 11066
+
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+#include "grid.h"
+#include "convergence.h"
+
+// Red-black sweeps before and after each coarse grid correction
+#define MG_PRE_SWEEPS 2
+#define MG_POST_SWEEPS 2
+
+// Rows or columns of the level below a level with n of them. The last
+// coarse interval is one fine interval wide when n-1 is odd
+#define MG_COARSE(n) ((n)/2 + 1)
+
+// Width of the last coarse interval, as a fraction of the coarse spacing,
+// below a level with n rows or columns whose last interval is last of its
+// own spacing. Every other interval of a level is one spacing wide
+#define MG_COARSE_LAST(n, last) (((n) % 2) ? (1 + (last)) / 2 : (last) / 2)
+
+// Fine row or column under coarse row or column I, fine level of size n
+#define MG_FINE(I, n) (2*(I) < (n)-1 ? 2*(I) : (n)-1)
+
+// Cycle run on each level
+enum mgSchedule
+{
+    MG_VCYCLE, // V-cycles on the finest level from the initial guess
+    MG_FMG // Full multigrid from the coarsest level, then V-cycles
+};
+
+//Struct holding one level of the hierarchy as seen by one worker
+// Every equation is scaled so a Jacobi update is u = (neighbours + b) / 4,
+// and residuals are stored in the same units as that update. Cells next to
+// a narrower last interval weight their neighbours by distance instead
+// (see cellWeights), and store a quarter of their scaled residual
+struct mgLevel
+{
+    struct grid *u; // Solution on the finest level, correction below it
+    struct grid *b; // Right hand side, NULL for zero
+    struct grid *r; // Residual of u
+    int rows; // Rows in the whole level, boundary included
+    int cols; // Columns in the whole level, boundary included
+    double lastRow; // Width of the last interval between rows, as a
+                    // fraction of the level's spacing (see MG_COARSE_LAST)
+    double lastCol; // The same between columns
+    int rowOffset; // Row of the whole level held in row 0 of u, b and r
+    int startRow; // First row updated by this worker
+    int endRow; // One past the last row updated by this worker
+};
+
+// Row i of the whole level, held in grid g of the level
+#define LEVEL_ROW(level, g, i) GRID_ROW(g, (i) - (level)->rowOffset)
+
+//Struct of the operations that differ between threads and MPI ranks
+struct mgOps
+{
+    void *context; // Passed back into every operation
+    // Makes the rows either side of this worker's band of grid g current,
+    // once every worker has finished writing its own band
+    void (*exchange)(void *context, struct mgLevel *level, struct grid *g);
+    // Largest value passed in by any worker
+    double (*reduceMax)(void *context, double value);
+    // Sum of the values passed in by every worker
+    double (*reduceSum)(void *context, double value);
+    // Non zero on the one worker that solves the coarsest level
+    int lead;
+    // Level handed to agglomerate instead of being cycled here (or the
+    // number of levels if every level is cycled here)
+    int agglomerateLevel;
+    // Gathers the given level onto fewer workers, runs the schedule on it
+    // and its coarser levels there, and hands the solution back
+    void (*agglomerate)(void *context, struct mgLevel *levels, int level,
+            enum mgSchedule schedule);
+};
+
+int countLevels(int rows, int cols);
+struct mgLevel *createLevels(int count, int rows, int cols, double lastRow,
+        double lastCol);
+void freeLevels(struct mgLevel *levels, int count);
+int solveMultigrid(struct mgLevel *levels, int count,
+        const struct mgOps *ops, enum mgSchedule schedule,
+        struct convergence *test, int maxCycles, double *residual);
+void vCycle(struct mgLevel *levels, int count, int level,
+        const struct mgOps *ops);
+void fullMultigrid(struct mgLevel *levels, int count, int level,
+        const struct mgOps *ops);
+
+#endif
@@ -0,0 +1,729 @@
+// Solver parameters read from the command line and configuration files
+// Candidate Number: 11066
+//
+// Every option has a long name, and a configuration file sets the same
+// options with lines of the form "name = value" ("#" starts a comment).
+// Options are applied in the order given, so anything on the command line
+// after --config overrides the file.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include "options.h"
+#include "sor.h"
+#include "trace.h"
+#include "output.h"
+#include "stencil.h"
+
+// Names accepted by --method, in the order of enum sweepMethod
+static const char *methodNames[] = {"gauss-seidel", "jacobi", "red-black",
+        "sor", "vcycle", "fmg", "wavefront"};
+
+// Configuration files may name further files, up to this depth
+#define CONFIG_DEPTH 8
+
+// Options with no short form are given values past the last character
+enum
+{
+    OPT_ROWS = 256, OPT_COLS, OPT_OMEGA, OPT_BLOCK_SWEEPS, OPT_MAX_ITERATIONS,
+    OPT_CHECK_INTERVAL, OPT_BORDER, OPT_AFFINITY, OPT_PROCESS_GRID,
+    OPT_FORMAT, OPT_CONFIG, OPT_TRIALS, OPT_WARMUP, OPT_REPORT,
+    OPT_REPORT_FORMAT, OPT_TRACE, OPT_NORM, OPT_TOLERANCE, OPT_DTYPE,
+    OPT_CHECKPOINT, OPT_CHECKPOINT_INTERVAL, OPT_RESTART, OPT_INITIAL,
+    OPT_SCHEDULE, OPT_TOP, OPT_BOTTOM, OPT_LEFT, OPT_RIGHT, OPT_SOURCE,
+    OPT_OBSTACLE, OPT_BATCH
+};
+
+static const struct option longOptions[] =
+{
+    {"size", required_argument, NULL, 's'},
+    {"rows", required_argument, NULL, OPT_ROWS},
+    {"cols", required_argument, NULL, OPT_COLS},
+    {"precision", required_argument, NULL, 'p'},
+    {"threads", required_argument, NULL, 't'},
+    {"method", required_argument, NULL, 'm'},
+    {"omega", required_argument, NULL, OPT_OMEGA},
+    {"block-sweeps", required_argument, NULL, OPT_BLOCK_SWEEPS},
+    {"schedule", required_argument, NULL, OPT_SCHEDULE},
+    {"max-iterations", required_argument, NULL, OPT_MAX_ITERATIONS},
+    {"check-interval", required_argument, NULL, OPT_CHECK_INTERVAL},
+    {"norm", required_argument, NULL, OPT_NORM},
+    {"tolerance", required_argument, NULL, OPT_TOLERANCE},
+    {"dtype", required_argument, NULL, OPT_DTYPE},
+    {"border", required_argument, NULL, OPT_BORDER},
+    {"top", required_argument, NULL, OPT_TOP},
+    {"bottom", required_argument, NULL, OPT_BOTTOM},
+    {"left", required_argument, NULL, OPT_LEFT},
+    {"right", required_argument, NULL, OPT_RIGHT},
+    {"source", required_argument, NULL, OPT_SOURCE},
+    {"obstacle", required_argument, NULL, OPT_OBSTACLE},
+    {"affinity", required_argument, NULL, OPT_AFFINITY},
+    {"process-grid", required_argument, NULL, OPT_PROCESS_GRID},
+    {"format", required_argument, NULL, OPT_FORMAT},
+    {"output", required_argument, NULL, 'o'},
+    {"trials", required_argument, NULL, OPT_TRIALS},
+    {"warmup", required_argument, NULL, OPT_WARMUP},
+    {"batch", required_argument, NULL, OPT_BATCH},
+    {"report", required_argument, NULL, OPT_REPORT},
+    {"report-format", required_argument, NULL, OPT_REPORT_FORMAT},
+    {"trace", required_argument, NULL, OPT_TRACE},
+    {"checkpoint", required_argument, NULL, OPT_CHECKPOINT},
+    {"checkpoint-interval", required_argument, NULL,
+            OPT_CHECKPOINT_INTERVAL},
+    {"restart", required_argument, NULL, OPT_RESTART},
+    {"initial", required_argument, NULL, OPT_INITIAL},
+    {"config", required_argument, NULL, OPT_CONFIG},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+};
+
+
+//initOptions
+//INPUT: Options to fill in (opts)
+//PROC:  Sets every option to a default; each solver's main then sets its
+//       own defaults before reading the command line
+//OUT:   N/A (opts holds the defaults)
+void initOptions(struct options *opts)
+{
+    int i = 0;
+    opts->rows = 100;
+    opts->cols = 100;
+    opts->precision = 0.001;
+    opts->threads = 1;
+    opts->method = METHOD_SOR;
+    opts->omega = OMEGA_OPTIMAL;
+    opts->blockSweeps = 8;
+    opts->schedule = SCHEDULE_TILES;
+    opts->maxIterations = 100000;
+    opts->checkInterval = 1;
+    opts->norm = NORM_DELTA;
+    opts->relative = 0;
+    opts->dtype = ELEMENT_DOUBLE;
+    opts->borderValue = 10;
+    for(i = 0; i < EDGES; i++)
+    {
+        opts->edges[i].kind = EDGE_BORDER;
+        opts->edges[i].value = 0;
+    }
+    opts->source = 0;
+    opts->obstacleCount = 0;
+    opts->affinity[0] = '\0';
+    opts->dims[0] = 0;
+    opts->dims[1] = 0;
+    opts->format = OUTPUT_NONE;
+    opts->outputFile[0] = '\0';
+    opts->trials = 1;
+    opts->warmup = 0;
+    opts->batch = 0;
+    opts->report[0] = '\0';
+    opts->reportFormat = REPORT_CSV;
+    opts->trace[0] = '\0';
+    opts->checkpoint[0] = '\0';
+    opts->checkpointInterval = 1000;
+    opts->restart[0] = '\0';
+    opts->initial[0] = '\0';
+}
+
+
+//methodName
+//INPUT: Update ordering (method)
+//OUT:   Name of the method as given to --method
+const char *methodName(enum sweepMethod method)
+{
+    return methodNames[method];
+}
+
+
+//checkDue
+//INPUT: sweeps completed (iterations), sweeps between convergence checks
+//       (checkInterval), sweeps allowed (maxIterations, 0 for no limit)
+//OUT:   Non zero if convergence is checked after this sweep: every
+//       checkInterval sweeps, and always after the last sweep allowed
+int checkDue(int iterations, int checkInterval, int maxIterations)
+{
+    return iterations % checkInterval == 0 || iterations == maxIterations;
+}
+
+
+//underLimit
+//INPUT: sweeps (or cycles) completed (iterations), number allowed
+//       (maxIterations, 0 for no limit)
+//OUT:   Non zero if another sweep is allowed
+int underLimit(int iterations, int maxIterations)
+{
+    return maxIterations == 0 || iterations < maxIterations;
+}
+
+
+//readInt
+//INPUT: Text of the value (value), smallest value allowed (least)
+//       where to put it (result)
+//OUT:   0 if value is a whole number of at least least (-1 otherwise)
+static int readInt(const char *value, int least, int *result)
+{
+    char *end = NULL;
+    long number = strtol(value, &end, 10);
+    if(end == value || *end != '\0' || number < least || number > 1000000000)
+        return -1;
+    *result = (int)number;
+    return 0;
+}
+
+
+//readDouble
+//INPUT: Text of the value (value), where to put it (result)
+//OUT:   0 if value is a number (-1 otherwise)
+static int readDouble(const char *value, double *result)
+{
+    char *end = NULL;
+    double number = strtod(value, &end);
+    if(end == value || *end != '\0')
+        return -1;
+    *result = number;
+    return 0;
+}
+
+
+//readString
+//INPUT: Text of the value (value), where to copy it (result, with room for
+//       OPTIONS_STRING characters)
+//OUT:   0 if value fits (-1 otherwise)
+static int readString(const char *value, char *result)
+{
+    if(strlen(value) >= OPTIONS_STRING)
+        return -1;
+    strcpy(result, value);
+    return 0;
+}
+
+
+//readEdge
+//INPUT: Text of the value (value), where to put it (result)
+//OUT:   0 if value is a number to hold the edge at, or neumann for no flux
+//       across it, or neumann:G for an outward gradient of G (-1 otherwise)
+static int readEdge(const char *value, struct edge *result)
+{
+    if(strcmp(value, "neumann") == 0)
+    {
+        result->kind = EDGE_NEUMANN;
+        result->value = 0;
+        return 0;
+    }
+    if(strncmp(value, "neumann:", 8) == 0)
+    {
+        result->kind = EDGE_NEUMANN;
+        return readDouble(value + 8, &result->value);
+    }
+    result->kind = EDGE_DIRICHLET;
+    return readDouble(value, &result->value);
+}
+
+
+//readObstacle
+//INPUT: Text of the value (value), options to add it to (opts)
+//OUT:   0 if value has the form R0:R1,C0:C1=V, holding rows R0 to R1 and
+//       columns C0 to C1 (both ends included) at V, and there is room for
+//       it (-1 otherwise)
+static int readObstacle(const char *value, struct options *opts)
+{
+    struct obstacle *o = &opts->obstacles[opts->obstacleCount];
+    int used = 0;
+    if(opts->obstacleCount >= OPTIONS_OBSTACLES
+            || sscanf(value, "%d:%d,%d:%d=%lf%n", &o->startRow, &o->endRow,
+            &o->startCol, &o->endCol, &o->value, &used) != 5
+            || value[used] != '\0' || o->startRow > o->endRow
+            || o->startCol > o->endCol)
+        return -1;
+    o->endRow++;
+    o->endCol++;
+    opts->obstacleCount++;
+    return 0;
+}
+
+
+//setOption
+//INPUT: Options to change (opts), option's short form or OPT_ value (key)
+//       text of its value (value), whether to print errors (report)
+//PROC:  Checks the value and stores it; --config reads the named file
+//OUT:   0 on success (OPTIONS_ERROR if the value is invalid)
+static int setOption(struct options *opts, int key, const char *value,
+        int report)
+{
+    int result = 0;
+    int i = 0;
+    switch(key)
+    {
+        case 's':
+            result = readInt(value, 3, &opts->rows);
+            opts->cols = opts->rows;
+            break;
+        case OPT_ROWS:
+            result = readInt(value, 3, &opts->rows);
+            break;
+        case OPT_COLS:
+            result = readInt(value, 3, &opts->cols);
+            break;
+        case 'p':
+            result = readDouble(value, &opts->precision);
+            if(result == 0 && opts->precision <= 0)
+                result = -1;
+            break;
+        case 't':
+            result = readInt(value, 1, &opts->threads);
+            break;
+        case 'm':
+            result = -1;
+            for(i = 0; i < (int)(sizeof(methodNames) / sizeof(char*)); i++)
+            {
+                if(strcmp(value, methodNames[i]) == 0)
+                {
+                    opts->method = (enum sweepMethod)i;
+                    result = 0;
+                }
+            }
+            break;
+        case OPT_OMEGA:
+            if(strcmp(value, "optimal") == 0)
+                opts->omega = OMEGA_OPTIMAL;
+            else if(strcmp(value, "adaptive") == 0)
+                opts->omega = OMEGA_ADAPTIVE;
+            else if(readDouble(value, &opts->omega) != 0 || opts->omega <= 0
+                    || opts->omega >= 2)
+                result = -1;
+            break;
+        case OPT_BLOCK_SWEEPS:
+            result = readInt(value, 1, &opts->blockSweeps);
+            break;
+        case OPT_MAX_ITERATIONS:
+            result = readInt(value, 0, &opts->maxIterations);
+            break;
+        case OPT_CHECK_INTERVAL:
+            result = readInt(value, 1, &opts->checkInterval);
+            break;
+        case OPT_BORDER:
+            result = readDouble(value, &opts->borderValue);
+            //Every edge goes back to the border value
+            for(i = 0; result == 0 && i < EDGES; i++)
+                opts->edges[i].kind = EDGE_BORDER;
+            break;
+        case OPT_TOP:
+        case OPT_BOTTOM:
+        case OPT_LEFT:
+        case OPT_RIGHT:
+            result = readEdge(value, &opts->edges[EDGE_TOP + key - OPT_TOP]);
+            break;
+        case OPT_SOURCE:
+            result = readDouble(value, &opts->source);
+            break;
+        case OPT_OBSTACLE:
+            result = readObstacle(value, opts);
+            break;
+        case OPT_AFFINITY:
+            result = readString(value, opts->affinity);
+            break;
+        case OPT_PROCESS_GRID:
+            if(sscanf(value, "%dx%d%n", &opts->dims[0], &opts->dims[1], &i)
+                    != 2 || value[i] != '\0' || opts->dims[0] < 0
+                    || opts->dims[1] < 0)
+                result = -1;
+            break;
+        case OPT_SCHEDULE:
+            if(strcmp(value, "bands") == 0)
+                opts->schedule = SCHEDULE_BANDS;
+            else if(strcmp(value, "tiles") == 0)
+                opts->schedule = SCHEDULE_TILES;
+            else if(strcmp(value, "neighbours") == 0)
+                opts->schedule = SCHEDULE_NEIGHBOURS;
+            else
+                result = -1;
+            break;
+        case OPT_FORMAT:
+            if(strcmp(value, "none") == 0)
+                opts->format = OUTPUT_NONE;
+            else if(strcmp(value, "text") == 0)
+                opts->format = OUTPUT_TEXT;
+            else if(strcmp(value, "binary") == 0)
+                opts->format = OUTPUT_BINARY;
+            else if(strcmp(value, "compressed") == 0)
+                opts->format = OUTPUT_COMPRESSED;
+            else
+                result = -1;
+            break;
+        case OPT_NORM:
+            result = -1;
+            for(i = NORM_DELTA; i <= NORM_L2; i++)
+            {
+                if(strcmp(value, normName((enum convergenceNorm)i)) == 0)
+                {
+                    opts->norm = (enum convergenceNorm)i;
+                    result = 0;
+                }
+            }
+            break;
+        case OPT_TOLERANCE:
+            if(strcmp(value, "absolute") == 0)
+                opts->relative = 0;
+            else if(strcmp(value, "relative") == 0)
+                opts->relative = 1;
+            else
+                result = -1;
+            break;
+        case OPT_DTYPE:
+            result = -1;
+            for(i = ELEMENT_DOUBLE; i <= ELEMENT_MIXED; i++)
+            {
+                if(strcmp(value, elementName((enum elementType)i)) == 0)
+                {
+                    opts->dtype = (enum elementType)i;
+                    result = 0;
+                }
+            }
+            break;
+        case 'o':
+            result = readString(value, opts->outputFile);
+            break;
+        case OPT_TRIALS:
+            result = readInt(value, 1, &opts->trials);
+            break;
+        case OPT_WARMUP:
+            result = readInt(value, 0, &opts->warmup);
+            break;
+        case OPT_BATCH:
+            result = readInt(value, 0, &opts->batch);
+            break;
+        case OPT_REPORT:
+            result = readString(value, opts->report);
+            break;
+        case OPT_REPORT_FORMAT:
+            if(strcmp(value, "csv") == 0)
+                opts->reportFormat = REPORT_CSV;
+            else if(strcmp(value, "json") == 0)
+                opts->reportFormat = REPORT_JSON;
+            else
+                result = -1;
+            break;
+        case OPT_TRACE:
+            result = readString(value, opts->trace);
+            break;
+        case OPT_CHECKPOINT:
+            //Leaves room for the temporary name's suffix
+            result = (strlen(value) + 4 < OPTIONS_STRING)
+                    ? readString(value, opts->checkpoint) : -1;
+            break;
+        case OPT_CHECKPOINT_INTERVAL:
+            result = readInt(value, 1, &opts->checkpointInterval);
+            break;
+        case OPT_RESTART:
+            result = readString(value, opts->restart);
+            break;
+        case OPT_INITIAL:
+            result = readString(value, opts->initial);
+            break;
+        case OPT_CONFIG:
+            return readConfig(opts, value, report);
+        default:
+            result = -1;
+    }
+    if(result != 0)
+    {
+        for(i = 0; longOptions[i].name != NULL; i++)
+            if(longOptions[i].val == key && report)
+                printf("Invalid value for %s: %s\n", longOptions[i].name,
+                        value);
+        return OPTIONS_ERROR;
+    }
+    return 0;
+}
+
+
+//largestBoundary
+//INPUT: Options holding the edge conditions (opts)
+//OUT:   Largest size of a value held on an edge of the matrix
+static double largestBoundary(const struct options *opts)
+{
+    double largest = fabs(opts->borderValue);
+    int i = 0;
+    for(i = 0; i<EDGES; i++)
+        if(opts->edges[i].kind == EDGE_DIRICHLET
+                && fabs(opts->edges[i].value) > largest)
+            largest = fabs(opts->edges[i].value);
+    return largest;
+}
+
+
+//readConfig
+//INPUT: Options to change (opts), configuration file (fileName), whether
+//       to print errors (report)
+//PROC:  Applies each "name = value" line of the file in turn, skipping
+//       blank lines and anything after a "#"
+//OUT:   0 on success (OPTIONS_ERROR if the file or an option is invalid)
+int readConfig(struct options *opts, const char *fileName, int report)
+{
+    static int depth = 0; // Files being read, to stop a file naming itself
+    char line[OPTIONS_STRING + 64];
+    int lineNumber = 0;
+    int i = 0;
+    int result = 0;
+    FILE *file = NULL;
+    if(depth >= CONFIG_DEPTH)
+    {
+        if(report)
+            printf("Configuration files nested too deeply at %s\n", fileName);
+        return OPTIONS_ERROR;
+    }
+    file = fopen(fileName, "r");
+    if(file == NULL)
+    {
+        if(report)
+            printf("Unable to open configuration file %s\n", fileName);
+        return OPTIONS_ERROR;
+    }
+    while(fgets(line, sizeof(line), file) != NULL)
+    {
+        char name[64];
+        char value[OPTIONS_STRING];
+        char *comment = strchr(line, '#');
+        lineNumber++;
+        if(comment != NULL)
+            *comment = '\0';
+        if(sscanf(line, " %63[^= \t\r\n] = %1023[^\r\n]", name, value) != 2)
+        {
+            //Lines holding only spaces are allowed
+            if(strspn(line, " \t\r\n") == strlen(line))
+                continue;
+            if(report)
+                printf("%s:%d: expected name = value\n", fileName,
+                        lineNumber);
+            fclose(file);
+            return OPTIONS_ERROR;
+        }
+        //Trailing spaces are not part of the value
+        for(i = strlen(value); i > 0 && (value[i-1] == ' '
+                || value[i-1] == '\t'); i--)
+            value[i-1] = '\0';
+        for(i = 0; longOptions[i].name != NULL; i++)
+            if(longOptions[i].has_arg == required_argument
+                    && strcmp(longOptions[i].name, name) == 0)
+                break;
+        if(longOptions[i].name == NULL)
+        {
+            if(report)
+                printf("%s:%d: unknown option %s\n", fileName, lineNumber,
+                        name);
+            fclose(file);
+            return OPTIONS_ERROR;
+        }
+        depth++;
+        result = setOption(opts, longOptions[i].val, value, report);
+        depth--;
+        if(result != 0)
+        {
+            fclose(file);
+            return OPTIONS_ERROR;
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+
+//parseOptions
+//INPUT: Options holding the defaults (opts), command line (argc, argv)
+//       whether to print usage and errors (report, 0 on all but one MPI
+//       process)
+//PROC:  Applies each option in turn
+//OUT:   0 to go ahead, OPTIONS_HELP if usage was asked for, or
+//       OPTIONS_ERROR if an option was invalid
+int parseOptions(struct options *opts, int argc, char **argv, int report)
+{
+    struct options defaults = *opts;
+    int key = 0;
+    opterr = report;
+    optind = 1;
+    while((key = getopt_long(argc, argv, "s:p:t:m:o:h", longOptions, NULL))
+            != -1)
+    {
+        if(key == 'h')
+        {
+            if(report)
+                printUsage(argv[0], &defaults);
+            return OPTIONS_HELP;
+        }
+        if(key == '?' || setOption(opts, key, optarg, report) != 0)
+            return OPTIONS_ERROR;
+    }
+    if(optind < argc)
+    {
+        if(report)
+            printf("Unexpected argument %s\n", argv[optind]);
+        return OPTIONS_ERROR;
+    }
+    if((opts->format == OUTPUT_BINARY || opts->format == OUTPUT_COMPRESSED)
+            && opts->outputFile[0] == '\0')
+    {
+        if(report)
+            printf("Binary output needs a file name (--output)\n");
+        return OPTIONS_ERROR;
+    }
+    if(opts->format == OUTPUT_COMPRESSED && !ZLIB_ENABLED)
+    {
+        if(report)
+            printf("Compressed output needs a build with -DRELAX_ZLIB and "
+                    "-lz\n");
+        return OPTIONS_ERROR;
+    }
+    //Only the single grid sweeps have single precision kernels
+    if(opts->dtype != ELEMENT_DOUBLE && opts->method != METHOD_JACOBI
+            && opts->method != METHOD_RED_BLACK && opts->method != METHOD_SOR)
+    {
+        if(report)
+            printf("Single precision sweeps need jacobi, red-black or sor\n");
+        return OPTIONS_ERROR;
+    }
+    if(opts->dtype == ELEMENT_FLOAT && opts->norm != NORM_DELTA)
+    {
+        if(report)
+            printf("Float sweeps are checked by their largest change "
+                    "(--norm delta), use --dtype mixed for residuals\n");
+        return OPTIONS_ERROR;
+    }
+    //A relative precision is only known once the first sweep is done
+    if(opts->dtype == ELEMENT_FLOAT && opts->method == METHOD_SOR
+            && !opts->relative)
+    {
+        double omega = (opts->omega > 0) ? opts->omega
+                : optimalOmega(opts->rows, opts->cols);
+        double floor = floatFloor(omega, largestBoundary(opts));
+        if(opts->precision < floor)
+        {
+            if(report)
+                printf("Float sor sweeps of this matrix only reliably "
+                        "reach a precision of %g, use --dtype mixed for "
+                        "%g\n", floor, opts->precision);
+            return OPTIONS_ERROR;
+        }
+    }
+    if(checkConditions(opts, report) != 0)
+        return OPTIONS_ERROR;
+    if(opts->restart[0] != '\0' && opts->initial[0] != '\0')
+    {
+        if(report)
+            printf("Give either --restart or --initial, not both\n");
+        return OPTIONS_ERROR;
+    }
+    //Later trials would start from the first trial's snapshots
+    if(opts->checkpoint[0] != '\0' && (opts->trials > 1 || opts->warmup > 0))
+    {
+        if(report)
+            printf("Checkpoints need a single trial with no warmup\n");
+        return OPTIONS_ERROR;
+    }
+    //A batch starts every grid afresh and writes none of them
+    if(opts->batch > 0 && (opts->checkpoint[0] != '\0'
+            || opts->restart[0] != '\0' || opts->initial[0] != '\0'))
+    {
+        if(report)
+            printf("A batch takes no snapshots and starts from none\n");
+        return OPTIONS_ERROR;
+    }
+    if(opts->trace[0] != '\0' && !TRACE_ENABLED)
+    {
+        if(report)
+            printf("Tracing needs a build with -DRELAX_TRACE\n");
+        return OPTIONS_ERROR;
+    }
+    return 0;
+}
+
+
+//printUsage
+//INPUT: Name the program was run as (program), its defaults (defaults)
+//PROC:  Prints every option with its default
+//OUT:   N/A
+void printUsage(const char *program, const struct options *defaults)
+{
+    printf("Usage: %s [options]\n\n", program);
+    printf("  -s, --size N            rows and columns of a square matrix "
+            "(%d)\n", defaults->rows);
+    printf("      --rows N            rows, boundary included (%d)\n",
+            defaults->rows);
+    printf("      --cols N            columns, boundary included (%d)\n",
+            defaults->cols);
+    printf("  -p, --precision X       largest change to accept (%g)\n",
+            defaults->precision);
+    printf("  -t, --threads N         threads, or threads per MPI process "
+            "(%d)\n", defaults->threads);
+    printf("  -m, --method NAME       gauss-seidel, jacobi, red-black, sor, "
+            "vcycle, fmg\n"
+            "                          or wavefront (%s)\n",
+            methodName(defaults->method));
+    printf("      --omega X           SOR factor between 0 and 2, optimal "
+            "or adaptive\n");
+    printf("      --block-sweeps N    sweeps per tile for wavefront (%d)\n",
+            defaults->blockSweeps);
+    printf("      --schedule NAME     bands, tiles shared out between "
+            "threads, or neighbours\n"
+            "                          (bands meeting no barrier) for the "
+            "shared solver's\n"
+            "                          jacobi, red-black and sor (%s)\n",
+            (defaults->schedule == SCHEDULE_TILES) ? "tiles"
+            : (defaults->schedule == SCHEDULE_NEIGHBOURS) ? "neighbours"
+            : "bands");
+    printf("      --max-iterations N  sweeps or cycles before giving up, "
+            "0 for no limit (%d)\n", defaults->maxIterations);
+    printf("      --check-interval N  sweeps between convergence checks "
+            "(%d)\n", defaults->checkInterval);
+    printf("      --norm NAME         delta (largest change), linf or l2 "
+            "residual (%s)\n", normName(defaults->norm));
+    printf("      --tolerance NAME    absolute, or relative to the first "
+            "check (%s)\n", defaults->relative ? "relative" : "absolute");
+    printf("      --dtype NAME        double, float, or mixed (float "
+            "sweeps refined in double)\n"
+            "                          for jacobi, red-black and sor (%s)\n",
+            elementName(defaults->dtype));
+    printf("      --border X          value on the matrix's edge (%g)\n",
+            defaults->borderValue);
+    printf("      --top SPEC          top edge held at X, or neumann[:G] for "
+            "an outward gradient\n"
+            "                          G, 0 if left out; also --bottom, --left "
+            "and --right (border)\n");
+    printf("      --source X          solve laplacian(u) = X instead of "
+            "Laplace's equation (%g)\n", defaults->source);
+    printf("      --obstacle R0:R1,C0:C1=V  hold the cells in rows R0 to R1 "
+            "and columns C0\n"
+            "                          to C1 at V; rectangles only, give up "
+            "to %d to build\n"
+            "                          other shapes\n", OPTIONS_OBSTACLES);
+    printf("      --affinity LIST     pin threads to compact, scatter or a "
+            "list such as 0-7,16-23\n");
+    printf("      --process-grid RxC  MPI processes down and across, 0 to "
+            "choose\n");
+    printf("      --format NAME       none, text, binary or compressed "
+            "output of the result\n");
+    printf("  -o, --output FILE       file to write the result to\n");
+    printf("      --trials N          timed solves, reported by median "
+            "(%d)\n", defaults->trials);
+    printf("      --warmup N          untimed solves run first (%d)\n",
+            defaults->warmup);
+    printf("      --batch N           solve N grids of mixed sizes and "
+            "borders together,\n"
+            "                          each checked against a solve of its "
+            "own (shared solver)\n");
+    printf("      --report FILE       add the timings to a benchmark "
+            "report\n");
+    printf("      --report-format F   csv or json lines (csv)\n");
+    printf("      --trace FILE        write a Chrome trace of every "
+            "thread's time\n");
+    printf("      --checkpoint FILE   keep a snapshot of the matrix in "
+            "FILE\n");
+    printf("      --checkpoint-interval N  sweeps or cycles between "
+            "snapshots (%d)\n", defaults->checkpointInterval);
+    printf("      --restart FILE      resume the solve saved in snapshot "
+            "FILE\n");
+    printf("      --initial FILE      start from the matrix in snapshot "
+            "FILE\n");
+    printf("      --config FILE       read name = value options from FILE\n");
+    printf("  -h, --help              print this message\n");
+}
@@ -0,0 +1,138 @@
+// Solver parameters read from the command line and configuration files
+// Candidate Number: 11066
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "sweep.h"
+#include "convergence.h"
+#include "mixed.h"
+
+// Longest file name or affinity list held
+#define OPTIONS_STRING 1024
+
+// What is written once the matrix is processed
+enum outputFormat
+{
+    OUTPUT_NONE, // Nothing
+    OUTPUT_TEXT, // The matrix printed as text
+    OUTPUT_BINARY, // A solution file of native doubles (see output.h)
+    OUTPUT_COMPRESSED // A solution file with the rows deflated
+};
+
+// How the shared solver's threads split each sweep
+enum rowSchedule
+{
+    SCHEDULE_BANDS, // One fixed band of rows per thread
+    SCHEDULE_TILES, // Cache sized tiles, idle threads stealing from others
+                    // (see tiles.h)
+    SCHEDULE_NEIGHBOURS // One band per thread, each waiting only on the
+                        // bands either side of it (see flags.h)
+};
+
+// Condition held on one edge of the matrix
+enum edgeKind
+{
+    EDGE_BORDER, // Held at borderValue (original)
+    EDGE_DIRICHLET, // Held at the edge's own value
+    EDGE_NEUMANN // Outward gradient held at the edge's value
+};
+
+// Edges of the matrix, in the order of options.edges
+enum edgeSide
+{
+    EDGE_TOP,
+    EDGE_BOTTOM,
+    EDGE_LEFT,
+    EDGE_RIGHT,
+    EDGES
+};
+
+// Most obstacles the options hold
+#define OPTIONS_OBSTACLES 16
+
+//Struct holding the condition on one edge of the matrix
+struct edge
+{
+    enum edgeKind kind;
+    double value; // Value held (EDGE_DIRICHLET), or the outward gradient
+                  // across the edge (EDGE_NEUMANN)
+};
+
+//Struct holding a rectangle of interior cells held at one value
+struct obstacle
+{
+    int startRow; // Rows startRow up to but not including endRow
+    int endRow;
+    int startCol; // Columns startCol up to but not including endCol
+    int endCol;
+    double value;
+};
+
+// Layout of benchmark reports
+enum reportFormat
+{
+    REPORT_CSV, // One row per run, after a header row
+    REPORT_JSON // One JSON object per run, one per line
+};
+
+//Struct holding every parameter either solver takes
+struct options
+{
+    int rows; // Rows in the matrix, boundary included
+    int cols; // Columns in the matrix, boundary included
+    double precision; // Largest change (or residual) to accept
+    int threads; // Threads sharing the matrix, or each MPI process's block
+    enum sweepMethod method; // Update ordering or multigrid
+    double omega; // Over-relaxation factor for METHOD_SOR (see sor.h)
+    int blockSweeps; // Sweeps per tile for METHOD_WAVEFRONT
+    enum rowSchedule schedule; // How threads split jacobi, red-black and
+                               // sor sweeps
+    int maxIterations; // Sweeps (or cycles) before giving up, 0 for no limit
+    int checkInterval; // Sweeps between convergence checks
+    enum convergenceNorm norm; // Quantity compared with the precision
+    int relative; // Non zero if precision is a fraction of the first norm
+    enum elementType dtype; // Precision of the sweeps (see mixed.h)
+    double borderValue; // Value held on the matrix's outer edge
+    struct edge edges[EDGES]; // Condition on each edge (see stencil.h)
+    double source; // f in laplacian(u) = f, 0 for Laplace's equation
+    struct obstacle obstacles[OPTIONS_OBSTACLES]; // Interior cells held at
+                                                  // fixed values
+    int obstacleCount;
+    char affinity[OPTIONS_STRING]; // Processors to pin threads to, "" for
+                                   // none (see affinity.h)
+    int dims[2]; // MPI process grid shape, 0 to choose automatically
+    enum outputFormat format;
+    char outputFile[OPTIONS_STRING]; // File to write, "" for standard output
+    int trials; // Timed solves, each from the starting matrix
+    int warmup; // Untimed solves run first
+    int batch; // Grids of a test batch solved instead of the matrix, 0 for
+               // none (shared solver only)
+    char report[OPTIONS_STRING]; // File benchmark results are added to,
+                                 // "" for none
+    enum reportFormat reportFormat;
+    char trace[OPTIONS_STRING]; // File the timeline is written to, "" for
+                                // none (needs -DRELAX_TRACE, see trace.h)
+    char checkpoint[OPTIONS_STRING]; // Snapshot file kept up to date, ""
+                                     // for none (see checkpoint.h)
+    int checkpointInterval; // Sweeps (or cycles) between snapshots
+    char restart[OPTIONS_STRING]; // Snapshot to resume, "" for none
+    char initial[OPTIONS_STRING]; // Snapshot to start from, "" for none
+};
+
+// Results of parseOptions besides success
+#define OPTIONS_HELP 1 // --help was given, usage has been printed
+#define OPTIONS_ERROR -1 // An option was invalid, the error has been printed
+
+// Exit status of a solver stopped by --max-iterations before converging
+#define EXIT_NOT_CONVERGED 2
+
+void initOptions(struct options *opts);
+int parseOptions(struct options *opts, int argc, char **argv, int report);
+int readConfig(struct options *opts, const char *fileName, int report);
+void printUsage(const char *program, const struct options *defaults);
+const char *methodName(enum sweepMethod method);
+int checkDue(int iterations, int checkInterval, int maxIterations);
+int underLimit(int iterations, int maxIterations);
+
+#endif
@@ -0,0 +1,348 @@
+// Solution files: the processed matrix behind a self describing header
+// Candidate Number: 11066
+//
+// Printing every cell as text takes longer than the solve on any sizeable
+// matrix, and loses all but six decimal places. A solution file instead
+// holds the cells as native doubles behind a SOLUTION_HEADER byte header
+// giving the size, cell type, sweeps taken and final residual, so a file
+// can be checked or compared without knowing how it was made.
+//
+// The writer takes the matrix a row at a time through a large file
+// buffer, so rows can be streamed out as they are finished and no copy of
+// the whole matrix is needed. Compressed files gather the rows into
+// blocks of about SOLUTION_BLOCK_BYTES and deflate each block on its own,
+// so the reader also only ever holds one block.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifdef RELAX_ZLIB
+#include <zlib.h>
+#endif
+#include "output.h"
+
+_Static_assert(sizeof(struct solutionHeader) == SOLUTION_HEADER,
+        "solution header must be SOLUTION_HEADER bytes");
+
+
+//initSolutionHeader
+//INPUT: Header to fill in (header), size of the matrix, boundary included
+//       (rows, cols), non zero to deflate the rows (compressed), sweeps
+//       (or cycles) taken (iterations), whether the precision was met
+//       (converged), largest absolute residual (residual), precision the
+//       solve worked towards (precision)
+//OUT:   N/A (header describes the solution)
+void initSolutionHeader(struct solutionHeader *header, int rows, int cols,
+        int compressed, int iterations, int converged, double residual,
+        double precision)
+{
+    memset(header, 0, sizeof(struct solutionHeader));
+    memcpy(header->magic, SOLUTION_MAGIC, sizeof(header->magic));
+    header->version = SOLUTION_VERSION;
+    header->rows = rows;
+    header->cols = cols;
+    header->dtype = ELEMENT_DOUBLE;
+    header->iterations = iterations;
+    header->converged = converged;
+    header->compressed = compressed;
+    header->blockRows = 0;
+    //Whole rows, at least one, per block
+    if(compressed)
+    {
+        header->blockRows = SOLUTION_BLOCK_BYTES / (cols * sizeof(double));
+        if(header->blockRows < 1)
+            header->blockRows = 1;
+    }
+    header->residual = residual;
+    header->precision = precision;
+}
+
+
+//checkSolutionHeader
+//INPUT: Header read from a file (header), name of the file (fileName)
+//PROC:  Prints why the file cannot be read, if it cannot
+//OUT:   0 if this build can read the cells (-1 otherwise)
+int checkSolutionHeader(const struct solutionHeader *header,
+        const char *fileName)
+{
+    if(memcmp(header->magic, SOLUTION_MAGIC, sizeof(header->magic)) != 0)
+    {
+        printf("%s is not a solution file\n", fileName);
+        return -1;
+    }
+    if(header->version != SOLUTION_VERSION
+            || header->dtype != ELEMENT_DOUBLE || header->rows < 1
+            || header->cols < 1 || (header->compressed
+            && header->blockRows < 1))
+    {
+        printf("%s has a layout this build cannot read\n", fileName);
+        return -1;
+    }
+    if(header->compressed && !ZLIB_ENABLED)
+    {
+        printf("%s is compressed, which needs a build with -DRELAX_ZLIB\n",
+                fileName);
+        return -1;
+    }
+    return 0;
+}
+
+
+//writeSolutionHeader
+//INPUT: Solution file whose cells are already written (fileName), header
+//       to put in front of them (header)
+//OUT:   0 on success (-1 if the header could not be written)
+int writeSolutionHeader(const char *fileName,
+        const struct solutionHeader *header)
+{
+    FILE *file = fopen(fileName, "r+b");
+    if(file == NULL)
+    {
+        printf("Unable to open %s for writing\n", fileName);
+        return -1;
+    }
+    size_t put = fwrite(header, sizeof(struct solutionHeader), 1, file);
+    if(fclose(file) != 0 || put != 1)
+    {
+        printf("Unable to write %s\n", fileName);
+        return -1;
+    }
+    return 0;
+}
+
+
+//openSolution
+//INPUT: File to create (fileName), header describing the solution
+//       (header)
+//PROC:  Writes the header, then sets up the buffers for the rows
+//OUT:   Pointer to the writer (NULL if the file could not be created)
+struct solutionWriter *openSolution(const char *fileName,
+        const struct solutionHeader *header)
+{
+    struct solutionWriter *writer = calloc(1, sizeof(struct solutionWriter));
+    if(writer == NULL)
+        return NULL;
+    writer->header = *header;
+    writer->buffer = malloc(SOLUTION_BUFFER_BYTES);
+    writer->file = fopen(fileName, "wb");
+    if(writer->file == NULL || writer->buffer == NULL)
+    {
+        printf("Unable to open %s for writing\n", fileName);
+        if(writer->file != NULL)
+            fclose(writer->file);
+        free(writer->buffer);
+        free(writer);
+        return NULL;
+    }
+    setvbuf(writer->file, writer->buffer, _IOFBF, SOLUTION_BUFFER_BYTES);
+#ifdef RELAX_ZLIB
+    if(header->compressed)
+    {
+        size_t bytes = (size_t)header->blockRows * header->cols
+                * sizeof(double);
+        writer->packedBytes = compressBound(bytes);
+        writer->block = malloc(bytes);
+        writer->packed = malloc(writer->packedBytes);
+        if(writer->block == NULL || writer->packed == NULL)
+        {
+            printf("Unable to allocate a %zu byte block for %s\n", bytes,
+                    fileName);
+            closeSolution(writer);
+            return NULL;
+        }
+    }
+#endif
+    fwrite(header, sizeof(struct solutionHeader), 1, writer->file);
+    return writer;
+}
+
+
+#ifdef RELAX_ZLIB
+//flushBlock
+//INPUT: Writer holding rows to compress (writer)
+//PROC:  Deflates the rows held and writes them as one block
+//OUT:   0 on success (-1 if the block could not be compressed)
+static int flushBlock(struct solutionWriter *writer)
+{
+    uLongf packed = writer->packedBytes;
+    if(writer->blockUsed == 0)
+        return 0;
+    if(compress2(writer->packed, &packed, (const Bytef *)writer->block,
+            (uLong)writer->blockUsed * writer->header.cols * sizeof(double),
+            Z_BEST_SPEED) != Z_OK)
+        return -1;
+    uint64_t length = packed;
+    fwrite(&length, sizeof(length), 1, writer->file);
+    fwrite(writer->packed, 1, packed, writer->file);
+    writer->blockUsed = 0;
+    return 0;
+}
+#endif
+
+
+//writeSolutionRow
+//INPUT: Writer (writer), next row of the matrix, boundary included (row)
+//PROC:  Adds the row to the file buffer, or to the block being gathered
+//       for compression
+//OUT:   0 on success (-1 if the row could not be written)
+int writeSolutionRow(struct solutionWriter *writer, const double *row)
+{
+    int cols = writer->header.cols;
+    if(writer->row >= writer->header.rows)
+        return -1;
+    writer->row++;
+#ifdef RELAX_ZLIB
+    if(writer->block != NULL)
+    {
+        memcpy(writer->block + (size_t)writer->blockUsed * cols, row,
+                cols * sizeof(double));
+        writer->blockUsed++;
+        if(writer->blockUsed == writer->header.blockRows)
+            return flushBlock(writer);
+        return 0;
+    }
+#endif
+    return (fwrite(row, sizeof(double), cols, writer->file)
+            == (size_t)cols) ? 0 : -1;
+}
+
+
+//closeSolution
+//INPUT: Writer (writer)
+//PROC:  Writes any rows still held, closes the file and frees the writer
+//OUT:   0 if every row of the matrix was written (-1 otherwise)
+int closeSolution(struct solutionWriter *writer)
+{
+    int result = (writer->row == writer->header.rows) ? 0 : -1;
+#ifdef RELAX_ZLIB
+    if(writer->block != NULL && flushBlock(writer) != 0)
+        result = -1;
+#endif
+    if(fclose(writer->file) != 0)
+        result = -1;
+    free(writer->buffer);
+    free(writer->block);
+    free(writer->packed);
+    free(writer);
+    return result;
+}
+
+
+//openSolutionReader
+//INPUT: Solution file (fileName)
+//PROC:  Reads and checks the header, printing why if the file cannot be
+//       read
+//OUT:   Pointer to the reader (NULL if the file cannot be read)
+struct solutionReader *openSolutionReader(const char *fileName)
+{
+    struct solutionReader *reader = calloc(1, sizeof(struct solutionReader));
+    if(reader == NULL)
+        return NULL;
+    reader->buffer = malloc(SOLUTION_BUFFER_BYTES);
+    reader->file = fopen(fileName, "rb");
+    if(reader->file == NULL || reader->buffer == NULL)
+    {
+        printf("Unable to open %s\n", fileName);
+        closeSolutionReader(reader);
+        return NULL;
+    }
+    setvbuf(reader->file, reader->buffer, _IOFBF, SOLUTION_BUFFER_BYTES);
+    if(fread(&reader->header, sizeof(struct solutionHeader), 1,
+            reader->file) != 1)
+    {
+        printf("%s is too short to be a solution file\n", fileName);
+        closeSolutionReader(reader);
+        return NULL;
+    }
+    if(checkSolutionHeader(&reader->header, fileName) != 0)
+    {
+        closeSolutionReader(reader);
+        return NULL;
+    }
+#ifdef RELAX_ZLIB
+    if(reader->header.compressed)
+    {
+        size_t bytes = (size_t)reader->header.blockRows * reader->header.cols
+                * sizeof(double);
+        reader->packedBytes = compressBound(bytes);
+        reader->block = malloc(bytes);
+        reader->packed = malloc(reader->packedBytes);
+        if(reader->block == NULL || reader->packed == NULL)
+        {
+            printf("Unable to allocate a %zu byte block for %s\n", bytes,
+                    fileName);
+            closeSolutionReader(reader);
+            return NULL;
+        }
+    }
+#endif
+    return reader;
+}
+
+
+#ifdef RELAX_ZLIB
+//fillBlock
+//INPUT: Reader whose block has been used up (reader)
+//PROC:  Reads the next compressed block and inflates it
+//OUT:   0 on success (-1 if the block is missing or damaged)
+static int fillBlock(struct solutionReader *reader)
+{
+    int rows = reader->header.rows - reader->row;
+    uint64_t length = 0;
+    if(rows > reader->header.blockRows)
+        rows = reader->header.blockRows;
+    uLongf bytes = (uLongf)rows * reader->header.cols * sizeof(double);
+    uLongf expected = bytes;
+    if(fread(&length, sizeof(length), 1, reader->file) != 1
+            || length > reader->packedBytes
+            || fread(reader->packed, 1, length, reader->file) != length
+            || uncompress((Bytef *)reader->block, &bytes, reader->packed,
+            length) != Z_OK || bytes != expected)
+        return -1;
+    reader->blockHeld = rows;
+    reader->blockUsed = 0;
+    return 0;
+}
+#endif
+
+
+//readSolutionRow
+//INPUT: Reader (reader), where to put the next row of the matrix,
+//       boundary included (row)
+//OUT:   0 on success (-1 past the last row or if the file is damaged)
+int readSolutionRow(struct solutionReader *reader, double *row)
+{
+    int cols = reader->header.cols;
+    if(reader->row >= reader->header.rows)
+        return -1;
+#ifdef RELAX_ZLIB
+    if(reader->block != NULL)
+    {
+        if(reader->blockUsed == reader->blockHeld && fillBlock(reader) != 0)
+            return -1;
+        memcpy(row, reader->block + (size_t)reader->blockUsed * cols,
+                cols * sizeof(double));
+        reader->blockUsed++;
+        reader->row++;
+        return 0;
+    }
+#endif
+    if(fread(row, sizeof(double), cols, reader->file) != (size_t)cols)
+        return -1;
+    reader->row++;
+    return 0;
+}
+
+
+//closeSolutionReader
+//INPUT: Reader to close and free (reader), may be part set up
+void closeSolutionReader(struct solutionReader *reader)
+{
+    if(reader->file != NULL)
+        fclose(reader->file);
+    free(reader->buffer);
+    free(reader->block);
+    free(reader->packed);
+    free(reader);
+}
@@ -0,0 +1,95 @@
+// Solution files: the processed matrix behind a self describing header
+// Candidate Number: 11066
+//
+// Built with -DRELAX_ZLIB (and linked with -lz) the writer can also
+// deflate the rows; otherwise OUTPUT_COMPRESSED is refused by the options.
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdio.h>
+#include "options.h"
+
+#ifdef RELAX_ZLIB
+#define ZLIB_ENABLED 1
+#else
+#define ZLIB_ENABLED 0
+#endif
+
+// Bytes before the first cell (or compressed block) of a solution file
+#define SOLUTION_HEADER 64
+
+// First bytes of every solution file
+#define SOLUTION_MAGIC "RELAXSOL"
+
+// Layout of the cells written after the header
+#define SOLUTION_VERSION 1
+
+// Bytes of cells gathered into each compressed block
+#define SOLUTION_BLOCK_BYTES (1 << 20)
+
+// Bytes of file buffer given to the writer and reader
+#define SOLUTION_BUFFER_BYTES (1 << 20)
+
+//Struct at the start of a solution file. Uncompressed cells follow as
+//rows of native doubles, boundary included. Compressed files hold blocks
+//of blockRows rows instead, each an 8 byte length then the deflated rows
+struct solutionHeader
+{
+    char magic[8]; // SOLUTION_MAGIC, not terminated
+    int version; // SOLUTION_VERSION
+    int rows; // Rows in the matrix, boundary included
+    int cols; // Columns in the matrix, boundary included
+    int dtype; // enum elementType of the cells, always ELEMENT_DOUBLE
+    int iterations; // Sweeps (or cycles) taken to reach this matrix
+    int converged; // Non zero if the precision was met
+    int compressed; // Non zero if the rows are deflated in blocks
+    int blockRows; // Rows in each compressed block (0 if uncompressed)
+    double residual; // Largest absolute residual of the matrix
+    double precision; // Precision the solve worked towards
+    char unused[SOLUTION_HEADER - 8 - 8*sizeof(int) - 2*sizeof(double)];
+};
+
+//Struct holding a solution file being written a row at a time
+struct solutionWriter
+{
+    FILE *file;
+    char *buffer; // File buffer, SOLUTION_BUFFER_BYTES
+    struct solutionHeader header;
+    int row; // Rows written so far
+    double *block; // Rows waiting to be compressed (NULL if uncompressed)
+    int blockUsed; // Rows held in block
+    unsigned char *packed; // Room for one compressed block
+    size_t packedBytes;
+};
+
+//Struct holding a solution file being read a row at a time
+struct solutionReader
+{
+    FILE *file;
+    char *buffer; // File buffer, SOLUTION_BUFFER_BYTES
+    struct solutionHeader header;
+    int row; // Rows read so far
+    double *block; // Rows of the current compressed block
+    int blockUsed; // Rows of block already read
+    int blockHeld; // Rows held in block
+    unsigned char *packed; // The block as read from the file
+    size_t packedBytes;
+};
+
+void initSolutionHeader(struct solutionHeader *header, int rows, int cols,
+        int compressed, int iterations, int converged, double residual,
+        double precision);
+int checkSolutionHeader(const struct solutionHeader *header,
+        const char *fileName);
+int writeSolutionHeader(const char *fileName,
+        const struct solutionHeader *header);
+struct solutionWriter *openSolution(const char *fileName,
+        const struct solutionHeader *header);
+int writeSolutionRow(struct solutionWriter *writer, const double *row);
+int closeSolution(struct solutionWriter *writer);
+struct solutionReader *openSolutionReader(const char *fileName);
+int readSolutionRow(struct solutionReader *reader, double *row);
+void closeSolutionReader(struct solutionReader *reader);
+
+#endif
@@ -0,0 +1,284 @@
+// Persistent worker pool with a spin-then-block barrier and fused reduction
+// Candidate Number: 11066
+//
+// The threads are created once and reused by every runPool call. Between
+// calls, and whenever a barrier is slow to open, they sleep on a condition
+// variable; within a solve they meet at a sense-reversing barrier that
+// spins on one shared word. Each thread posts its value in its own cache
+// line, so one barrier both synchronises and reduces.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sched.h>
+#include "pool.h"
+
+// Bytes given to each independently written field
+#define POOL_LINE 64
+
+// Polls of the barrier before a waiting thread blocks. Threads only spin
+// when each can have a processor to itself, otherwise a spinning thread
+// holds up the one it is waiting for
+#define POOL_SPINS 20000
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define POOL_PAUSE() _mm_pause()
+#else
+#define POOL_PAUSE()
+#endif
+
+//Struct holding what one thread writes, alone on its cache line
+struct poolSlot
+{
+    _Alignas(POOL_LINE) double value; // Value posted to the current reduction
+    int sense; // Sense of the last barrier this thread passed
+    int index; // Thread number within the pool
+    struct pool *pool;
+    pthread_t thread;
+};
+
+//Struct holding the pool, with the barrier's shared fields on their own
+//cache lines
+struct pool
+{
+    _Alignas(POOL_LINE) atomic_int arrived; // Threads at the open barrier
+    _Alignas(POOL_LINE) atomic_int sense; // Flips as each barrier opens
+    double result[2]; // Reduction result, indexed by the sense it opened
+    _Alignas(POOL_LINE) atomic_int sleepers; // Threads blocked on wake
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int threads;
+    int spins; // Polls before blocking (POOL_SPINS, or 0 if oversubscribed)
+    poolTask task; // Function for the current runPool, NULL to exit
+    void *args;
+    size_t argSize;
+    struct poolSlot *slots;
+};
+
+
+//waitPool
+//INPUT: Pool (pool), calling thread (thread), value to reduce (value),
+//       non zero to add the values rather than take the largest (sum)
+//PROC:  Posts value, then the last thread to arrive reduces the values and
+//       releases the others by flipping the shared sense. Waiting threads
+//       spin for a while, then block until woken
+//OUT:   Largest value (or sum of the values) posted at this barrier
+static double waitPool(struct pool *pool, int thread, double value, int sum)
+{
+    struct poolSlot *slot = &pool->slots[thread];
+    int sense = slot->sense ^ 1;
+    int i = 0;
+    slot->sense = sense;
+    slot->value = value;
+
+    if(atomic_fetch_add_explicit(&pool->arrived, 1, memory_order_acq_rel)
+            == pool->threads-1)
+    {
+        //Added in thread order, so the sum is the same on every run
+        double reduced = pool->slots[0].value;
+        for(i = 1; i<pool->threads; i++)
+        {
+            if(sum)
+                reduced += pool->slots[i].value;
+            else if(pool->slots[i].value > reduced)
+                reduced = pool->slots[i].value;
+        }
+        //The other half of result may still be read after the last barrier
+        pool->result[sense] = reduced;
+        atomic_store_explicit(&pool->arrived, 0, memory_order_relaxed);
+        atomic_store(&pool->sense, sense);
+        if(atomic_load(&pool->sleepers) > 0)
+        {
+            pthread_mutex_lock(&pool->lock);
+            pthread_cond_broadcast(&pool->wake);
+            pthread_mutex_unlock(&pool->lock);
+        }
+        return reduced;
+    }
+
+    for(i = 0; atomic_load_explicit(&pool->sense, memory_order_acquire)
+            != sense; i++)
+    {
+        if(i < pool->spins)
+        {
+            POOL_PAUSE();
+            continue;
+        }
+        //Counted as asleep before the last look, so the releasing thread
+        //either sees the count or this thread sees the new sense
+        pthread_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->sleepers, 1);
+        while(atomic_load(&pool->sense) != sense)
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        atomic_fetch_sub(&pool->sleepers, 1);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return pool->result[sense];
+}
+
+
+//poolWorker (thread function)
+//INPUT: Slot of the worker (slotStruct)
+//PROC:  Waits for each runPool call, runs its task on this worker's
+//       argument struct, then waits for the rest of the pool
+//OUT:   N/A (returns once freePool clears the task)
+static void *poolWorker(void *slotStruct)
+{
+    struct poolSlot *slot = (struct poolSlot*)slotStruct;
+    struct pool *pool = slot->pool;
+    for(;;)
+    {
+        waitPool(pool, slot->index, 0, 0);
+        if(pool->task == NULL)
+            return NULL;
+        pool->task((char*)pool->args + slot->index * pool->argSize);
+        waitPool(pool, slot->index, 0, 0);
+    }
+}
+
+
+//createPool
+//INPUT: Number of threads in the pool, the calling thread included (threads)
+//       processor to pin each thread to (cpus, NULL to leave them unpinned)
+//PROC:  Starts threads-1 workers, which sleep until runPool is called. The
+//       calling thread is pinned to cpus[0] and stays pinned after freePool
+//OUT:   Pointer to the pool (NULL on failure)
+struct pool *createPool(int threads, const int *cpus)
+{
+    struct pool *pool = NULL;
+    pthread_attr_t attr;
+    cpu_set_t cpuSet;
+    int i = 0;
+    if(threads < 1 || posix_memalign((void **)&pool, POOL_LINE,
+            sizeof(struct pool)) != 0)
+        return NULL;
+    if(posix_memalign((void **)&pool->slots, POOL_LINE,
+            threads * sizeof(struct poolSlot)) != 0)
+    {
+        free(pool);
+        return NULL;
+    }
+    atomic_init(&pool->arrived, 0);
+    atomic_init(&pool->sense, 0);
+    atomic_init(&pool->sleepers, 0);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pool->threads = threads;
+    pool->spins = (threads <= sysconf(_SC_NPROCESSORS_ONLN)) ? POOL_SPINS : 0;
+    pool->task = NULL;
+    pool->args = NULL;
+    pool->argSize = 0;
+    for(i = 0; i<threads; i++)
+    {
+        pool->slots[i].value = 0;
+        pool->slots[i].sense = 0;
+        pool->slots[i].index = i;
+        pool->slots[i].pool = pool;
+    }
+    //Slot 0 belongs to whichever thread calls runPool
+    if(cpus != NULL)
+    {
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpus[0], &cpuSet);
+        if(pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet)
+                != 0)
+            printf("Unable to pin pool thread 0 to processor %d\n", cpus[0]);
+    }
+    for(i = 1; i<threads; i++)
+    {
+        //Pinned from the start, so the worker's stack is on its own node
+        pthread_attr_init(&attr);
+        if(cpus != NULL)
+        {
+            CPU_ZERO(&cpuSet);
+            CPU_SET(cpus[i], &cpuSet);
+            pthread_attr_setaffinity_np(&attr, sizeof(cpuSet), &cpuSet);
+        }
+        if(pthread_create(&pool->slots[i].thread, &attr, &poolWorker,
+                &pool->slots[i]) != 0)
+        {
+            printf("Unable to start pool thread %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+        pthread_attr_destroy(&attr);
+    }
+    return pool;
+}
+
+
+//poolThreads
+//INPUT: Pool (pool)
+//OUT:   Number of threads in the pool, the calling thread included
+int poolThreads(const struct pool *pool)
+{
+    return pool->threads;
+}
+
+
+//runPool
+//INPUT: Pool (pool), thread function (task), array of one argument struct
+//       per thread (args) and the size of each struct (argSize)
+//PROC:  Runs task on every thread of the pool, the calling thread taking
+//       the first struct
+//OUT:   N/A (returns once every thread has finished its task)
+void runPool(struct pool *pool, poolTask task, void *args, size_t argSize)
+{
+    pool->task = task;
+    pool->args = args;
+    pool->argSize = argSize;
+    waitPool(pool, 0, 0, 0);
+    task(args);
+    waitPool(pool, 0, 0, 0);
+}
+
+
+//poolBarrier
+//INPUT: Pool (pool), calling thread's number (thread)
+//PROC:  Waits for every thread of the pool to reach a barrier
+void poolBarrier(struct pool *pool, int thread)
+{
+    waitPool(pool, thread, 0, 0);
+}
+
+
+//poolReduceMax
+//INPUT: Pool (pool), calling thread's number (thread), its value (value)
+//PROC:  Waits for every thread of the pool, as poolBarrier does
+//OUT:   Largest value passed in by any thread
+double poolReduceMax(struct pool *pool, int thread, double value)
+{
+    return waitPool(pool, thread, value, 0);
+}
+
+
+//poolReduceSum
+//INPUT: Pool (pool), calling thread's number (thread), its value (value)
+//PROC:  Waits for every thread of the pool, as poolBarrier does
+//OUT:   Sum of the values passed in, the same on every thread
+double poolReduceSum(struct pool *pool, int thread, double value)
+{
+    return waitPool(pool, thread, value, 1);
+}
+
+
+//freePool
+//INPUT: Pool (pool), not in use by runPool
+//PROC:  Tells the workers to exit, joins them and frees the pool
+void freePool(struct pool *pool)
+{
+    int i = 0;
+    if(pool == NULL)
+        return;
+    pool->task = NULL;
+    waitPool(pool, 0, 0, 0);
+    for(i = 1; i<pool->threads; i++)
+        pthread_join(pool->slots[i].thread, NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    free(pool->slots);
+    free(pool);
+}
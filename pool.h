@@ -0,0 +1,23 @@
+// Persistent worker pool with a spin-then-block barrier and fused reduction
+// Candidate Number: 11066
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+// Thread functions run by the pool take their own argument struct, as
+// pthread_create thread functions do
+typedef void *(*poolTask)(void *argsStruct);
+
+struct pool;
+
+struct pool *createPool(int threads, const int *cpus);
+int poolThreads(const struct pool *pool);
+void runPool(struct pool *pool, poolTask task, void *args, size_t argSize);
+void poolBarrier(struct pool *pool, int thread);
+double poolReduceMax(struct pool *pool, int thread, double value);
+double poolReduceSum(struct pool *pool, int thread, double value);
+void freePool(struct pool *pool);
+
+#endif
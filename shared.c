@@ -1,348 +1,509 @@
-
-//CM30225 Coursework 1 - Shared memory programming
-//Candidate Number: 11066
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <math.h>
-#include <pthread.h>
-#include <time.h>
-
-
-//Function prototypes
-void *calcMatrix(void *argsStruct);
-int* allocateSections (int cores, int arrayRows);
-void createMatrix(int borderValue, int arrayRows);
-void printMatrix(int arrayRows);
-int arrayEmpty(int sections);
-void calcResult(double **matrix, double precision, int sections, int arrayRows);
-void freeArrays();
-
-//Global arrays
-int *borders; // Internal borders for each thread
-double** myMatrix; //Matrix to be processed
-
-// Array to store whether precision has been met for each thread
-int* precisionMet; 
-
-//Parallel variables (thread / mutex / barrier)
-pthread_t *myThreads;
-pthread_mutex_t *myMutex;
-pthread_barrier_t myBarrier;
-
-//Struct to be passed into each thread
-struct argumentsForFunct 
-{ 
-    double **myMatrix;
-    int section;
-    int sections;
-    int startPointCol;
-    int endPointCol;
-    int startPointRow;
-    int endPointRow;
-    double threadPrecision;
-    int arrayRows;
-}; 
-
-
-//main
-// Proc: Sets up conditions for calcResult function and calls calcResult
-//       Creates and frees arrays used
-int main() {
-    //Main function variables
-    
-    // Timing arrays for benchmarking
-    time_t begin[10];
-    time_t end[10];   
-    
-    // Adjustable variables
-    int arrayRows = 15; // Size of array
-    double precision = 0.0001; // Precision (delta) to work towards
-    int sections = 2; // Threads to utilise
-    
-    
-    // Prevent more threads being requested than rows in matrix
-    if(sections>arrayRows)
-    {
-        sections = arrayRows;
-        printf("Using maximum threads: %d\n\n", arrayRows);
-    }
-    
-    //*****Create process and print array*****
-    printf("Using a %d square array with precision %lf\n", arrayRows, precision);
-    createMatrix(10, arrayRows); // Create 2D array for processing
-    printMatrix(arrayRows); 
-    //Calculate solution
-    begin[0] = time(NULL); //Begin timer
-    calcResult(myMatrix, precision, sections, arrayRows); //Process matrix
-    end[0] = time(NULL); //End timer
-    printMatrix(arrayRows); 
-    freeArrays();
-    //****************************************
-    
-    //Print time taken
-    printf("Time taken on %d threads = %d sec\n", sections, end[0] - begin[0]);
-    
-    return (EXIT_SUCCESS);
-}
-
-
-//calcResult (matrix solver)
-//INPUT: matrix to be processed (matrix), accuracy to work towards (precision)
-//       number of threads to be allocated to the task (sections)
-//       number of rows (and columns) in the array (arrayRows)
-// PROC: Initialises mutex and barriers
-//       Creates and joins threads for calcMatrix and sets up their parameters
-//       Frees malloced arrays created
-//OUTPUT: N/A (array is now processed)
-void calcResult(double **matrix, double precision, int sections, int arrayRows)
-{
-    int i = 0;
-    
-    //Malloc arrays
-    myThreads = malloc(sizeof(pthread_t)*sections);
-    myMutex = malloc((sections+1) * sizeof(pthread_mutex_t));
-    precisionMet = calloc(sections, sizeof(int));
-    
-    //Intialise parallel variables
-    for (i=0;i<sections+1;i++) 
-    {
-        if((pthread_mutex_init(&myMutex[i], NULL)) == 0)
-            printf("Initialised mutex %d successfully\n", i);
-        pthread_mutex_unlock(&myMutex[i]);
-    }
-    
-    pthread_barrier_init(&myBarrier, NULL, sections); 
-    
-    //Allocate boundaries of each threads processing area
-    borders = allocateSections(sections, arrayRows);
-    
-    
-    //Dynamically generate argument structs for each thread
-    struct argumentsForFunct *allArguments = 
-    (struct argumentsForFunct *)malloc(sections*sizeof(struct argumentsForFunct));
-    for(i=0; i<sections; i++){
-        (allArguments+i)->section = i;
-        (allArguments+i)->sections = sections;
-        (allArguments+i)->myMatrix = myMatrix;
-        (allArguments+i)->startPointCol = borders[(allArguments+i)->section];
-        (allArguments+i)->endPointCol = borders[(allArguments+ i)->section+1];
-        (allArguments+i)->threadPrecision = precision;
-        (allArguments+i)->arrayRows = arrayRows;
-    }
-    
-    
-    //Create threads for program
-    for(i = 0; i < sections; i++)
-            pthread_create(&myThreads[i], NULL, &calcMatrix, allArguments+i);
-    
-    //Join threads for program
-    for(i = 0; i < sections; i++)
-        pthread_join(myThreads[i], NULL);
-    
-    free(allArguments);
-}
-
-
-//calcMatrix (thread function)
-//INPUT: struct of arguments unique to the thread being used (argsStruct)
-//PROC:  Calculates the value of a given segment of the matrix
-//OUT:   N/A (the required section of the matrix is processed)
-void *calcMatrix (void *argsStruct)
-{
-    // Counter variables for function
-    int a = 0;
-    int b = 0;  
-    
-    //Separate out struct elements
-    int startPoint = ((struct argumentsForFunct*)argsStruct)->startPointCol;
-    int endPoint = ((struct argumentsForFunct*)argsStruct)->endPointCol;
-    double **myMatrix = ((struct argumentsForFunct*)argsStruct)->myMatrix;
-    int section = ((struct argumentsForFunct*)argsStruct)->section;
-    int sections = ((struct argumentsForFunct*)argsStruct)->sections; 
-    double threadPrecision = ((struct argumentsForFunct*)argsStruct)->threadPrecision;
-    int arrayRows = ((struct argumentsForFunct*)argsStruct)->arrayRows;
-    printf("\nThread %d has started and has the following properties \n "
-                "Section: %d\nstartPoint: %d\nendPoint: %d\nprecision: %lf\n"
-                "array total rows: %d\ntotal threads: %d\n\n", section, section,
-                startPoint, endPoint, threadPrecision, arrayRows, sections);
-    do
-    {
-        pthread_barrier_wait(&myBarrier);
-        
-        precisionMet[section] = 0;
-    // Iterate through each element in allocated area
-    for(a = startPoint; a<endPoint; a++)
-    { 
-        //check if calc uses the bottom boundary and not the actual border
-        if((a == borders[section]) & (section!= 0)) 
-        {
-            
-            pthread_mutex_lock(&myMutex[section]);
-            //printf("Thread %d has locked row %d\n", section, a); 
-            
-            for(b = 1; b<arrayRows-1; b++){
-                double oldValue = myMatrix[a][b];
-                myMatrix[a][b] = (myMatrix[a-1][b] + myMatrix[a][b-1]
-                        + myMatrix[a+1][b] + myMatrix[a][b+1]) / 4;
-                //printf("Thread %d, has accessed row %d col %d\n", section, a, b);
-                if((fabs(oldValue - myMatrix[a][b]) > threadPrecision))
-                    precisionMet[section] = 1;
-            }
-            pthread_mutex_unlock(&myMutex[section]);
-            //printf("Thread %d has unlocked row %d\n", section, a); 
-        }
-        //check if calc uses the bottom boundary and not the actual border
-        else if((a+1 == borders[section+1]) & (section!= arrayRows)) 
-        {
-            //printf("Thread %d, wants to access row %d\n", section, a+1);
-            pthread_mutex_lock(&myMutex[section+1]);
-            //printf("Thread %d has locked row %d\n", section, a+1); 
-            
-            for(b = 1; b<arrayRows-1; b++){
-                double oldValue = myMatrix[a][b];
-                myMatrix[a][b] = (myMatrix[a-1][b] + myMatrix[a][b-1]
-                        + myMatrix[a+1][b] + myMatrix[a][b+1]) / 4;
-                //printf("Thread %d, has accessed row %d col %d\n", section, a, b);
-                if((fabs(oldValue - myMatrix[a][b]) > threadPrecision))
-                    precisionMet[section] = 1;
-            }
-            
-            pthread_mutex_unlock(&myMutex[section+1]);
-            //printf("Thread %d has unlocked row %d\n", section, a+1); 
-        }
-        else
-        {
-            for(b = 1; b<arrayRows-1; b++){
-                double oldValue = myMatrix[a][b];
-                myMatrix[a][b] = (myMatrix[a-1][b] + myMatrix[a][b-1]
-                        + myMatrix[a+1][b] + myMatrix[a][b+1]) / 4;
-                //printf("Thread %d, has accessed r %d c %d\n", section, a, b);
-                if((fabs(oldValue - myMatrix[a][b]) > threadPrecision))
-                    precisionMet[section] = 1;
-            }
-        }      
-    }
-    pthread_barrier_wait(&myBarrier);
-    }while(arrayEmpty(sections) == 0); //While thread precision is too low
-    return NULL;
-}
-
-
-//createMatrix
-//INPUT: Value to be placed on the boundaries of the matrix (borderValue)
-//       Size of the matrix (arrayRows)
-//PROC:  Creates a dynamically sized array with boundary values (borderValue)
-//OUT:   The created array exists in memory
-void createMatrix(int borderValue, int arrayRows)
-{
-    int i = 0;
-    int j = 0;
-    //Dynamically generate array for values
-    myMatrix = malloc(arrayRows* sizeof(double *));
-    for(i=0; i<arrayRows; i++)
-    {
-        myMatrix[i] = malloc(arrayRows * sizeof(double *));
-    }
-    //Fill outside of array with values
-    for(i=0; i<arrayRows;i++)
-    {
-        for(j=0; j<arrayRows; j++)
-        {
-            if( j==0 || i==0 || j == arrayRows-1 || i == arrayRows-1)
-                myMatrix[i][j] = borderValue;
-        }
-    }
-}
-
-
-//printMatrix
-// Prints the content of the main matrix
-// INPUT: arrayRows (size of matrix)
-// PROC: Prints the content of the matrix
-// OUT: (N/A)
-void printMatrix(int arrayRows)
-{
-    //Function variables
-    int i = 0;
-    int j = 0;
-    
-    //Print preprocessed array
-    for (i = 0; i<arrayRows; i++)
-    {
-        for (j = 0; j<arrayRows; j++)
-        {
-            printf("%f  ", myMatrix[i][j]);
-        }
-        printf("\n");
-    }
-}
-
-
-//allocateSections
-//INPUT:   sections (number of sections for array to be divided in)
-//         arrayRows (size of array to be divided)
-//PROC: Take matrix dimensions and return array of row borders for each thread
-//OUTPUT: borders (array of row borders for each thread)
-int* allocateSections (int sections, int arrayRows)
-{
-    int *borders = malloc((sections+1) * sizeof(int *));
-    
-    //Calculate quotient and extra values
-    int quot = arrayRows / sections;
-    int extra = arrayRows % sections;
-    int j = 0;
-    
-    borders[0] = 1;
-    borders[1] = quot;
-    
-    for (j = 1; j < sections; j++)
-    {
-        // Place next border at least quot ahead of current border
-        borders[j+1] = borders[j] + quot;
-        
-        //If remainder values that need to be shared across border distance
-        //still exist
-        if (j < extra) 
-            borders[j+1] ++; //Increment next border value
-    }
-    // Avoid placing border value on boundary
-    if(borders[sections] == arrayRows)
-        borders[sections] --;
-                  
-    //Test code print border ranges
-    for (j = 0; j < sections+1; j++)
-        printf("\n\nBORDERS: %d\n", borders[j]);
-    return borders;
-}
-
-
-//arrayEmpty
-//INPUT: sections (number of elements in precisionMet array)
-//PROC: If all array elements are 0 return 1, else return 0
-//OUT int determining array state
-int arrayEmpty(int sections)
-{
-    //printf("I'm running arrayEmpty\n\n");
-    int i = 0;
-    for(i = 0; i<sections; i++)
-    {
-        //printf("PRECISION MET %d\n\n", precisionMet[i]);
-        if(precisionMet[i]!= 0)
-            return 0;
-    }
-    return 1;
-}
-
-
-//freeArrays
-//PROC: Frees any remaining malloced arrays
-void freeArrays()
-{
-    //Free malloced arrays
-    free(myThreads);
-    free(myMutex);
-    free(precisionMet);
-    free(myMatrix);
-    free(borders);
-}
\ No newline at end of file
+
+//CM30225 Coursework 1 - Shared memory programming
+//Candidate Number: 11066
+//Build: gcc -O2 -o shared shared.c solver.c tiles.c flags.c grid.c sweep.c sor.c multigrid.c pool.c wavefront.c affinity.c options.c bench.c trace.c convergence.c mixed.c checkpoint.c output.c stencil.c -lpthread -lm
+//       (add -DRELAX_TRACE for --trace, see trace.h, and -DRELAX_ZLIB -lz
+//       for --format compressed, see output.h)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "grid.h"
+#include "sweep.h"
+#include "sor.h"
+#include "multigrid.h"
+#include "pool.h"
+#include "wavefront.h"
+#include "affinity.h"
+#include "options.h"
+#include "bench.h"
+#include "trace.h"
+#include "convergence.h"
+#include "mixed.h"
+#include "checkpoint.h"
+#include "output.h"
+#include "solver.h"
+#include "stencil.h"
+
+
+//Function prototypes
+struct grid *createMatrix(const struct options *opts, struct pool *pool);
+void printMatrix(const struct grid *matrix, FILE *file);
+int writeMatrix(const struct grid *matrix, const struct options *opts,
+        int iterations, int converged);
+int solveSegment(void *context, const struct options *opts,
+        struct convergence *test, int *converged);
+int saveSnapshot(void *context, const struct snapshotHeader *header);
+int loadSnapshot(struct grid *matrix, const char *fileName,
+        const struct options *opts, struct snapshotHeader *header);
+void batchOptions(const struct options *opts, int k, struct options *grid);
+int runBatch(struct solver *solver, const struct options *opts);
+
+//Struct passed to solveSegment and saveSnapshot by runSegments
+struct solveContext
+{
+    struct solver *solver;
+    struct grid *matrix; // Matrix being processed
+    const char *checkpoint; // Snapshot file kept up to date
+};
+
+
+//main
+// Proc: Reads the options, sets up a solver and solves the matrix with it
+//       (see solveGrid), or a test batch of grids instead (see runBatch)
+//       Creates and frees arrays used
+int main(int argc, char **argv) {
+    // Default parameters, see --help for the options changing them
+    struct options opts;
+    initOptions(&opts);
+    opts.rows = 15; // Size of array
+    opts.cols = 15;
+    opts.precision = 0.0001; // Precision (delta) to work towards
+    opts.threads = 2; // Threads to utilise
+    opts.method = METHOD_SOR; // Update ordering or multigrid
+    opts.borderValue = 10;
+    opts.format = OUTPUT_TEXT;
+    int status = parseOptions(&opts, argc, argv, 1);
+    if(status != 0)
+        return (status == OPTIONS_HELP) ? EXIT_SUCCESS : EXIT_FAILURE;
+    int sections = opts.threads;
+    
+    // Prevent more threads being requested than rows in matrix
+    if(sections>opts.rows)
+    {
+        sections = opts.rows;
+        printf("Using maximum threads: %d\n\n", opts.rows);
+    }
+    
+    //*****Create process and print array*****
+    printf("Using a %dx%d array with precision %lf and %s\n", opts.rows,
+            opts.cols, opts.precision, methodName(opts.method));
+    printf("Using %s sweep kernels\n", initSweepKernels());
+    //Threads are started once and reused by every solveGrid call
+    int *cpus = NULL;
+    if(opts.affinity[0] != '\0')
+    {
+        cpus = malloc(sections * sizeof(int));
+        if(cpus == NULL || chooseAffinity(opts.affinity, sections, cpus) != 0)
+        {
+            printf("Unable to place threads with affinity %s\n",
+                    opts.affinity);
+            exit(EXIT_FAILURE);
+        }
+    }
+    struct solver *solver = createSolver(sections, cpus);
+    free(cpus);
+    if(solver == NULL)
+    {
+        printf("Unable to start %d threads\n", sections);
+        exit(EXIT_FAILURE);
+    }
+    if(opts.batch > 0)
+    {
+        status = runBatch(solver, &opts);
+        freeSolver(solver);
+        return (status == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    // Create 2D array for processing
+    struct grid *myMatrix = createMatrix(&opts, solver->pool);
+    if(opts.format == OUTPUT_TEXT && opts.outputFile[0] == '\0')
+        printMatrix(myMatrix, stdout); 
+    //Calculate solution, each trial starting from a fresh matrix. Warmup
+    //trials come first and are not timed
+    struct benchRecord record;
+    struct snapshotHeader snapshot;
+    struct convergence test;
+    struct solveContext context = {solver, myMatrix, opts.checkpoint};
+    double *times = malloc(opts.trials * sizeof(double));
+    const char *start = (opts.restart[0] != '\0') ? opts.restart
+            : opts.initial; // Snapshot to start from, "" for none
+    int converged = 0;
+    int iterations = 0;
+    int resumed = 0; // Sweeps (or cycles) taken before this run
+    int trial = 0;
+    if(times == NULL)
+    {
+        printf("Unable to allocate times for %d trials\n", opts.trials);
+        exit(EXIT_FAILURE);
+    }
+    //Threads are traced across every trial, warmup included
+    TRACE_THREAD(0, 0);
+    traceStart();
+    for(trial = -opts.warmup; trial < opts.trials; trial++)
+    {
+        if(trial > -opts.warmup)
+        {
+            freeGrid(myMatrix);
+            myMatrix = createMatrix(&opts, solver->pool);
+            context.matrix = myMatrix;
+        }
+        //Thread statistics cover the last trial only
+        resetSolverStats(solver);
+        initConvergence(&test, &opts);
+        if(start[0] != '\0')
+        {
+            if(loadSnapshot(myMatrix, start, &opts, &snapshot) != 0)
+                exit(EXIT_FAILURE);
+            //A restart carries on the solve the snapshot was taken from
+            if(opts.restart[0] != '\0')
+            {
+                resumed = snapshot.iterations;
+                test.reference = snapshot.reference;
+            }
+            if(trial == -opts.warmup)
+                printf("Starting from %s, taken after %d iterations of "
+                        "%s\n", start, snapshot.iterations,
+                        methodName(snapshot.method));
+        }
+        double solveStart = TRACE_NOW();
+        double begin = wallSeconds(); //Begin timer
+        iterations = runSegments(&opts, &test, resumed, start[0] != '\0',
+                &solveSegment, &saveSnapshot, &context,
+                &converged); //Process matrix
+        if(iterations < 0)
+            exit(EXIT_FAILURE);
+        double elapsed = wallSeconds() - begin; //End timer
+        TRACE_SPAN("solve", solveStart);
+        if(trial >= 0)
+            times[trial] = elapsed;
+    }
+    if(sections > 1)
+        printSolverStats(solver);
+    freeSolver(solver);
+    if(opts.trace[0] != '\0' && traceWrite(opts.trace, 1, 1) != 0)
+        status = EXIT_FAILURE;
+    const char *units = (opts.method == METHOD_VCYCLE
+            || opts.method == METHOD_FMG) ? "multigrid cycles" : "sweeps";
+    if(converged)
+        printf("Converged after %d %s\n", iterations, units);
+    else
+        printf("Stopped after %d %s without converging\n", iterations,
+                units);
+    if(writeMatrix(myMatrix, &opts, iterations, converged) != 0)
+        status = EXIT_FAILURE;
+    freeGrid(myMatrix);
+    //****************************************
+    
+    //Print time taken
+    record.solver = "shared";
+    record.processes = 1;
+    record.threads = sections;
+    record.iterations = iterations - resumed;
+    record.converged = converged;
+    summariseTimes(times, opts.trials, &record.stats);
+    fillBenchRecord(&record, &opts);
+    free(times);
+    printf("Time taken on %d threads = %.6f sec", sections,
+            record.stats.median);
+    if(opts.trials > 1)
+        printf(" (median of %d trials, p95 %.6f sec)", opts.trials,
+                record.stats.p95);
+    printf("\nThroughput = %.3f GLUP/s, modelled bandwidth = %.2f GB/s\n",
+            record.glups, record.bandwidth);
+    if(opts.report[0] != '\0' && writeBenchReport(&record, &opts) != 0)
+        status = EXIT_FAILURE;
+    
+    if(status != 0)
+        return EXIT_FAILURE;
+    return converged ? EXIT_SUCCESS : EXIT_NOT_CONVERGED;
+}
+
+
+//solveSegment
+//INPUT: solver and matrix (context, a struct solveContext), solver
+//       parameters (opts), convergence test (test), where to report
+//       whether the precision was met (converged)
+//PROC:  Solves the matrix for up to opts->maxIterations sweeps (see
+//       runSegments)
+//OUT:   Number of sweeps (or multigrid cycles) taken (-1 on failure)
+int solveSegment(void *context, const struct options *opts,
+        struct convergence *test, int *converged)
+{
+    struct solveContext *solve = (struct solveContext*)context;
+    return solveGrid(solve->solver, solve->matrix, opts, test, converged);
+}
+
+
+//saveSnapshot
+//INPUT: matrix and checkpoint file (context, a struct solveContext), header
+//       describing the snapshot (header)
+//PROC:  Maps a new file beside the checkpoint, copies every row of the
+//       matrix into the mapping, then renames it over the checkpoint
+//OUT:   0 on success (-1 if the snapshot could not be written)
+int saveSnapshot(void *context, const struct snapshotHeader *header)
+{
+    struct solveContext *solve = (struct solveContext*)context;
+    struct grid *myMatrix = solve->matrix;
+    char temp[OPTIONS_STRING + 4];
+    int i = 0;
+    int rows = myMatrix->rows;
+    int cols = myMatrix->cols;
+    double spanStart = TRACE_NOW();
+    snapshotTemp(solve->checkpoint, temp);
+    double *cells = mapSnapshot(temp, rows, cols, 1);
+    if(cells == NULL)
+        return -1;
+    for(i = 0; i<rows; i++)
+        memcpy(cells + (size_t)i * cols, GRID_ROW(myMatrix, i),
+                cols * sizeof(double));
+    int result = unmapSnapshot(cells, rows, cols, header);
+    if(result == 0)
+        result = commitSnapshot(temp, solve->checkpoint);
+    TRACE_SPAN("checkpoint", spanStart);
+    return result;
+}
+
+
+//loadSnapshot
+//INPUT: matrix to start from (matrix), snapshot file (fileName), solver
+//       parameters (opts), where to put the snapshot's header (header)
+//PROC:  Maps the snapshot and copies the interior of its matrix into
+//       matrix. The boundary keeps the value given by the options
+//OUT:   0 on success (-1 if the snapshot could not be used)
+int loadSnapshot(struct grid *matrix, const char *fileName,
+        const struct options *opts, struct snapshotHeader *header)
+{
+    int i = 0;
+    int rows = matrix->rows;
+    int cols = matrix->cols;
+    if(readSnapshotHeader(fileName, header) != 0
+            || checkSnapshotHeader(header, opts, fileName) != 0)
+        return -1;
+    const double *cells = mapSnapshot(fileName, rows, cols, 0);
+    if(cells == NULL)
+    {
+        printf("Unable to map snapshot %s\n", fileName);
+        return -1;
+    }
+    for(i = 1; i<rows-1; i++)
+        memcpy(GRID_ROW(matrix, i) + 1, cells + (size_t)i * cols + 1,
+                (cols-2) * sizeof(double));
+    unmapSnapshot((double *)cells, rows, cols, NULL);
+    return 0;
+}
+
+
+//batchOptions
+//INPUT: Options for the whole batch (opts), grid of the batch (k), where
+//       to put the options for that grid (grid)
+//PROC:  Every fourth grid is large enough to be split across every
+//       thread (see SOLVER_SPLIT_CELLS), the rest are small grids of
+//       mixed shapes no smaller than the matrix. Each grid's border is
+//       raised by k, so every grid has its own solution
+//OUT:   N/A (grid holds opts with that grid's size and border)
+void batchOptions(const struct options *opts, int k, struct options *grid)
+{
+    *grid = *opts;
+    if(k % 4 == 0)
+    {
+        grid->rows = 258 + 2*k;
+        grid->cols = 258 + k;
+    }
+    else
+    {
+        grid->rows = opts->rows + (k * 13) % 64;
+        grid->cols = opts->cols + (k * 7) % 48;
+    }
+    grid->borderValue = opts->borderValue + k;
+}
+
+
+//runBatch
+//INPUT: Solver (solver), options for every grid (opts, opts->batch grids)
+//PROC:  Solves a batch of grids of mixed sizes and borders together (see
+//       solveBatch), then solves each grid again on its own with
+//       solveGrid: the large ones across every thread, the small ones on
+//       a single thread as the batch does. Prints each grid's sweeps and
+//       its largest difference from the separate solve, and the time
+//       taken both ways. A grid that fails to solve either way is reported
+//       and the rest carry on
+//OUT:   0 if every grid was solved, converged the same way and is
+//       identical to its separate solve (-1 otherwise). Gauss-Seidel bands wait on each
+//       other's locks, so grids split across threads depend on timing and
+//       only have to converge the same way
+int runBatch(struct solver *solver, const struct options *opts)
+{
+    int count = opts->batch;
+    int status = 0;
+    int converged = 0;
+    int k = 0;
+    int i = 0;
+    int j = 0;
+    struct options grid;
+    struct convergence test;
+    struct problem *problems = malloc(count * sizeof(struct problem));
+    struct solver *single = (solverThreads(solver) > 1)
+            ? createSolver(1, NULL) : solver;
+    if(problems == NULL || single == NULL)
+    {
+        printf("Unable to set up a batch of %d grids\n", count);
+        exit(EXIT_FAILURE);
+    }
+    for(k = 0; k<count; k++)
+    {
+        batchOptions(opts, k, &grid);
+        problems[k].matrix = createMatrix(&grid, solver->pool);
+    }
+    double begin = wallSeconds();
+    solveBatch(solver, problems, count, opts);
+    double batchTime = wallSeconds() - begin;
+    
+    double separateTime = 0;
+    for(k = 0; k<count; k++)
+    {
+        batchOptions(opts, k, &grid);
+        struct grid *matrix = createMatrix(&grid, solver->pool);
+        struct solver *own = ((long)(grid.rows-2) * (grid.cols-2)
+                < SOLVER_SPLIT_CELLS) ? single : solver;
+        initConvergence(&test, opts);
+        begin = wallSeconds();
+        int iterations = solveGrid(own, matrix, opts, &test, &converged);
+        separateTime += wallSeconds() - begin;
+        if(problems[k].failed || iterations < 0)
+        {
+            printf("Grid %d: %dx%d could not be solved %s\n", k, grid.rows,
+                    grid.cols, problems[k].failed ? "in the batch" : "alone");
+            status = -1;
+            freeGrid(matrix);
+            freeGrid(problems[k].matrix);
+            continue;
+        }
+        double largest = 0;
+        for(i = 1; i<matrix->rows-1; i++)
+            for(j = 1; j<matrix->cols-1; j++)
+            {
+                double difference = fabs(GRID_AT(matrix, i, j)
+                        - GRID_AT(problems[k].matrix, i, j));
+                if(difference > largest)
+                    largest = difference;
+            }
+        printf("Grid %d: %dx%d, border %g, %d sweeps%s, largest difference "
+                "%g from %d alone\n", k, grid.rows, grid.cols,
+                grid.borderValue, problems[k].iterations,
+                problems[k].converged ? "" : " (not converged)", largest,
+                iterations);
+        int exact = (opts->method != METHOD_GAUSS_SEIDEL || own == single);
+        if(converged != problems[k].converged || (exact && largest != 0))
+            status = -1;
+        freeGrid(matrix);
+        freeGrid(problems[k].matrix);
+    }
+    printf("Batch of %d grids took %.6f sec, %.6f sec solved one by one\n",
+            count, batchTime, separateTime);
+    if(status != 0)
+        printf("Batch results differ from separate solves\n");
+    if(single != solver)
+        freeSolver(single);
+    free(problems);
+    return status;
+}
+
+
+//createMatrix
+//INPUT: Options giving the size and boundary conditions (opts), threads
+//       that will process it (pool)
+//PROC:  Creates a contiguous zeroed grid with its edges and held cells set
+//       (see applyConditions). Each thread zeroes the rows it will update
+//       (see touchSections)
+//OUT:   Pointer to the created grid
+struct grid *createMatrix(const struct options *opts, struct pool *pool)
+{
+    int rows = opts->rows;
+    int cols = opts->cols;
+    struct grid *myMatrix = reserveGrid(rows, cols, 0);
+    if(myMatrix == NULL)
+    {
+        printf("Unable to allocate a %dx%d array\n", rows, cols);
+        exit(EXIT_FAILURE);
+    }
+    touchSections(pool, myMatrix, NULL);
+    applyConditions(myMatrix, opts, 0, 0);
+    return myMatrix;
+}
+
+
+//printMatrix
+// Prints the content of a matrix
+// INPUT: myMatrix (matrix to print), file (where to print)
+// PROC: Prints the content of the matrix
+// OUT: (N/A)
+void printMatrix(const struct grid *myMatrix, FILE *file)
+{
+    //Function variables
+    int i = 0;
+    int j = 0;
+    
+    //Print preprocessed array
+    for (i = 0; i<myMatrix->rows; i++)
+    {
+        for (j = 0; j<myMatrix->cols; j++)
+        {
+            fprintf(file, "%f  ", GRID_AT(myMatrix, i, j));
+        }
+        fprintf(file, "\n");
+    }
+}
+
+
+//writeMatrix
+// INPUT: myMatrix (processed matrix), opts (output format and file),
+//        iterations (sweeps or cycles taken), converged (whether the
+//        precision was met)
+// PROC: Prints the matrix as text, or streams its rows into a solution
+//       file (see output.h)
+// OUT: 0 on success (-1 if the file could not be written)
+int writeMatrix(const struct grid *myMatrix, const struct options *opts,
+        int iterations, int converged)
+{
+    int i = 0;
+    FILE *file = stdout;
+    if(opts->format == OUTPUT_NONE)
+        return 0;
+    if(opts->format != OUTPUT_TEXT)
+    {
+        struct solutionHeader header;
+        struct solutionWriter *writer = NULL;
+        struct stencil *stencil = NULL;
+        double residual = 0;
+        //The residual is of the update the solve used
+        if(needsStencil(opts))
+            stencil = createStencil(myMatrix, opts, 0, 0);
+        if(stencil != NULL)
+            residual = stencilResidual(stencil, myMatrix, 1,
+                    myMatrix->rows-1, 1, myMatrix->cols-1, NORM_LINF);
+        else
+            residual = bandResidual(myMatrix, 1, myMatrix->rows-1, 1,
+                    myMatrix->cols-1, NORM_LINF);
+        freeStencil(stencil);
+        initSolutionHeader(&header, myMatrix->rows, myMatrix->cols,
+                opts->format == OUTPUT_COMPRESSED, iterations, converged,
+                residual, opts->precision);
+        writer = openSolution(opts->outputFile, &header);
+        if(writer == NULL)
+            return -1;
+        for(i = 0; i<myMatrix->rows; i++)
+            writeSolutionRow(writer, GRID_ROW(myMatrix, i));
+        if(closeSolution(writer) != 0)
+        {
+            printf("Unable to write %s\n", opts->outputFile);
+            return -1;
+        }
+        return 0;
+    }
+    if(opts->outputFile[0] != '\0')
+        file = fopen(opts->outputFile, "w");
+    if(file == NULL)
+    {
+        printf("Unable to open %s for writing\n", opts->outputFile);
+        return -1;
+    }
+    printMatrix(myMatrix, file);
+    if(file != stdout && fclose(file) != 0)
+    {
+        printf("Unable to write %s\n", opts->outputFile);
+        return -1;
+    }
+    return 0;
+}
+
@@ -0,0 +1,1566 @@
+// Re-entrant solver for one grid, or a batch of independent grids
+// Candidate Number: 11066
+//
+// Every solve sets up its own sections, buffers and mutexes and frees them
+// before returning, so nothing is left in globals and separate solvers
+// can run at once. The sweep kernels are chosen once per process with
+// initSweepKernels before the first solve.
+//
+// A batch is split by size. Grids with at least SOLVER_SPLIT_CELLS
+// interior cells are solved one after another, each split across every
+// thread. The rest are handed out whole, largest first, to whichever
+// thread is free; each thread solves its grids alone through a pool of
+// one, which starts no threads and never waits. Mixed workloads keep
+// every thread busy without paying for barriers on grids too small to
+// share.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "grid.h"
+#include "sweep.h"
+#include "sor.h"
+#include "multigrid.h"
+#include "pool.h"
+#include "wavefront.h"
+#include "trace.h"
+#include "convergence.h"
+#include "mixed.h"
+#include "tiles.h"
+#include "flags.h"
+#include "stencil.h"
+#include "bench.h"
+#include "solver.h"
+
+//Struct to be passed into each thread
+struct argumentsForFunct 
+{ 
+    struct grid *myMatrix;
+    struct grid *nextMatrix; // Second buffer for Jacobi sweeps
+    struct grid *result; // Buffer holding the final values on exit
+    struct pool *pool; // Pool running the thread, for barriers
+    pthread_mutex_t *mutexes; // Locks on the border rows (Gauss-Seidel)
+    int traceThread; // Thread's number in the trace
+    struct tileSchedule *tiles; // Tiles shared out each phase, NULL to
+                                // sweep the thread's own band
+    struct tileStats stats; // This thread's share of the work
+    struct bandFlags *flags; // Progress of every band, NULL to meet the
+                             // other threads at barriers (see flags.h)
+    int phases; // Phases this thread has finished, with flags
+    int checks; // Convergence checks posted, with flags
+    int pending; // Check posted after the last sweep, 0 for none
+    const struct stencil *stencil; // General update, NULL for the average
+                                   // of the neighbours (see stencil.h)
+    const struct tileKernels *kernels; // Updates for that choice
+    int section;
+    int sections;
+    int startPointCol;
+    int endPointCol;
+    int startPointRow;
+    int endPointRow;
+    double threadPrecision;
+    struct convergence test; // This thread's copy of the convergence test
+    double omega; // Requested over-relaxation factor (see sor.h)
+    int blockSweeps; // Sweeps per tile between convergence checks
+    struct wavefront *wavefront; // Tile rows of this thread, for
+                                 // METHOD_WAVEFRONT (see wavefront.h)
+    int checkInterval; // Sweeps between convergence checks otherwise
+    int maxIterations; // Sweeps (or cycles) allowed, 0 for no limit
+    int arrayRows;
+    int iterations; // Sweeps completed on exit
+    int converged; // Non zero on exit if precision was met
+    struct mgLevel *levels; // This thread's view of the multigrid levels
+    int levelCount;
+    enum mgSchedule schedule;
+    struct gridf *floatMatrix; // Matrix, or its correction, in single
+                               // precision (see mixed.h)
+    struct gridf *floatNext; // Second float buffer for Jacobi sweeps
+    struct gridf *rhs; // Right hand side of the correction (ELEMENT_MIXED)
+}; 
+
+//Struct passed to each thread writing its own rows of a grid
+struct touchArgs
+{
+    struct grid *dst;
+    const struct grid *src; // Grid to copy, NULL to zero dst
+    int startRow;
+    int endRow;
+};
+
+//Struct passed to the multigrid operations of each thread
+struct threadTeam
+{
+    struct pool *pool;
+    int section;
+};
+
+//Struct passed to each thread solving the small grids of a batch
+struct batchArgs
+{
+    struct solver *solo; // This thread's single threaded solver
+    struct problem **order; // Small grids, largest first
+    int count; // Grids in order
+    atomic_int *next; // Position in order of the next grid to take
+    const struct options *opts;
+};
+
+//Struct holding the updates a solve applies to a tile (or band) of rows
+//and their residual, chosen once per solve: the vectorised average of the
+//neighbours, or the general update of a stencil
+struct tileKernels
+{
+    double (*jacobi)(const struct stencil *stencil, const struct grid *src,
+            struct grid *dst, const struct tile *t);
+    double (*colour)(const struct stencil *stencil, struct grid *matrix,
+            const struct tile *t, int colour, double omega);
+    double (*residual)(const struct stencil *stencil, const struct grid *g,
+            int startRow, int endRow, int startCol, int endCol,
+            enum convergenceNorm norm);
+};
+
+//Function prototypes
+static void *calcMatrix(void *argsStruct);
+static void *calcMatrixJacobi(void *argsStruct);
+static void *calcMatrixWavefront(void *argsStruct);
+static void *calcMatrixRedBlack(void *argsStruct);
+static void *calcMatrixMultigrid(void *argsStruct);
+static void *calcMatrixFloat(void *argsStruct);
+static int relaxFloat(void *argsStruct, const struct gridf *rhs,
+        struct convergence *test, int maxIterations, int *converged,
+        struct gridf **result);
+static void *touchRows(void *argsStruct);
+static void *batchWorker(void *argsStruct);
+static void solveProblem(struct solver *solver, struct problem *problem,
+        const struct options *opts);
+static int checkConvergence(void *argsStruct, double sweepDelta,
+        const struct grid *matrix);
+static void meetNeighbours(struct argumentsForFunct *args);
+static int checkNeighbours(struct argumentsForFunct *args,
+        double sweepDelta, const struct grid *matrix, int iterations);
+static int finishNeighbourCheck(struct argumentsForFunct *args, int check);
+static void threadExchange(void *context, struct mgLevel *level,
+        struct grid *g);
+static double threadReduceMax(void *context, double value);
+static double threadReduceSum(void *context, double value);
+static double sweepBand(struct argumentsForFunct *args, struct grid *src,
+        struct grid *dst, int colour, double omega);
+static double jacobiPlain(const struct stencil *stencil,
+        const struct grid *src, struct grid *dst, const struct tile *t);
+static double colourPlain(const struct stencil *stencil,
+        struct grid *matrix, const struct tile *t, int colour, double omega);
+static double residualPlain(const struct stencil *stencil,
+        const struct grid *g, int startRow, int endRow, int startCol,
+        int endCol, enum convergenceNorm norm);
+static double jacobiStencil(const struct stencil *stencil,
+        const struct grid *src, struct grid *dst, const struct tile *t);
+static double colourStencil(const struct stencil *stencil,
+        struct grid *matrix, const struct tile *t, int colour, double omega);
+static double sweepColourFloat(struct gridf *matrix, const struct gridf *rhs,
+        int startRow, int endRow, int colour, double omega);
+static double sweepTiles(struct argumentsForFunct *args, struct grid *src,
+        struct grid *dst, int colour, double omega);
+
+static const struct tileKernels plainKernels = {&jacobiPlain, &colourPlain,
+        &residualPlain};
+static const struct tileKernels stencilKernels = {&jacobiStencil,
+        &colourStencil, &stencilResidual};
+static int* allocateSections (int cores, int arrayRows);
+
+
+//solveGrid (matrix solver)
+//INPUT: solver whose threads each take one section (solver)
+//       matrix to be processed (matrix)
+//       solver parameters (opts): the accuracy to work towards, update
+//       ordering, over-relaxation factor for METHOD_SOR, sweeps applied to
+//       each tile for METHOD_WAVEFRONT (convergence is only checked after
+//       each group of them), sweeps between convergence checks otherwise,
+//       the sweeps or cycles allowed, whether jacobi, red-black and sor
+//       sweeps are shared out in tiles or meet only their neighbours, and
+//       the conditions held on the edges and obstacles (see stencil.h)
+//       convergence test, carried from one call to the next (test)
+//       where to report whether the precision was met (converged)
+// PROC: Initialises mutexes for METHOD_GAUSS_SEIDEL, or cuts the matrix
+//       into tiles (see tiles.h) or sets up each band's flag (see
+//       flags.h), and works out the general update if the
+//       conditions need it, choosing the tile updates once (tileKernels)
+//       Sets up the parameters for each thread and runs them on the pool,
+//       adding each thread's work to the solver's statistics
+//       Frees malloced arrays created. Everything the threads share is
+//       set up here, so solves on different solvers can run at once
+//OUTPUT: Number of sweeps (or multigrid cycles) taken (array is now
+//        processed), or -1 if the solve could not be set up, the matrix
+//        being left as it was
+int solveGrid(struct solver *solver, struct grid *matrix,
+        const struct options *opts, struct convergence *test,
+        int *converged)
+{
+    struct pool *pool = solver->pool;
+    enum sweepMethod method = opts->method;
+    double omega = opts->omega;
+    int i = 0;
+    int sections = poolThreads(pool);
+    int l = 0;
+    int arrayRows = matrix->rows;
+    int failed = 0;
+    int iterations = -1;
+    struct grid *nextMatrix = NULL;
+    struct gridf *floatMatrix = NULL;
+    struct gridf *floatNext = NULL;
+    struct gridf *rhs = NULL;
+    struct mgLevel *levels = NULL;
+    int levelCount = 0;
+    void *(*threadFunct)(void *) = &calcMatrix;
+    pthread_mutex_t *mutexes = NULL;
+    int *borders = NULL;
+    struct tileSchedule *tiles = NULL;
+    struct bandFlags *flags = NULL;
+    struct stencil *stencil = NULL;
+    struct argumentsForFunct *allArguments = NULL;
+    *converged = 0;
+    
+    //Single precision sweeps work on float grids, each thread writing its
+    //own rows of them first (see calcMatrixFloat)
+    if(opts->dtype != ELEMENT_DOUBLE)
+    {
+        floatMatrix = reserveGridFloat(matrix->rows, matrix->cols,
+                matrix->halo);
+        if(method == METHOD_JACOBI)
+            floatNext = reserveGridFloat(matrix->rows, matrix->cols,
+                    matrix->halo);
+        if(opts->dtype == ELEMENT_MIXED)
+            rhs = reserveGridFloat(matrix->rows, matrix->cols, matrix->halo);
+        if(floatMatrix == NULL || (method == METHOD_JACOBI
+                && floatNext == NULL) || (opts->dtype == ELEMENT_MIXED
+                && rhs == NULL))
+        {
+            printf("Unable to allocate single precision %d square arrays\n",
+                    matrix->rows);
+            failed = 1;
+        }
+        threadFunct = &calcMatrixFloat;
+    }
+    //Jacobi sweeps write into a second buffer with the same boundary
+    else if(method == METHOD_JACOBI || method == METHOD_WAVEFRONT)
+    {
+        nextMatrix = reserveGrid(matrix->rows, matrix->cols, matrix->halo);
+        if(nextMatrix == NULL)
+        {
+            printf("Unable to allocate a second %d square array\n",
+                    matrix->rows);
+            failed = 1;
+        }
+        else
+            touchSections(pool, nextMatrix, matrix);
+        threadFunct = (method == METHOD_JACOBI) ? &calcMatrixJacobi
+                : &calcMatrixWavefront;
+    }
+    else if(method == METHOD_RED_BLACK || method == METHOD_SOR)
+        threadFunct = &calcMatrixRedBlack;
+    else if(method == METHOD_VCYCLE || method == METHOD_FMG)
+    {
+        levelCount = countLevels(matrix->rows, matrix->cols);
+        levels = createLevels(levelCount, matrix->rows, matrix->cols, 1,
+                1);
+        if(levels == NULL)
+        {
+            printf("Unable to allocate %d multigrid levels of a %dx%d "
+                    "array\n", levelCount, matrix->rows, matrix->cols);
+            failed = 1;
+        }
+        else
+            levels[0].u = matrix;
+        threadFunct = &calcMatrixMultigrid;
+    }
+    //Red-black is SOR with no over-relaxation
+    if(method != METHOD_SOR)
+        omega = 1;
+    //Neumann edges, sources and obstacles change the update itself
+    if(!failed && needsStencil(opts))
+    {
+        stencil = createStencil(matrix, opts, 0, 0);
+        if(stencil == NULL)
+        {
+            printf("Unable to allocate the update terms of a %dx%d array\n",
+                    matrix->rows, matrix->cols);
+            failed = 1;
+        }
+    }
+    
+    //Only the legacy Gauss-Seidel sweeps lock the rows next to a border
+    if(!failed && method == METHOD_GAUSS_SEIDEL)
+    {
+        mutexes = malloc((sections+1) * sizeof(pthread_mutex_t));
+        if(mutexes == NULL)
+        {
+            printf("Unable to allocate %d mutexes\n", sections+1);
+            failed = 1;
+        }
+        else
+            for (i=0;i<sections+1;i++) 
+                pthread_mutex_init(&mutexes[i], NULL);
+    }
+    
+    //Allocate boundaries of each threads processing area
+    if(!failed)
+    {
+        borders = allocateSections(sections, arrayRows);
+        failed = (borders == NULL);
+    }
+    
+    //Tiles only pay for themselves when there is another thread to share
+    //them with
+    if(!failed && opts->schedule == SCHEDULE_TILES && sections > 1
+            && opts->dtype == ELEMENT_DOUBLE && (method == METHOD_JACOBI
+            || method == METHOD_RED_BLACK || method == METHOD_SOR))
+    {
+        tiles = createTileSchedule(borders, sections, matrix->cols);
+        if(tiles == NULL)
+        {
+            printf("Unable to allocate tiles for a %dx%d array\n",
+                    matrix->rows, matrix->cols);
+            failed = 1;
+        }
+    }
+    else if(!failed && opts->schedule == SCHEDULE_NEIGHBOURS && sections > 1
+            && opts->dtype == ELEMENT_DOUBLE && (method == METHOD_JACOBI
+            || method == METHOD_RED_BLACK || method == METHOD_SOR))
+    {
+        flags = createBandFlags(sections);
+        if(flags == NULL)
+        {
+            printf("Unable to allocate flags for %d threads\n", sections);
+            failed = 1;
+        }
+    }
+    
+    //Dynamically generate argument structs for each thread, zeroed so the
+    //levels and tile rows of every thread can be freed however far this got
+    if(!failed)
+    {
+        allArguments = calloc(sections, sizeof(struct argumentsForFunct));
+        if(allArguments == NULL)
+        {
+            printf("Unable to allocate arguments for %d threads\n",
+                    sections);
+            failed = 1;
+        }
+    }
+    for(i=0; !failed && i<sections; i++){
+        (allArguments+i)->section = i;
+        (allArguments+i)->sections = sections;
+        (allArguments+i)->myMatrix = matrix;
+        (allArguments+i)->nextMatrix = nextMatrix;
+        (allArguments+i)->result = matrix;
+        (allArguments+i)->pool = pool;
+        (allArguments+i)->mutexes = mutexes;
+        (allArguments+i)->traceThread = solver->traceThread + i;
+        (allArguments+i)->tiles = tiles;
+        (allArguments+i)->flags = flags;
+        (allArguments+i)->phases = 0;
+        (allArguments+i)->checks = 0;
+        (allArguments+i)->pending = 0;
+        (allArguments+i)->stencil = stencil;
+        (allArguments+i)->kernels = (stencil != NULL) ? &stencilKernels
+                : &plainKernels;
+        memset(&(allArguments+i)->stats, 0, sizeof(struct tileStats));
+        (allArguments+i)->startPointCol = borders[(allArguments+i)->section];
+        (allArguments+i)->endPointCol = borders[(allArguments+ i)->section+1];
+        (allArguments+i)->threadPrecision = opts->precision;
+        (allArguments+i)->test = *test;
+        (allArguments+i)->omega = omega;
+        (allArguments+i)->blockSweeps = opts->blockSweeps;
+        (allArguments+i)->checkInterval = opts->checkInterval;
+        (allArguments+i)->maxIterations = opts->maxIterations;
+        (allArguments+i)->levelCount = levelCount;
+        (allArguments+i)->schedule = (method == METHOD_FMG) ? MG_FMG
+                : MG_VCYCLE;
+        (allArguments+i)->levels = NULL;
+        if(levels != NULL)
+        {
+            (allArguments+i)->levels = malloc(levelCount*sizeof(struct mgLevel));
+            if((allArguments+i)->levels == NULL)
+            {
+                printf("Unable to allocate %d levels for thread %d\n",
+                        levelCount, i);
+                failed = 1;
+            }
+            else
+                memcpy((allArguments+i)->levels, levels,
+                        levelCount*sizeof(struct mgLevel));
+        }
+        //Each wavefront thread keeps a block of tile rows (see wavefront.h)
+        (allArguments+i)->wavefront = NULL;
+        if(threadFunct == &calcMatrixWavefront)
+        {
+            (allArguments+i)->wavefront = createWavefront(opts->blockSweeps,
+                    matrix->cols);
+            if((allArguments+i)->wavefront == NULL)
+            {
+                printf("Unable to allocate tile rows for thread %d\n", i);
+                failed = 1;
+            }
+        }
+        (allArguments+i)->arrayRows = arrayRows;
+        (allArguments+i)->floatMatrix = floatMatrix;
+        (allArguments+i)->floatNext = floatNext;
+        (allArguments+i)->rhs = rhs;
+    }
+    
+    
+    //Split every multigrid level into bands, using as many threads as the
+    //level has interior rows
+    for(l = 0; !failed && l < levelCount; l++)
+    {
+        int active = levels[l].rows-2 < sections ? levels[l].rows-2 : sections;
+        int *levelBorders = allocateSections(active, levels[l].rows);
+        if(levelBorders == NULL)
+        {
+            failed = 1;
+            break;
+        }
+        for(i = 0; i < sections; i++)
+        {
+            struct mgLevel *mine = &(allArguments+i)->levels[l];
+            mine->startRow = (i < active) ? levelBorders[i] : 0;
+            mine->endRow = (i < active) ? levelBorders[i+1] : 0;
+        }
+        free(levelBorders);
+    }
+    
+    //Run every section on the pool's threads
+    if(!failed)
+    {
+        runPool(pool, threadFunct, allArguments,
+                sizeof(struct argumentsForFunct));
+        
+        //Every thread ran the same number of sweeps, so agree on the result
+        if(allArguments->result != matrix)
+            touchSections(pool, matrix, allArguments->result);
+        iterations = allArguments->iterations;
+        *converged = allArguments->converged;
+        *test = allArguments->test;
+        for(i = 0; i < sections; i++)
+        {
+            solver->stats[i].tiles += (allArguments+i)->stats.tiles;
+            solver->stats[i].stolen += (allArguments+i)->stats.stolen;
+            solver->stats[i].busy += (allArguments+i)->stats.busy;
+            solver->stats[i].waiting += (allArguments+i)->stats.waiting;
+        }
+        if(stencil != NULL)
+            finishConditions(matrix, opts, 0, 0);
+    }
+    freeStencil(stencil);
+    freeTileSchedule(tiles);
+    freeBandFlags(flags);
+    freeGrid(nextMatrix);
+    freeGridFloat(floatMatrix);
+    freeGridFloat(floatNext);
+    freeGridFloat(rhs);
+    if(allArguments != NULL)
+        for(i = 0; i < sections; i++)
+        {
+            free((allArguments+i)->levels);
+            freeWavefront((allArguments+i)->wavefront);
+        }
+    if(levels != NULL)
+        freeLevels(levels, levelCount);
+    if(mutexes != NULL)
+    {
+        for(i = 0; i < sections+1; i++)
+            pthread_mutex_destroy(&mutexes[i]);
+        free(mutexes);
+    }
+    free(borders);
+    free(allArguments);
+    return iterations;
+}
+
+//createSolver
+//INPUT: Threads to solve with, the calling thread included (threads),
+//       processor to pin each thread to (cpus, NULL to leave them unpinned)
+//PROC:  Starts the pool of threads (see createPool) and gives each thread
+//       a pool of its own for the grids it solves alone
+//OUT:   Pointer to the solver (NULL on failure)
+struct solver *createSolver(int threads, const int *cpus)
+{
+    struct solver *solver = calloc(1, sizeof(struct solver));
+    int i = 0;
+    if(solver == NULL)
+        return NULL;
+    solver->pool = createPool(threads, cpus);
+    if(solver->pool == NULL)
+    {
+        free(solver);
+        return NULL;
+    }
+    solver->solo = calloc(threads, sizeof(struct solver));
+    solver->stats = calloc(threads, sizeof(struct tileStats));
+    if(solver->solo == NULL || solver->stats == NULL)
+    {
+        freeSolver(solver);
+        return NULL;
+    }
+    //A pool of one starts no threads, its task runs on the caller
+    for(i = 0; i<threads; i++)
+    {
+        solver->solo[i].pool = createPool(1, NULL);
+        solver->solo[i].traceThread = i;
+        solver->solo[i].stats = &solver->stats[i];
+        if(solver->solo[i].pool == NULL)
+        {
+            freeSolver(solver);
+            return NULL;
+        }
+    }
+    return solver;
+}
+
+
+//solverThreads
+//INPUT: Solver (solver)
+//OUT:   Number of threads solving, the calling thread included
+int solverThreads(const struct solver *solver)
+{
+    return poolThreads(solver->pool);
+}
+
+
+//interiorCells
+//INPUT: Grid (matrix)
+//OUT:   Cells a sweep of the grid updates
+static long interiorCells(const struct grid *matrix)
+{
+    return (long)(matrix->rows-2) * (matrix->cols-2);
+}
+
+
+//compareProblems
+//INPUT: Two entries of an array of problem pointers (a, b)
+//OUT:   Negative if a's grid is larger than b's, so qsort puts the largest
+//       grids first
+static int compareProblems(const void *a, const void *b)
+{
+    long cellsA = interiorCells((*(struct problem *const *)a)->matrix);
+    long cellsB = interiorCells((*(struct problem *const *)b)->matrix);
+    return (cellsA < cellsB) - (cellsA > cellsB);
+}
+
+
+//solveBatch
+//INPUT: Solver (solver), grids to solve (problems, count of them), solver
+//       parameters used for every grid (opts)
+//PROC:  Sets up each grid's convergence test, then solves the grids with
+//       at least SOLVER_SPLIT_CELLS interior cells one at a time across
+//       every thread. The others are shared out whole, largest first,
+//       each thread taking the next grid as soon as it is free. A grid
+//       that cannot be solved is marked failed and left as it was, the
+//       rest of the batch carrying on
+//OUT:   N/A (each problem holds its solution, sweeps and whether it
+//       converged or failed)
+void solveBatch(struct solver *solver, struct problem *problems, int count,
+        const struct options *opts)
+{
+    int threads = poolThreads(solver->pool);
+    int small = 0;
+    int i = 0;
+    atomic_int next;
+    if(count < 1)
+        return;
+    struct problem **order = malloc(count * sizeof(struct problem *));
+    struct batchArgs *allArguments = malloc(threads*sizeof(struct batchArgs));
+    for(i = 0; i<count; i++)
+    {
+        initConvergence(&problems[i].test, opts);
+        problems[i].iterations = 0;
+        problems[i].converged = 0;
+        problems[i].failed = (order == NULL || allArguments == NULL);
+    }
+    if(order == NULL || allArguments == NULL)
+    {
+        printf("Unable to allocate a batch of %d grids\n", count);
+        free(allArguments);
+        free(order);
+        return;
+    }
+    for(i = 0; i<count; i++)
+    {
+        if(threads > 1
+                && interiorCells(problems[i].matrix) < SOLVER_SPLIT_CELLS)
+            order[small++] = &problems[i];
+        else
+            solveProblem(solver, &problems[i], opts);
+    }
+    
+    //The last grids taken are the quickest, so threads finish together
+    qsort(order, small, sizeof(struct problem *), &compareProblems);
+    atomic_init(&next, 0);
+    for(i = 0; i<threads; i++)
+    {
+        (allArguments+i)->solo = &solver->solo[i];
+        (allArguments+i)->order = order;
+        (allArguments+i)->count = small;
+        (allArguments+i)->next = &next;
+        (allArguments+i)->opts = opts;
+    }
+    if(small > 0)
+        runPool(solver->pool, &batchWorker, allArguments,
+                sizeof(struct batchArgs));
+    free(allArguments);
+    free(order);
+}
+
+
+//batchWorker (thread function)
+//INPUT: struct of arguments unique to the thread being used (argsStruct)
+//PROC:  Takes small grids of the batch in turn and solves each alone
+//OUT:   N/A (returns once every grid has been taken)
+static void *batchWorker(void *argsStruct)
+{
+    struct batchArgs *args = (struct batchArgs*)argsStruct;
+    int k = 0;
+    while((k = atomic_fetch_add(args->next, 1)) < args->count)
+        solveProblem(args->solo, args->order[k], args->opts);
+    return NULL;
+}
+
+
+//solveProblem
+//INPUT: Solver (solver), grid of a batch (problem), solver parameters (opts)
+//PROC:  Solves the grid, marking it failed if the solve could not be set up
+//OUT:   N/A (problem holds the result)
+static void solveProblem(struct solver *solver, struct problem *problem,
+        const struct options *opts)
+{
+    int iterations = solveGrid(solver, problem->matrix, opts, &problem->test,
+            &problem->converged);
+    problem->failed = (iterations < 0);
+    problem->iterations = problem->failed ? 0 : iterations;
+}
+
+
+//resetSolverStats
+//INPUT: Solver not in use by any solve (solver)
+//PROC:  Zeroes the work recorded for every thread
+void resetSolverStats(struct solver *solver)
+{
+    memset(solver->stats, 0, poolThreads(solver->pool)
+            * sizeof(struct tileStats));
+}
+
+
+//printSolverStats
+//INPUT: Solver (solver)
+//PROC:  Prints the tiles each thread swept, how many it stole and the time
+//       it spent sweeping and waiting since resetSolverStats, then how far
+//       the busiest thread was above the mean. Only jacobi, red-black and
+//       sor sweeps record their work
+//OUT:   N/A
+void printSolverStats(const struct solver *solver)
+{
+    int threads = poolThreads(solver->pool);
+    double busy = 0;
+    double waiting = 0;
+    double most = 0;
+    int i = 0;
+    for(i = 0; i<threads; i++)
+    {
+        busy += solver->stats[i].busy;
+        waiting += solver->stats[i].waiting;
+        if(solver->stats[i].busy > most)
+            most = solver->stats[i].busy;
+    }
+    if(busy <= 0)
+        return;
+    printf("Thread   tiles  stolen  busy (s)  waiting (s)\n");
+    for(i = 0; i<threads; i++)
+        printf("%6d  %6ld  %6ld  %8.4f  %11.4f\n", i,
+                solver->stats[i].tiles, solver->stats[i].stolen,
+                solver->stats[i].busy, solver->stats[i].waiting);
+    printf("Load imbalance: busiest thread %.1f%% above the mean, %.1f%% of "
+            "thread time spent waiting\n", 100 * (most * threads / busy - 1),
+            100 * waiting / (busy + waiting));
+}
+
+
+//freeSolver
+//INPUT: Solver not in use by any solve (solver), may be part set up
+//PROC:  Stops the threads and frees the solver
+void freeSolver(struct solver *solver)
+{
+    int i = 0;
+    if(solver == NULL)
+        return;
+    if(solver->solo != NULL)
+        for(i = 0; i<poolThreads(solver->pool); i++)
+            freePool(solver->solo[i].pool);
+    free(solver->solo);
+    free(solver->stats);
+    freePool(solver->pool);
+    free(solver);
+}
+
+
+//calcMatrix (thread function)
+//INPUT: struct of arguments unique to the thread being used (argsStruct)
+//PROC:  Calculates the value of a given segment of the matrix
+//OUT:   N/A (the required section of the matrix is processed)
+static void *calcMatrix (void *argsStruct)
+{
+    // Counter variables for function
+    int a = 0;
+    int b = 0;  
+    
+    //Separate out struct elements
+    int startPoint = ((struct argumentsForFunct*)argsStruct)->startPointCol;
+    int endPoint = ((struct argumentsForFunct*)argsStruct)->endPointCol;
+    struct grid *myMatrix = ((struct argumentsForFunct*)argsStruct)->myMatrix;
+    int section = ((struct argumentsForFunct*)argsStruct)->section;
+    int sections = ((struct argumentsForFunct*)argsStruct)->sections; 
+    double threadPrecision = ((struct argumentsForFunct*)argsStruct)->threadPrecision;
+    int arrayRows = ((struct argumentsForFunct*)argsStruct)->arrayRows;
+    struct pool *pool = ((struct argumentsForFunct*)argsStruct)->pool;
+    pthread_mutex_t *mutexes = ((struct argumentsForFunct*)argsStruct)->mutexes;
+    int iterations = 0;
+    int done = 0;
+    printf("\nThread %d has started and has the following properties \n "
+                "Section: %d\nstartPoint: %d\nendPoint: %d\nprecision: %lf\n"
+                "array total rows: %d\ntotal threads: %d\n\n", section, section,
+                startPoint, endPoint, threadPrecision, arrayRows, sections);
+    TRACE_THREAD(0, ((struct argumentsForFunct*)argsStruct)->traceThread);
+    do
+    {
+        double sweepDelta = 0;
+        double sweepStart = TRACE_NOW();
+    // Iterate through each element in allocated area
+    for(a = startPoint; a<endPoint; a++)
+    { 
+        //check if calc uses the bottom boundary and not the actual border
+        if((a == startPoint) & (section!= 0)) 
+        {
+            
+            TRACE_LOCK(&mutexes[section]);
+            //printf("Thread %d has locked row %d\n", section, a); 
+            
+            double *up = GRID_ROW(myMatrix, a-1);
+            double *row = GRID_ROW(myMatrix, a);
+            double *down = GRID_ROW(myMatrix, a+1);
+            for(b = 1; b<myMatrix->cols-1; b++){
+                double oldValue = row[b];
+                row[b] = (up[b] + row[b-1] + down[b] + row[b+1]) / 4;
+                //printf("Thread %d, has accessed row %d col %d\n", section, a, b);
+                if(fabs(oldValue - row[b]) > sweepDelta)
+                    sweepDelta = fabs(oldValue - row[b]);
+            }
+            pthread_mutex_unlock(&mutexes[section]);
+            //printf("Thread %d has unlocked row %d\n", section, a); 
+        }
+        //check if calc uses the bottom boundary and not the actual border
+        else if((a+1 == endPoint) & (section!= arrayRows)) 
+        {
+            //printf("Thread %d, wants to access row %d\n", section, a+1);
+            TRACE_LOCK(&mutexes[section+1]);
+            //printf("Thread %d has locked row %d\n", section, a+1); 
+            
+            double *up = GRID_ROW(myMatrix, a-1);
+            double *row = GRID_ROW(myMatrix, a);
+            double *down = GRID_ROW(myMatrix, a+1);
+            for(b = 1; b<myMatrix->cols-1; b++){
+                double oldValue = row[b];
+                row[b] = (up[b] + row[b-1] + down[b] + row[b+1]) / 4;
+                //printf("Thread %d, has accessed row %d col %d\n", section, a, b);
+                if(fabs(oldValue - row[b]) > sweepDelta)
+                    sweepDelta = fabs(oldValue - row[b]);
+            }
+            
+            pthread_mutex_unlock(&mutexes[section+1]);
+            //printf("Thread %d has unlocked row %d\n", section, a+1); 
+        }
+        else
+        {
+            double *up = GRID_ROW(myMatrix, a-1);
+            double *row = GRID_ROW(myMatrix, a);
+            double *down = GRID_ROW(myMatrix, a+1);
+            for(b = 1; b<myMatrix->cols-1; b++){
+                double oldValue = row[b];
+                row[b] = (up[b] + row[b-1] + down[b] + row[b+1]) / 4;
+                //printf("Thread %d, has accessed r %d c %d\n", section, a, b);
+                if(fabs(oldValue - row[b]) > sweepDelta)
+                    sweepDelta = fabs(oldValue - row[b]);
+            }
+        }      
+    }
+    iterations++;
+    TRACE_SPAN("sweep", sweepStart);
+    //Every thread has finished the sweep once the barrier opens
+    double waitStart = TRACE_NOW();
+    if(checkDue(iterations, ((struct argumentsForFunct*)argsStruct)->checkInterval,
+            ((struct argumentsForFunct*)argsStruct)->maxIterations))
+        done = checkConvergence(argsStruct, sweepDelta, myMatrix);
+    else
+        poolBarrier(pool, section);
+    TRACE_SPAN("barrier", waitStart);
+    }while(!done && underLimit(iterations,
+            ((struct argumentsForFunct*)argsStruct)->maxIterations));
+    ((struct argumentsForFunct*)argsStruct)->iterations = iterations;
+    ((struct argumentsForFunct*)argsStruct)->converged = done;
+    return NULL;
+}
+
+
+//calcMatrixJacobi (thread function)
+//INPUT: struct of arguments unique to the thread being used (argsStruct)
+//PROC:  Calculates the given segment of the matrix with Jacobi sweeps,
+//       reading one buffer and writing the other so every row vectorises
+//       and no row needs locking. With tiles, takes tiles from anywhere in
+//       the matrix instead until every one has been swept. With flags,
+//       only waits for the neighbouring segments between sweeps
+//OUT:   N/A (args->result points at the buffer holding the final values)
+static void *calcMatrixJacobi (void *argsStruct)
+{
+    struct argumentsForFunct *args = (struct argumentsForFunct*)argsStruct;
+    struct grid *src = args->myMatrix;
+    struct grid *dst = args->nextMatrix;
+    int section = args->section;
+    int iterations = 0;
+    int done = 0;
+    TRACE_THREAD(0, args->traceThread);
+    
+    do
+    {
+        double sweepDelta = 0;
+        double sweepStart = TRACE_NOW();
+        double busyStart = wallSeconds();
+        if(args->tiles != NULL)
+            sweepDelta = sweepTiles(args, src, dst, 0, 1);
+        else
+            sweepDelta = sweepBand(args, src, dst, 0, 1);
+        
+        //Next sweep reads what this one wrote, once every thread is done
+        struct grid *swap = src;
+        src = dst;
+        dst = swap;
+        iterations++;
+        TRACE_SPAN("sweep", sweepStart);
+        double waitStart = TRACE_NOW();
+        double idleStart = wallSeconds();
+        args->stats.busy += idleStart - busyStart;
+        if(args->flags != NULL)
+            done = checkNeighbours(args, sweepDelta, src, iterations);
+        else if(checkDue(iterations, args->checkInterval, args->maxIterations))
+            done = checkConvergence(args, sweepDelta, src);
+        else
+            poolBarrier(args->pool, section);
+        args->stats.waiting += wallSeconds() - idleStart;
+        TRACE_SPAN("barrier", waitStart);
+    }while(!done //While thread precision is too low
+            && underLimit(iterations, args->maxIterations));
+    args->result = src;
+    args->iterations = iterations;
+    args->converged = done;
+    return NULL;
+}
+
+
+//calcMatrixWavefront (thread function)
+//INPUT: struct of arguments unique to the thread being used (argsStruct)
+//PROC:  As calcMatrixJacobi, but takes each cache sized tile of the
+//       thread's segment blockSweeps sweeps forward at a time. Threads only
+//       meet, and check convergence, between blocks, so a converged solve
+//       runs a whole number of blocks. The last block is cut short so no
+//       more than maxIterations sweeps are run
+//OUT:   N/A (args->result points at the buffer holding the final values)
+static void *calcMatrixWavefront (void *argsStruct)
+{
+    struct argumentsForFunct *args = (struct argumentsForFunct*)argsStruct;
+    struct grid *src = args->myMatrix;
+    struct grid *dst = args->nextMatrix;
+    int iterations = 0;
+    int done = 0;
+    struct wavefront *w = args->wavefront;
+    TRACE_THREAD(0, args->traceThread);
+    
+    do
+    {
+        //Reads rows of src beyond the segment, but only writes dst
+        double sweepStart = TRACE_NOW();
+        int sweeps = args->blockSweeps;
+        if(args->maxIterations > 0 && args->maxIterations - iterations < sweeps)
+            sweeps = args->maxIterations - iterations;
+        double blockDelta = wavefrontSweeps(w, src, dst, args->startPointCol,
+                args->endPointCol, sweeps);
+        
+        //Next block reads what this one wrote, once every thread is done
+        struct grid *swap = src;
+        src = dst;
+        dst = swap;
+        iterations += sweeps;
+        TRACE_SPAN("sweep", sweepStart);
+        double waitStart = TRACE_NOW();
+        done = checkConvergence(args, blockDelta, src);
+        TRACE_SPAN("barrier", waitStart);
+    }while(!done //While thread precision is too low
+            && underLimit(iterations, args->maxIterations));
+    args->result = src;
+    args->iterations = iterations;
+    args->converged = done;
+    return NULL;
+}
+
+
+//calcMatrixRedBlack (thread function)
+//INPUT: struct of arguments unique to the thread being used (argsStruct)
+//PROC:  Calculates the given segment of the matrix in place, updating all
+//       red cells, then all black cells. Red cells only read black cells
+//       and vice versa, so no row needs locking and the result does not
+//       depend on the number of threads, or on which thread sweeps which
+//       tile. Each update is over-relaxed by omega, which every thread
+//       adjusts identically when adaptive. With flags, only waits for the
+//       neighbouring segments between colours
+//OUT:   N/A (the required section of the matrix is processed)
+static void *calcMatrixRedBlack (void *argsStruct)
+{
+    struct argumentsForFunct *args = (struct argumentsForFunct*)argsStruct;
+    struct grid *myMatrix = args->myMatrix;
+    int section = args->section;
+    int iterations = 0;
+    int done = 0;
+    struct omegaEstimate estimate;
+    initOmega(&estimate, args->omega, myMatrix->rows, myMatrix->cols);
+    TRACE_THREAD(0, args->traceThread);
+    
+    do
+    {
+        double omega = estimate.omega;
+        double sweepStart = TRACE_NOW();
+        double busyStart = wallSeconds();
+        double sweepDelta = (args->tiles != NULL)
+                ? sweepTiles(args, myMatrix, NULL, COLOUR_RED, omega)
+                : sweepBand(args, myMatrix, NULL, COLOUR_RED, omega);
+        TRACE_SPAN("sweep", sweepStart);
+        //Black cells need every neighbouring red cell finished
+        double waitStart = TRACE_NOW();
+        double idleStart = wallSeconds();
+        args->stats.busy += idleStart - busyStart;
+        if(args->flags != NULL)
+            meetNeighbours(args);
+        else
+            poolBarrier(args->pool, section);
+        busyStart = wallSeconds();
+        args->stats.waiting += busyStart - idleStart;
+        TRACE_SPAN("barrier", waitStart);
+        
+        sweepStart = TRACE_NOW();
+        double blackDelta = (args->tiles != NULL)
+                ? sweepTiles(args, myMatrix, NULL, COLOUR_BLACK, omega)
+                : sweepBand(args, myMatrix, NULL, COLOUR_BLACK, omega);
+        if(blackDelta > sweepDelta)
+            sweepDelta = blackDelta;
+        iterations++;
+        TRACE_SPAN("sweep", sweepStart);
+        //One barrier both finishes the sweep and agrees on its largest
+        //change. Adaptive omega needs the change after every sweep, so
+        //meets every thread even with flags until the estimate settles
+        waitStart = TRACE_NOW();
+        idleStart = wallSeconds();
+        args->stats.busy += idleStart - busyStart;
+        int adapting = !estimate.frozen;
+        if(adapting)
+            nextOmega(&estimate, poolReduceMax(args->pool, section,
+                    sweepDelta));
+        if(args->flags != NULL)
+            done = checkNeighbours(args, sweepDelta, myMatrix, iterations);
+        else if(checkDue(iterations, args->checkInterval, args->maxIterations))
+            done = checkConvergence(args, sweepDelta, myMatrix);
+        else if(!adapting)
+            poolBarrier(args->pool, section);
+        args->stats.waiting += wallSeconds() - idleStart;
+        TRACE_SPAN("barrier", waitStart);
+    }while(!done //While thread precision is too low
+            && underLimit(iterations, args->maxIterations));
+    args->iterations = iterations;
+    args->converged = done;
+    return NULL;
+}
+
+
+//calcMatrixMultigrid (thread function)
+//INPUT: struct of arguments unique to the thread being used (argsStruct)
+//PROC:  Runs multigrid cycles on the thread's band of every level, meeting
+//       the other threads at the barrier wherever a level's rows from
+//       another band are needed. Thread 0 solves the coarsest level
+//OUT:   N/A (the matrix is processed)
+static void *calcMatrixMultigrid (void *argsStruct)
+{
+    struct argumentsForFunct *args = (struct argumentsForFunct*)argsStruct;
+    struct threadTeam team;
+    struct mgOps ops;
+    
+    team.pool = args->pool;
+    team.section = args->section;
+    ops.context = &team;
+    ops.exchange = &threadExchange;
+    ops.reduceMax = &threadReduceMax;
+    ops.reduceSum = &threadReduceSum;
+    ops.lead = (args->section == 0);
+    ops.agglomerateLevel = args->levelCount;
+    ops.agglomerate = NULL;
+    TRACE_THREAD(0, args->traceThread);
+    
+    double residual = 0;
+    args->iterations = solveMultigrid(args->levels, args->levelCount, &ops,
+            args->schedule, &args->test, args->maxIterations, &residual);
+    args->converged = hasConverged(&args->test, residual);
+    return NULL;
+}
+
+
+//calcMatrixFloat (thread function)
+//INPUT: struct of arguments unique to the thread being used (argsStruct)
+//PROC:  For ELEMENT_FLOAT, rounds the thread's rows to single precision,
+//       sweeps them until the largest change is within precision and
+//       copies the result back.
+//       For ELEMENT_MIXED, repeatedly works out the residual of the double
+//       precision matrix, stops once its norm meets the convergence test,
+//       and otherwise sweeps a single precision correction from zero (see
+//       mixed.h) and adds it to the matrix. Sweeps of every correction
+//       count towards the sweeps allowed
+//OUT:   N/A (the required section of the matrix is processed)
+static void *calcMatrixFloat (void *argsStruct)
+{
+    struct argumentsForFunct *args = (struct argumentsForFunct*)argsStruct;
+    struct grid *myMatrix = args->myMatrix;
+    struct gridf *result = NULL;
+    struct convergence inner;
+    int section = args->section;
+    int cols = myMatrix->cols;
+    int iterations = 0;
+    int done = 0;
+    //The first and last threads also write the boundary and halo rows
+    int firstRow = (section == 0) ? -myMatrix->halo : args->startPointCol;
+    int lastRow = (section == args->sections-1)
+            ? myMatrix->rows + myMatrix->halo : args->endPointCol;
+    TRACE_THREAD(0, args->traceThread);
+    
+    if(args->rhs == NULL)
+    {
+        narrowRows(args->floatMatrix, myMatrix, firstRow, lastRow);
+        if(args->floatNext != NULL)
+            copyGridFloatRows(args->floatNext, args->floatMatrix, firstRow,
+                    lastRow);
+        poolBarrier(args->pool, section);
+        iterations = relaxFloat(args, NULL, &args->test, args->maxIterations,
+                &done, &result);
+        widenRows(myMatrix, result, args->startPointCol, args->endPointCol, 1,
+                cols-1);
+        args->iterations = iterations;
+        args->converged = done;
+        return NULL;
+    }
+    
+    //Corrections are zero on the boundary, and start from zero inside
+    copyGridFloatRows(args->floatMatrix, NULL, firstRow, lastRow);
+    if(args->floatNext != NULL)
+        copyGridFloatRows(args->floatNext, NULL, firstRow, lastRow);
+    for(;;)
+    {
+        //Residuals read the rows the other threads have just corrected
+        double refineStart = TRACE_NOW();
+        poolBarrier(args->pool, section);
+        double value = residualRows(myMatrix, args->rhs, args->startPointCol,
+                args->endPointCol, 1, cols-1, args->test.norm);
+        if(args->test.norm == NORM_L2)
+            value = poolReduceSum(args->pool, section, value);
+        else
+            value = poolReduceMax(args->pool, section, value);
+        value = finishNorm(&args->test, value);
+        TRACE_SPAN("refine", refineStart);
+        if(section == 0)
+            TRACE_COUNTER("norm", value);
+        done = hasConverged(&args->test, value);
+        if(done || !underLimit(iterations, args->maxIterations))
+            break;
+        
+        int innerDone = 0;
+        initCorrection(&inner, &args->test, value);
+        iterations += relaxFloat(args, args->rhs, &inner,
+                (args->maxIterations == 0) ? 0
+                : args->maxIterations - iterations, &innerDone, &result);
+        //Every thread has finished sweeping, so the correction's rows can
+        //be reset once added
+        refineStart = TRACE_NOW();
+        addCorrection(myMatrix, result, args->startPointCol,
+                args->endPointCol, 1, cols-1);
+        copyGridFloatRows(args->floatMatrix, NULL, args->startPointCol,
+                args->endPointCol);
+        if(args->floatNext != NULL)
+            copyGridFloatRows(args->floatNext, NULL, args->startPointCol,
+                    args->endPointCol);
+        TRACE_SPAN("refine", refineStart);
+    }
+    args->iterations = iterations;
+    args->converged = done;
+    return NULL;
+}
+
+
+//relaxFloat
+//INPUT: struct of arguments unique to the thread (argsStruct), right hand
+//       side added to every update (rhs, NULL for none), test applied to
+//       the largest change (test), sweeps allowed (maxIterations, 0 for no
+//       limit), where to report whether the test was met (converged) and
+//       where to leave the float grid holding the final values (result)
+//PROC:  Runs single precision Jacobi sweeps of the thread's rows of
+//       args->floatMatrix (using args->floatNext), or red-black sweeps
+//       over-relaxed by args->omega when there is no second buffer
+//OUT:   Number of sweeps taken, the same on every thread
+static int relaxFloat(void *argsStruct, const struct gridf *rhs,
+        struct convergence *test, int maxIterations, int *converged,
+        struct gridf **result)
+{
+    struct argumentsForFunct *args = (struct argumentsForFunct*)argsStruct;
+    struct gridf *src = args->floatMatrix;
+    struct gridf *dst = args->floatNext;
+    int section = args->section;
+    int iterations = 0;
+    int done = 0;
+    int a = 0;
+    struct omegaEstimate estimate;
+    initOmega(&estimate, args->omega, src->rows, src->cols);
+    
+    do
+    {
+        double sweepDelta = 0;
+        double sweepStart = TRACE_NOW();
+        if(dst != NULL)
+        {
+            for(a = args->startPointCol; a<args->endPointCol; a++)
+            {
+                double rowDelta = jacobiRowFloat(GRID_ROW(src, a-1),
+                        GRID_ROW(src, a), GRID_ROW(src, a+1),
+                        (rhs != NULL) ? GRID_ROW(rhs, a) : NULL,
+                        GRID_ROW(dst, a), src->cols);
+                if(rowDelta > sweepDelta)
+                    sweepDelta = rowDelta;
+            }
+            struct gridf *swap = src;
+            src = dst;
+            dst = swap;
+        }
+        else
+        {
+            sweepDelta = sweepColourFloat(src, rhs, args->startPointCol,
+                    args->endPointCol, COLOUR_RED, estimate.omega);
+            TRACE_SPAN("sweep", sweepStart);
+            double waitStart = TRACE_NOW();
+            poolBarrier(args->pool, section);
+            TRACE_SPAN("barrier", waitStart);
+            sweepStart = TRACE_NOW();
+            double blackDelta = sweepColourFloat(src, rhs,
+                    args->startPointCol, args->endPointCol, COLOUR_BLACK,
+                    estimate.omega);
+            if(blackDelta > sweepDelta)
+                sweepDelta = blackDelta;
+        }
+        iterations++;
+        TRACE_SPAN("sweep", sweepStart);
+        //One reduction finishes the sweep, feeds adaptive omega and, when
+        //due, the test
+        double waitStart = TRACE_NOW();
+        double largest = poolReduceMax(args->pool, section, sweepDelta);
+        if(!estimate.frozen)
+            nextOmega(&estimate, largest);
+        if(checkDue(iterations, args->checkInterval, maxIterations))
+            done = hasConverged(test, largest);
+        TRACE_SPAN("barrier", waitStart);
+    }while(!done && underLimit(iterations, maxIterations));
+    *converged = done;
+    *result = src;
+    return iterations;
+}
+
+
+//checkConvergence
+//INPUT: struct of arguments unique to the thread (argsStruct), largest
+//       change the thread made in the last sweep (sweepDelta), grid
+//       holding the latest values (matrix)
+//PROC:  Meets the other threads and applies the convergence test, to the
+//       largest change made anywhere or to the residual norm of the whole
+//       matrix. Residuals read the neighbouring bands, so those are only
+//       worked out once every thread has finished the sweep
+//OUT:   Non zero once the test is met, the same on every thread
+static int checkConvergence(void *argsStruct, double sweepDelta,
+        const struct grid *matrix)
+{
+    struct argumentsForFunct *args = (struct argumentsForFunct*)argsStruct;
+    struct convergence *test = &args->test;
+    double value = sweepDelta;
+    if(test->norm != NORM_DELTA)
+    {
+        poolBarrier(args->pool, args->section);
+        value = args->kernels->residual(args->stencil, matrix,
+                args->startPointCol, args->endPointCol, 1, matrix->cols-1,
+                test->norm);
+    }
+    if(test->norm == NORM_L2)
+        value = poolReduceSum(args->pool, args->section, value);
+    else
+        value = poolReduceMax(args->pool, args->section, value);
+    value = finishNorm(test, value);
+    if(args->section == 0)
+        TRACE_COUNTER("norm", value);
+    return hasConverged(test, value);
+}
+
+
+//meetNeighbours
+//INPUT: struct of arguments unique to the thread (args)
+//PROC:  Publishes that the thread has finished another phase, then waits
+//       for the threads either side to finish it too (see flags.h). Takes
+//       the place of a barrier
+//OUT:   N/A
+static void meetNeighbours(struct argumentsForFunct *args)
+{
+    args->phases++;
+    finishPhase(args->flags, args->section, args->phases);
+    waitNeighbours(args->flags, args->section, args->phases);
+}
+
+
+//checkNeighbours
+//INPUT: struct of arguments unique to the thread (args), largest change
+//       made to its band by the sweep just finished (sweepDelta), grid
+//       holding the latest values (matrix), sweeps taken (iterations)
+//PROC:  Meets the neighbouring bands after a sweep. Applies the test to
+//       the check posted after the last sweep, whose values have had this
+//       sweep to arrive, then posts this sweep's norm if a check is due.
+//       The last sweep allowed is checked straight away. Residuals read
+//       the neighbouring bands, which wait for them before sweeping again
+//OUT:   Non zero once the test is met, the same on every thread after the
+//       same sweep
+static int checkNeighbours(struct argumentsForFunct *args,
+        double sweepDelta, const struct grid *matrix, int iterations)
+{
+    struct convergence *test = &args->test;
+    double value = sweepDelta;
+    int done = 0;
+    meetNeighbours(args);
+    if(args->pending > 0)
+        done = finishNeighbourCheck(args, args->pending);
+    args->pending = 0;
+    if(done || !checkDue(iterations, args->checkInterval,
+            args->maxIterations))
+        return done;
+    if(test->norm != NORM_DELTA)
+    {
+        value = args->kernels->residual(args->stencil, matrix,
+                args->startPointCol, args->endPointCol, 1, matrix->cols-1,
+                test->norm);
+        meetNeighbours(args);
+    }
+    args->checks++;
+    postCheck(args->flags, args->section, args->checks, value);
+    if(underLimit(iterations, args->maxIterations))
+        args->pending = args->checks;
+    else
+        done = finishNeighbourCheck(args, args->checks);
+    return done;
+}
+
+
+//finishNeighbourCheck
+//INPUT: struct of arguments unique to the thread (args), check it has
+//       posted (check)
+//PROC:  Reduces the check once every band has posted it and applies the
+//       convergence test
+//OUT:   Non zero if the test is met
+static int finishNeighbourCheck(struct argumentsForFunct *args, int check)
+{
+    struct convergence *test = &args->test;
+    double value = finishNorm(test, reduceCheck(args->flags, check,
+            test->norm == NORM_L2));
+    if(args->section == 0)
+        TRACE_COUNTER("norm", value);
+    return hasConverged(test, value);
+}
+
+
+//threadExchange
+//INPUT: thread's team (context), level and grid needed (unused)
+//PROC:  Threads share every grid, so waiting for the others is enough
+static void threadExchange(void *context, struct mgLevel *level, struct grid *g)
+{
+    struct threadTeam *team = (struct threadTeam*)context;
+    double waitStart = TRACE_NOW();
+    poolBarrier(team->pool, team->section);
+    TRACE_SPAN("barrier", waitStart);
+}
+
+
+//threadReduceMax
+//INPUT: thread's team (context), value from this thread (value)
+//PROC:  Waits for the other threads at the pool's barrier
+//OUT:   Largest value passed in by any thread
+static double threadReduceMax(void *context, double value)
+{
+    struct threadTeam *team = (struct threadTeam*)context;
+    double waitStart = TRACE_NOW();
+    double largest = poolReduceMax(team->pool, team->section, value);
+    TRACE_SPAN("barrier", waitStart);
+    if(team->section == 0)
+        TRACE_COUNTER("norm", largest);
+    return largest;
+}
+
+
+//threadReduceSum
+//INPUT: thread's team (context), value from this thread (value)
+//PROC:  Waits for the other threads at the pool's barrier
+//OUT:   Sum of the values passed in by every thread
+static double threadReduceSum(void *context, double value)
+{
+    struct threadTeam *team = (struct threadTeam*)context;
+    double waitStart = TRACE_NOW();
+    double sum = poolReduceSum(team->pool, team->section, value);
+    TRACE_SPAN("barrier", waitStart);
+    return sum;
+}
+
+
+//sweepBand
+//INPUT: struct of arguments unique to the thread (args), grid to read
+//       (src), grid to write (dst, NULL to update src in place), colour
+//       of the cells to update in place (colour), over-relaxation factor
+//       (omega)
+//PROC:  Sweeps the thread's own band of rows as a single tile
+//OUT:   Largest absolute change made to any cell
+static double sweepBand(struct argumentsForFunct *args, struct grid *src,
+        struct grid *dst, int colour, double omega)
+{
+    struct tile band = {args->startPointCol, args->endPointCol, 1,
+            src->cols-1};
+    if(dst != NULL)
+        return args->kernels->jacobi(args->stencil, src, dst, &band);
+    return args->kernels->colour(args->stencil, src, &band, colour, omega);
+}
+
+
+//jacobiPlain
+//INPUT: Unused (stencil), as jacobiTile otherwise
+//OUT:   As jacobiTile, the average of the neighbours
+static double jacobiPlain(const struct stencil *stencil,
+        const struct grid *src, struct grid *dst, const struct tile *t)
+{
+    return jacobiTile(src, dst, t);
+}
+
+
+//colourPlain
+//INPUT: Unused (stencil), as colourTile otherwise
+//OUT:   As colourTile, the average of the neighbours
+static double colourPlain(const struct stencil *stencil,
+        struct grid *matrix, const struct tile *t, int colour, double omega)
+{
+    return colourTile(matrix, t, colour, omega);
+}
+
+
+//residualPlain
+//INPUT: Unused (stencil), as bandResidual otherwise
+//OUT:   As bandResidual, the residual of the average of the neighbours
+static double residualPlain(const struct stencil *stencil,
+        const struct grid *g, int startRow, int endRow, int startCol,
+        int endCol, enum convergenceNorm norm)
+{
+    return bandResidual(g, startRow, endRow, startCol, endCol, norm);
+}
+
+
+//jacobiStencil
+//INPUT: General update (stencil), as jacobiTile otherwise
+//PROC:  Applies the stencil's update to every cell of the tile
+//OUT:   Largest absolute change made to any cell
+static double jacobiStencil(const struct stencil *stencil,
+        const struct grid *src, struct grid *dst, const struct tile *t)
+{
+    double maxDelta = 0;
+    int a = 0;
+    for(a = t->startRow; a<t->endRow; a++)
+    {
+        double rowDelta = stencilJacobiRow(stencil, src, dst, a, t->startCol,
+                t->endCol);
+        if(rowDelta > maxDelta)
+            maxDelta = rowDelta;
+    }
+    return maxDelta;
+}
+
+
+//colourStencil
+//INPUT: General update (stencil), as colourTile otherwise
+//PROC:  Applies the stencil's update to the cells of one colour in the
+//       tile
+//OUT:   Largest absolute change made to any cell
+static double colourStencil(const struct stencil *stencil,
+        struct grid *matrix, const struct tile *t, int colour, double omega)
+{
+    double maxDelta = 0;
+    int a = 0;
+    for(a = t->startRow; a<t->endRow; a++)
+    {
+        double rowDelta = stencilColourRow(stencil, matrix, a, t->startCol,
+                t->endCol, 0, colour, omega);
+        if(rowDelta > maxDelta)
+            maxDelta = rowDelta;
+    }
+    return maxDelta;
+}
+
+
+//sweepColourFloat
+//INPUT: As sweepColour, on a float matrix, plus the right hand side added
+//       to every update (rhs, NULL for none)
+//PROC:  Updates the cells of one colour in the given rows
+//OUT:   Largest absolute change made to any cell
+static double sweepColourFloat(struct gridf *matrix, const struct gridf *rhs,
+        int startRow, int endRow, int colour, double omega)
+{
+    double maxDelta = 0;
+    int a = 0;
+    for(a = startRow; a<endRow; a++)
+    {
+        double rowDelta = colourRowFloat(GRID_ROW(matrix, a-1),
+                GRID_ROW(matrix, a), GRID_ROW(matrix, a+1),
+                (rhs != NULL) ? GRID_ROW(rhs, a) : NULL, matrix->cols,
+                COLOUR_FIRST(a, colour), omega);
+        if(rowDelta > maxDelta)
+            maxDelta = rowDelta;
+    }
+    return maxDelta;
+}
+
+
+//sweepTiles
+//INPUT: struct of arguments unique to the thread (args), grid to read
+//       (src), grid to write (dst, NULL to update src in place), colour
+//       of the cells to update in place (colour), over-relaxation factor
+//       (omega)
+//PROC:  Puts the thread's own tiles back on its queue, then sweeps tiles,
+//       its own first, until every tile of the phase has been taken
+//OUT:   Largest absolute change made to any cell
+static double sweepTiles(struct argumentsForFunct *args, struct grid *src,
+        struct grid *dst, int colour, double omega)
+{
+    struct tileSchedule *schedule = args->tiles;
+    int section = args->section;
+    double maxDelta = 0;
+    int t = 0;
+    resetTiles(schedule, section);
+    while((t = nextTile(schedule, section)) >= 0)
+    {
+        const struct tile *tile = &schedule->tiles[t];
+        double tileDelta = (dst != NULL)
+                ? args->kernels->jacobi(args->stencil, src, dst, tile)
+                : args->kernels->colour(args->stencil, src, tile, colour,
+                omega);
+        if(tileDelta > maxDelta)
+            maxDelta = tileDelta;
+        args->stats.tiles++;
+        if(t < schedule->owned[section] || t >= schedule->owned[section+1])
+            args->stats.stolen++;
+    }
+    return maxDelta;
+}
+
+
+//touchSections
+//INPUT: Threads that will process the grid (pool), grid to write (dst)
+//       grid of the same shape to copy (src, NULL to zero dst)
+//PROC:  Splits the rows as solveGrid does and has each thread write its
+//       own rows. The first write to a page places it on that thread's
+//       NUMA node, so the sweeps mostly read local memory. The first and
+//       last threads also write the boundary and halo rows. If the
+//       threads' arguments cannot be allocated the calling thread writes
+//       every row, which only costs the placement
+//OUT:   N/A (dst holds src, or zeroes)
+void touchSections(struct pool *pool, struct grid *dst,
+        const struct grid *src)
+{
+    int i = 0;
+    int sections = poolThreads(pool);
+    int *sectionBorders = allocateSections(sections, dst->rows);
+    struct touchArgs *allArguments = malloc(sections*sizeof(struct touchArgs));
+    if(sectionBorders == NULL || allArguments == NULL)
+    {
+        copyGridRows(dst, src, -dst->halo, dst->rows + dst->halo);
+        free(allArguments);
+        free(sectionBorders);
+        return;
+    }
+    for(i = 0; i<sections; i++)
+    {
+        (allArguments+i)->dst = dst;
+        (allArguments+i)->src = src;
+        (allArguments+i)->startRow = (i == 0) ? -dst->halo
+                : sectionBorders[i];
+        (allArguments+i)->endRow = (i == sections-1)
+                ? dst->rows + dst->halo : sectionBorders[i+1];
+    }
+    runPool(pool, &touchRows, allArguments, sizeof(struct touchArgs));
+    free(allArguments);
+    free(sectionBorders);
+}
+
+
+//touchRows (thread function)
+//INPUT: struct of arguments unique to the thread being used (argsStruct)
+//PROC:  Copies or zeroes the thread's rows of the grid
+//OUT:   N/A (the rows are written)
+static void *touchRows(void *argsStruct)
+{
+    struct touchArgs *args = (struct touchArgs*)argsStruct;
+    copyGridRows(args->dst, args->src, args->startRow, args->endRow);
+    return NULL;
+}
+
+
+//allocateSections
+//INPUT:   sections (number of sections for array to be divided in)
+//         arrayRows (size of array to be divided)
+//PROC: Take matrix dimensions and return array of row borders for each thread
+//OUTPUT: borders (array of row borders for each thread, NULL on failure)
+static int* allocateSections (int sections, int arrayRows)
+{
+    int *borders = malloc((sections+1) * sizeof(int));
+    if(borders == NULL)
+    {
+        printf("Unable to allocate borders for %d threads\n", sections);
+        return NULL;
+    }
+    
+    //Calculate quotient and extra values over the interior rows only, the
+    //boundary rows never being updated
+    int quot = (arrayRows-2) / sections;
+    int extra = (arrayRows-2) % sections;
+    int j = 0;
+    
+    borders[0] = 1;
+    
+    for (j = 0; j < sections; j++)
+    {
+        // Place next border quot ahead of current border
+        borders[j+1] = borders[j] + quot;
+        
+        //The first extra sections take one remainder row each, so bands
+        //differ by at most a row and the last ends at arrayRows-1
+        if (j < extra) 
+            borders[j+1] ++; //Increment next border value
+    }
+                  
+    //Test code print border ranges
+    //for (j = 0; j < sections+1; j++)
+        //printf("\n\nBORDERS: %d\n", borders[j]);
+    return borders;
+}
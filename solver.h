@@ -0,0 +1,54 @@
+// Re-entrant solver for one grid, or a batch of independent grids
+// Candidate Number: 11066
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "grid.h"
+#include "pool.h"
+#include "options.h"
+#include "convergence.h"
+#include "tiles.h"
+
+// Interior cells a grid of a batch needs before it is split across every
+// thread; smaller grids are solved whole, one per thread (see solveBatch)
+#define SOLVER_SPLIT_CELLS (256 * 256)
+
+//Struct holding everything a solve needs besides the grid. Solvers share
+//no state, so several can run at once
+struct solver
+{
+    struct pool *pool; // Threads shared by every solve
+    struct solver *solo; // One single threaded solver per thread of pool,
+                         // for the small grids of a batch
+    int traceThread; // Number of the first thread in the trace
+    struct tileStats *stats; // Work of each thread of pool, summed over
+                             // the solves since resetSolverStats
+};
+
+//Struct holding one grid of a batch and the result of solving it
+struct problem
+{
+    struct grid *matrix; // Boundary set and interior holding the first
+                         // guess, the solution on return
+    struct convergence test; // Set up from the options by solveBatch
+    int iterations; // Sweeps (or multigrid cycles) taken
+    int converged; // Non zero if the precision was met
+    int failed; // Non zero if the solve could not be set up (the grid is
+                // left as it was)
+};
+
+struct solver *createSolver(int threads, const int *cpus);
+int solverThreads(const struct solver *solver);
+int solveGrid(struct solver *solver, struct grid *matrix,
+        const struct options *opts, struct convergence *test,
+        int *converged);
+void solveBatch(struct solver *solver, struct problem *problems, int count,
+        const struct options *opts);
+void resetSolverStats(struct solver *solver);
+void printSolverStats(const struct solver *solver);
+void touchSections(struct pool *pool, struct grid *dst,
+        const struct grid *src);
+void freeSolver(struct solver *solver);
+
+#endif
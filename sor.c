@@ -0,0 +1,105 @@
+// Over-relaxation factor selection for SOR sweeps
+// Candidate Number: 11066
+//
+// For the 5 point Laplacian with red-black ordering the best factor is
+// 2 / (1 + sqrt(1 - mu^2)), where mu is the spectral radius of the Jacobi
+// iteration. mu is known exactly for a rectangle, and can be recovered
+// from the rate at which the largest change shrinks between sweeps.
+
+#include <math.h>
+#include "sor.h"
+
+// Sweeps with a settled convergence ratio before omega is re-estimated
+#define STEADY_SWEEPS 5
+
+// Relative change in the ratio between sweeps counted as settled
+#define STEADY_TOLERANCE 0.01
+
+// Largest factor the adaptive estimate will choose
+#define OMEGA_LIMIT 1.999
+
+
+//optimalOmega
+//INPUT: Dimensions of the grid, boundary included (rows, cols)
+//PROC:  Works out the Jacobi spectral radius of the grid's interior
+//OUT:   Over-relaxation factor giving the fastest SOR convergence
+double optimalOmega(int rows, int cols)
+{
+    double mu = (cos(M_PI / (rows-1)) + cos(M_PI / (cols-1))) / 2;
+    return 2 / (1 + sqrt(1 - mu*mu));
+}
+
+
+//initOmega
+//INPUT: Estimate to set up (estimate), requested factor (requested, a
+//       value above 0, OMEGA_OPTIMAL or OMEGA_ADAPTIVE), grid size
+//PROC:  Fixes omega for explicit and optimal requests; adaptive requests
+//       start from plain Gauss-Seidel (omega = 1) and are refined later
+//OUT:   N/A (estimate->omega is the factor for the first sweep)
+void initOmega(struct omegaEstimate *estimate, double requested, int rows,
+        int cols)
+{
+    estimate->lastDelta = 0;
+    estimate->lastRatio = 0;
+    estimate->steady = 0;
+    estimate->frozen = 1;
+    if(requested > 0)
+        estimate->omega = requested;
+    else if(requested == OMEGA_OPTIMAL)
+        estimate->omega = optimalOmega(rows, cols);
+    else
+    {
+        estimate->omega = 1;
+        estimate->frozen = 0;
+    }
+}
+
+
+//nextOmega
+//INPUT: Estimate being refined (estimate), largest change made anywhere
+//       in the grid by the sweep just finished (maxDelta)
+//PROC:  Once the ratio between successive changes (lambda) settles,
+//       recovers mu from lambda + omega - 1 = omega * mu * sqrt(lambda) and
+//       moves omega to the optimum for that mu. Stops adjusting once the
+//       estimate stops growing, or once lambda reaches omega - 1 (omega is
+//       then at or past the optimum)
+//OUT:   Factor to use for the next sweep
+double nextOmega(struct omegaEstimate *estimate, double maxDelta)
+{
+    double ratio = 0;
+    if(estimate->frozen || estimate->lastDelta == 0)
+    {
+        estimate->lastDelta = maxDelta;
+        return estimate->omega;
+    }
+
+    ratio = maxDelta / estimate->lastDelta;
+    estimate->lastDelta = maxDelta;
+    if(fabs(ratio - estimate->lastRatio) < STEADY_TOLERANCE * (1 - ratio))
+        estimate->steady++;
+    else
+        estimate->steady = 0;
+    estimate->lastRatio = ratio;
+
+    if(estimate->steady < STEADY_SWEEPS || ratio >= 1)
+        return estimate->omega;
+
+    double omega = estimate->omega;
+    if(ratio <= omega - 1)
+    {
+        estimate->frozen = 1;
+        return omega;
+    }
+    double muSquared = (ratio + omega - 1) * (ratio + omega - 1)
+            / (ratio * omega * omega);
+    double newOmega = (muSquared < 1) ? 2 / (1 + sqrt(1 - muSquared))
+            : OMEGA_LIMIT;
+    if(newOmega > OMEGA_LIMIT)
+        newOmega = OMEGA_LIMIT;
+    if(newOmega - omega < 0.001)
+        estimate->frozen = 1;
+    else
+        estimate->omega = newOmega;
+    estimate->steady = 0;
+    return estimate->omega;
+}
@@ -0,0 +1,26 @@
+// Over-relaxation factor selection for SOR sweeps
+// Candidate Number: 11066
+
+#ifndef SOR_H
+#define SOR_H
+
+// Special values for the requested omega, anything above 0 is used as is
+#define OMEGA_OPTIMAL 0.0 // Pick omega from the grid dimensions
+#define OMEGA_ADAPTIVE -1.0 // Estimate omega from the observed convergence
+
+//Struct tracking omega across the sweeps of one solve
+struct omegaEstimate
+{
+    double omega; // Factor to use for the next sweep
+    double lastDelta; // Largest change seen in the previous sweep
+    double lastRatio; // Ratio of the last two largest changes
+    int steady; // Sweeps in a row with a settled ratio
+    int frozen; // Non zero once omega is no longer adjusted
+};
+
+double optimalOmega(int rows, int cols);
+void initOmega(struct omegaEstimate *estimate, double requested, int rows,
+        int cols);
+double nextOmega(struct omegaEstimate *estimate, double maxDelta);
+
+#endif
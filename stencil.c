@@ -0,0 +1,398 @@
+// General boundary conditions: held edges and cells, Neumann edges and
+// sources, applied through a variable coefficient update
+// Candidate Number: 11066
+//
+// Edges held at values (Dirichlet conditions) are just the values of the
+// boundary cells, so any mix of them keeps the plain average of the four
+// neighbours and its vectorised kernels. Everything else changes the
+// update itself, and is folded into one general update with its own
+// terms for every cell:
+//
+//  - A Neumann edge holds the gradient g across it, so the ghost cell past
+//    it equals its neighbour plus g. Solving for a cell beside the edge
+//    drops the ghost and shares the update between the other neighbours.
+//  - A source f (Poisson's equation, unit spacing) subtracts f/4 from
+//    every update.
+//  - A held cell (an obstacle) has no neighbour terms and its value as
+//    the constant.
+//
+// The terms take five times the memory of the matrix, so they are only
+// built when the options need them (see needsStencil). Each solve then
+// picks its row updates and residual once, through function pointers,
+// rather than testing for a stencil on every row. Residuals of the general
+// update are in the same units as bandResidual's. Obstacles are rectangles
+// only; other shapes are made of several.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "stencil.h"
+
+
+//needsStencil
+//INPUT: Solver parameters (opts)
+//OUT:   Non zero if the conditions need the general update: a Neumann
+//       edge, a source or an obstacle
+int needsStencil(const struct options *opts)
+{
+    int i = 0;
+    for(i = 0; i < EDGES; i++)
+        if(opts->edges[i].kind == EDGE_NEUMANN)
+            return 1;
+    return opts->source != 0 || opts->obstacleCount > 0;
+}
+
+
+//checkConditions
+//INPUT: Solver parameters (opts), whether to print errors (report)
+//OUT:   0 if the conditions can be solved with these options (-1 otherwise)
+int checkConditions(const struct options *opts, int report)
+{
+    int neumann = 0;
+    int i = 0;
+    for(i = 0; i < opts->obstacleCount; i++)
+    {
+        const struct obstacle *o = &opts->obstacles[i];
+        if(o->startRow < 1 || o->endRow > opts->rows-1 || o->startCol < 1
+                || o->endCol > opts->cols-1)
+        {
+            if(report)
+                printf("Obstacle %d:%d,%d:%d is outside the interior of the "
+                        "matrix\n", o->startRow, o->endRow-1, o->startCol,
+                        o->endCol-1);
+            return -1;
+        }
+    }
+    if(!needsStencil(opts))
+        return 0;
+    if(opts->dtype != ELEMENT_DOUBLE || (opts->method != METHOD_JACOBI
+            && opts->method != METHOD_RED_BLACK
+            && opts->method != METHOD_SOR))
+    {
+        if(report)
+            printf("Neumann edges, sources and obstacles need jacobi, "
+                    "red-black or sor in double precision\n");
+        return -1;
+    }
+    for(i = 0; i < EDGES; i++)
+        neumann += (opts->edges[i].kind == EDGE_NEUMANN);
+    //Otherwise any constant could be added to a solution
+    if(neumann == EDGES && opts->obstacleCount == 0)
+    {
+        if(report)
+            printf("Hold at least one edge or obstacle at a value, every "
+                    "edge is neumann\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+//edgeSide
+//INPUT: Solver parameters (opts), global row and column of a cell (row,
+//       col)
+//OUT:   Edge holding the cell (EDGES if it is interior). Corners, which no
+//       update reads, belong to the top and bottom edges
+static int edgeSide(const struct options *opts, int row, int col)
+{
+    if(row == 0)
+        return EDGE_TOP;
+    if(row == opts->rows-1)
+        return EDGE_BOTTOM;
+    if(col == 0)
+        return EDGE_LEFT;
+    if(col == opts->cols-1)
+        return EDGE_RIGHT;
+    return EDGES;
+}
+
+
+//heldObstacle
+//INPUT: Solver parameters (opts), global row and column of a cell (row,
+//       col)
+//OUT:   Last obstacle holding the cell (NULL if none does)
+static const struct obstacle *heldObstacle(const struct options *opts,
+        int row, int col)
+{
+    const struct obstacle *held = NULL;
+    int i = 0;
+    for(i = 0; i < opts->obstacleCount; i++)
+    {
+        const struct obstacle *o = &opts->obstacles[i];
+        if(row >= o->startRow && row < o->endRow && col >= o->startCol
+                && col < o->endCol)
+            held = o;
+    }
+    return held;
+}
+
+
+//applyConditions
+//INPUT: Grid, or block of one, to set up (g), solver parameters (opts),
+//       global row and column of local cell (0, 0) (rowOffset, colOffset)
+//PROC:  Sets every cell of g, halo included, that lies on an edge held at
+//       a value, or in an obstacle, to its value. Cells on Neumann edges
+//       are zeroed, as no update reads them (see finishConditions)
+//OUT:   N/A (the held cells of g hold their values)
+void applyConditions(struct grid *g, const struct options *opts,
+        int rowOffset, int colOffset)
+{
+    int i = 0;
+    int j = 0;
+    for(i = -g->halo; i < g->rows + g->halo; i++)
+    {
+        int row = i + rowOffset;
+        if(row < 0 || row >= opts->rows)
+            continue;
+        for(j = 0; j < g->cols; j++)
+        {
+            int col = j + colOffset;
+            int side = edgeSide(opts, row, col);
+            const struct obstacle *held = NULL;
+            if(col < 0 || col >= opts->cols)
+                continue;
+            if(side != EDGES)
+            {
+                const struct edge *e = &opts->edges[side];
+                GRID_AT(g, i, j) = (e->kind == EDGE_BORDER)
+                        ? opts->borderValue : (e->kind == EDGE_DIRICHLET)
+                        ? e->value : 0;
+            }
+            else if((held = heldObstacle(opts, row, col)) != NULL)
+                GRID_AT(g, i, j) = held->value;
+        }
+    }
+}
+
+
+//finishConditions
+//INPUT: As applyConditions, g holding a solution
+//PROC:  Sets each cell on a Neumann edge, corners aside, to its neighbour
+//       plus the gradient, so the written matrix shows the condition
+//OUT:   N/A
+void finishConditions(struct grid *g, const struct options *opts,
+        int rowOffset, int colOffset)
+{
+    int i = 0;
+    int j = 0;
+    for(i = -g->halo; i < g->rows + g->halo; i++)
+    {
+        int row = i + rowOffset;
+        for(j = 0; j < g->cols; j++)
+        {
+            int col = j + colOffset;
+            if(row < 1 || row > opts->rows-2 || col < 1
+                    || col > opts->cols-2)
+            {
+                //The neighbour is the interior cell across the edge
+                int side = (row == 0 && col > 0 && col < opts->cols-1)
+                        ? EDGE_TOP : (row == opts->rows-1 && col > 0
+                        && col < opts->cols-1) ? EDGE_BOTTOM
+                        : (col == 0 && row > 0 && row < opts->rows-1)
+                        ? EDGE_LEFT : (col == opts->cols-1 && row > 0
+                        && row < opts->rows-1) ? EDGE_RIGHT : EDGES;
+                if(side == EDGES || opts->edges[side].kind != EDGE_NEUMANN)
+                    continue;
+                double gradient = opts->edges[side].value;
+                if(side == EDGE_TOP)
+                    GRID_AT(g, i, j) = GRID_AT(g, i+1, j) + gradient;
+                else if(side == EDGE_BOTTOM)
+                    GRID_AT(g, i, j) = GRID_AT(g, i-1, j) + gradient;
+                else if(side == EDGE_LEFT)
+                    GRID_AT(g, i, j) = GRID_AT(g, i, j+1) + gradient;
+                else
+                    GRID_AT(g, i, j) = GRID_AT(g, i, j-1) + gradient;
+            }
+        }
+    }
+}
+
+
+//cellTerms
+//INPUT: Solver parameters (opts), global row and column of an interior
+//       cell (row, col), where to put its terms (terms)
+//PROC:  Works out the cell's update. Neighbours across a Neumann edge are
+//       replaced by the cell itself plus the gradient, which moves them to
+//       the left hand side: (4-k)u = other neighbours + gradients - f
+//OUT:   N/A (terms holds the update)
+static void cellTerms(const struct options *opts, int row, int col,
+        double terms[STENCIL_TERMS])
+{
+    int across[4] = {row-1 == 0 ? EDGE_TOP : EDGES,
+            row+1 == opts->rows-1 ? EDGE_BOTTOM : EDGES,
+            col-1 == 0 ? EDGE_LEFT : EDGES,
+            col+1 == opts->cols-1 ? EDGE_RIGHT : EDGES};
+    const struct obstacle *held = heldObstacle(opts, row, col);
+    double constant = -opts->source;
+    int neighbours = 4;
+    int t = 0;
+    for(t = 0; t < STENCIL_TERMS; t++)
+        terms[t] = 0;
+    if(held != NULL)
+    {
+        terms[TERM_CONSTANT] = held->value;
+        return;
+    }
+    for(t = TERM_UP; t <= TERM_RIGHT; t++)
+    {
+        if(across[t] != EDGES && opts->edges[across[t]].kind == EDGE_NEUMANN)
+        {
+            constant += opts->edges[across[t]].value;
+            neighbours--;
+        }
+        else
+            terms[t] = 1;
+    }
+    //A cell walled in by Neumann edges only arises when every edge is,
+    //which checkConditions refuses
+    if(neighbours == 0)
+        return;
+    for(t = TERM_UP; t <= TERM_RIGHT; t++)
+        terms[t] /= neighbours;
+    terms[TERM_CONSTANT] = constant / neighbours;
+}
+
+
+//createStencil
+//INPUT: Grid, or block of one, to be swept (g), solver parameters (opts),
+//       global row and column of local cell (0, 0) (rowOffset, colOffset)
+//PROC:  Works out the terms of every interior cell of g. Other cells,
+//       halo included, get no terms, as they are never updated
+//OUT:   Pointer to the stencil (NULL if allocation failed)
+struct stencil *createStencil(const struct grid *g,
+        const struct options *opts, int rowOffset, int colOffset)
+{
+    struct stencil *s = calloc(1, sizeof(struct stencil));
+    double terms[STENCIL_TERMS];
+    int i = 0;
+    int j = 0;
+    int t = 0;
+    if(s == NULL)
+        return NULL;
+    for(t = 0; t < STENCIL_TERMS; t++)
+    {
+        s->terms[t] = createGrid(g->rows, g->cols, g->halo);
+        if(s->terms[t] == NULL)
+        {
+            freeStencil(s);
+            return NULL;
+        }
+    }
+    for(i = -g->halo; i < g->rows + g->halo; i++)
+    {
+        int row = i + rowOffset;
+        if(row < 1 || row > opts->rows-2)
+            continue;
+        for(j = 0; j < g->cols; j++)
+        {
+            int col = j + colOffset;
+            if(col < 1 || col > opts->cols-2)
+                continue;
+            cellTerms(opts, row, col, terms);
+            for(t = 0; t < STENCIL_TERMS; t++)
+                GRID_AT(s->terms[t], i, j) = terms[t];
+        }
+    }
+    return s;
+}
+
+
+//stencilUpdate
+//INPUT: Stencil (s), grid (g), row and column of the cell (a, b)
+//OUT:   New value of the cell under the general update
+static inline double stencilUpdate(const struct stencil *s,
+        const struct grid *g, int a, int b)
+{
+    return GRID_AT(g, a-1, b) * GRID_AT(s->terms[TERM_UP], a, b)
+            + GRID_AT(g, a+1, b) * GRID_AT(s->terms[TERM_DOWN], a, b)
+            + GRID_AT(g, a, b-1) * GRID_AT(s->terms[TERM_LEFT], a, b)
+            + GRID_AT(g, a, b+1) * GRID_AT(s->terms[TERM_RIGHT], a, b)
+            + GRID_AT(s->terms[TERM_CONSTANT], a, b);
+}
+
+
+//stencilJacobiRow
+//INPUT: Stencil (s), grid to read (src), grid to write (dst), row (a),
+//       columns from up to but not including to
+//PROC:  Writes the general update of the given cells of row a into dst
+//OUT:   Largest absolute change made to a cell
+double stencilJacobiRow(const struct stencil *s, const struct grid *src,
+        struct grid *dst, int a, int from, int to)
+{
+    double *out = GRID_ROW(dst, a);
+    const double *mid = GRID_ROW(src, a);
+    double maxDelta = 0;
+    int b = 0;
+    for(b = from; b<to; b++)
+    {
+        out[b] = stencilUpdate(s, src, a, b);
+        double delta = fabs(out[b] - mid[b]);
+        if(delta > maxDelta)
+            maxDelta = delta;
+    }
+    return maxDelta;
+}
+
+
+//stencilColourRow
+//INPUT: Stencil (s), grid to update in place (g), row (a), columns from
+//       up to but not including to, global row plus column of local cell
+//       (0, 0) (parity), colour of the cells to update (colour),
+//       over-relaxation factor (omega)
+//PROC:  Moves the cells of one colour omega times the way to their
+//       general update
+//OUT:   Largest absolute change made to a cell
+double stencilColourRow(const struct stencil *s, struct grid *g, int a,
+        int from, int to, int parity, int colour, double omega)
+{
+    double *mid = GRID_ROW(g, a);
+    double maxDelta = 0;
+    int b = from + ((a + from + parity + colour) & 1);
+    for(; b<to; b += 2)
+    {
+        double change = omega * (stencilUpdate(s, g, a, b) - mid[b]);
+        mid[b] += change;
+        if(fabs(change) > maxDelta)
+            maxDelta = fabs(change);
+    }
+    return maxDelta;
+}
+
+
+//stencilResidual
+//INPUT: As bandResidual, plus the stencil (s)
+//OUT:   Largest absolute residual of the general update in the band, or
+//       for NORM_L2 the sum of the squared residuals
+double stencilResidual(const struct stencil *s, const struct grid *g,
+        int startRow, int endRow, int startCol, int endCol,
+        enum convergenceNorm norm)
+{
+    double result = 0;
+    int a = 0;
+    int b = 0;
+    for(a = startRow; a<endRow; a++)
+    {
+        for(b = startCol; b<endCol; b++)
+        {
+            double r = stencilUpdate(s, g, a, b) - GRID_AT(g, a, b);
+            if(norm == NORM_L2)
+                result += r*r;
+            else if(fabs(r) > result)
+                result = fabs(r);
+        }
+    }
+    return result;
+}
+
+
+//freeStencil
+//INPUT: Stencil (s), may be part set up
+void freeStencil(struct stencil *s)
+{
+    int t = 0;
+    if(s == NULL)
+        return;
+    for(t = 0; t < STENCIL_TERMS; t++)
+        freeGrid(s->terms[t]);
+    free(s);
+}
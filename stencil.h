@@ -0,0 +1,49 @@
+// General boundary conditions: held edges and cells, Neumann edges and
+// sources, applied through a variable coefficient update
+// Candidate Number: 11066
+
+#ifndef STENCIL_H
+#define STENCIL_H
+
+#include "grid.h"
+#include "options.h"
+#include "convergence.h"
+
+// Terms of a cell's general update, in the order of stencil.terms
+enum stencilTerm
+{
+    TERM_UP,
+    TERM_DOWN,
+    TERM_LEFT,
+    TERM_RIGHT,
+    TERM_CONSTANT,
+    STENCIL_TERMS
+};
+
+//Struct holding the general update of every cell of a grid (or block).
+//The new value of cell (a, b) is the sum of each neighbour times its
+//term, plus the constant term. Each term is a grid shaped like the
+//matrix, so it is indexed the same way
+struct stencil
+{
+    struct grid *terms[STENCIL_TERMS];
+};
+
+int needsStencil(const struct options *opts);
+int checkConditions(const struct options *opts, int report);
+void applyConditions(struct grid *g, const struct options *opts,
+        int rowOffset, int colOffset);
+void finishConditions(struct grid *g, const struct options *opts,
+        int rowOffset, int colOffset);
+struct stencil *createStencil(const struct grid *g,
+        const struct options *opts, int rowOffset, int colOffset);
+double stencilJacobiRow(const struct stencil *s, const struct grid *src,
+        struct grid *dst, int a, int from, int to);
+double stencilColourRow(const struct stencil *s, struct grid *g, int a,
+        int from, int to, int parity, int colour, double omega);
+double stencilResidual(const struct stencil *s, const struct grid *g,
+        int startRow, int endRow, int startCol, int endCol,
+        enum convergenceNorm norm);
+void freeStencil(struct stencil *s);
+
+#endif
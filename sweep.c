@@ -0,0 +1,578 @@
+// Vectorised relaxation sweep kernels with runtime instruction set dispatch
+// Candidate Number: 11066
+//
+// Every kernel sums the neighbours in the same order as the scalar version,
+// so all instruction sets give bit-identical grids and iteration counts.
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sweep.h"
+
+// Keep a*b+c as two roundings, as in the vector kernels, so the scalar
+// code gives the same answers when built with -march flags that add FMA
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SWEEP_X86
+#endif
+
+
+//jacobiRowScalar
+//INPUT: Rows above, at and below the row being updated (up, mid, down)
+//       Row to write the new values into (out), row length (cols)
+//PROC:  Plain C Jacobi update of columns 1 .. cols-2
+//OUT:   Largest absolute change between mid and out
+static double jacobiRowScalar(const double *up, const double *mid,
+        const double *down, double *out, int cols)
+{
+    double maxDelta = 0;
+    int b = 0;
+    for(b = 1; b<cols-1; b++)
+    {
+        double newValue = (up[b] + mid[b-1] + down[b] + mid[b+1]) * 0.25;
+        double delta = fabs(newValue - mid[b]);
+        out[b] = newValue;
+        if(delta > maxDelta)
+            maxDelta = delta;
+    }
+    return maxDelta;
+}
+
+//colourRowScalar
+//INPUT: Rows above, at and below the row being updated (up, mid, down)
+//       Right hand side added to the neighbour sum, NULL for none (rhs)
+//       Row length (cols), first column of the colour being updated (first)
+//       Over-relaxation factor, 1 for plain averaging (omega)
+//PROC:  Plain C update of columns first, first+2, .. cols-2 in place
+//OUT:   Largest absolute change made to mid
+static double colourRowScalar(const double *up, double *mid,
+        const double *down, const double *rhs, int cols, int first,
+        double omega)
+{
+    double maxDelta = 0;
+    int b = 0;
+    for(b = first; b<cols-1; b += 2)
+    {
+        double sum = up[b] + mid[b-1] + down[b] + mid[b+1];
+        if(rhs != NULL)
+            sum += rhs[b];
+        double average = sum * 0.25;
+        double newValue = mid[b] + omega * (average - mid[b]);
+        double delta = fabs(newValue - mid[b]);
+        mid[b] = newValue;
+        if(delta > maxDelta)
+            maxDelta = delta;
+    }
+    return maxDelta;
+}
+
+//jacobiRowFloatScalar
+//INPUT: As jacobiRowScalar, on floats, plus a right hand side added to the
+//       neighbour sum, NULL for none (rhs)
+//PROC:  Plain C single precision Jacobi update of columns 1 .. cols-2
+//OUT:   Largest absolute change between mid and out
+static double jacobiRowFloatScalar(const float *up, const float *mid,
+        const float *down, const float *rhs, float *out, int cols)
+{
+    float maxDelta = 0;
+    int b = 0;
+    for(b = 1; b<cols-1; b++)
+    {
+        float sum = up[b] + mid[b-1] + down[b] + mid[b+1];
+        if(rhs != NULL)
+            sum += rhs[b];
+        float newValue = sum * 0.25f;
+        float delta = fabsf(newValue - mid[b]);
+        out[b] = newValue;
+        if(delta > maxDelta)
+            maxDelta = delta;
+    }
+    return maxDelta;
+}
+
+//colourRowFloatScalar
+//INPUT: As colourRowScalar, on floats
+//PROC:  Plain C single precision update of columns first, first+2, ..
+//       cols-2 in place
+//OUT:   Largest absolute change made to mid
+static double colourRowFloatScalar(const float *up, float *mid,
+        const float *down, const float *rhs, int cols, int first,
+        double omega)
+{
+    float factor = (float)omega;
+    float maxDelta = 0;
+    int b = 0;
+    for(b = first; b<cols-1; b += 2)
+    {
+        float sum = up[b] + mid[b-1] + down[b] + mid[b+1];
+        if(rhs != NULL)
+            sum += rhs[b];
+        float average = sum * 0.25f;
+        float newValue = mid[b] + factor * (average - mid[b]);
+        float delta = fabsf(newValue - mid[b]);
+        mid[b] = newValue;
+        if(delta > maxDelta)
+            maxDelta = delta;
+    }
+    return maxDelta;
+}
+
+#ifdef SWEEP_X86
+
+//jacobiRowSSE2
+// As jacobiRowScalar, two columns per instruction
+__attribute__((target("sse2")))
+static double jacobiRowSSE2(const double *up, const double *mid,
+        const double *down, double *out, int cols)
+{
+    const __m128d quarter = _mm_set1_pd(0.25);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+    __m128d maxDelta = _mm_setzero_pd();
+    int b = 1;
+    for(; b+2 <= cols-1; b += 2)
+    {
+        __m128d centre = _mm_loadu_pd(mid+b);
+        __m128d sum = _mm_add_pd(_mm_loadu_pd(up+b), _mm_loadu_pd(mid+b-1));
+        sum = _mm_add_pd(sum, _mm_loadu_pd(down+b));
+        sum = _mm_add_pd(sum, _mm_loadu_pd(mid+b+1));
+        __m128d newValue = _mm_mul_pd(sum, quarter);
+        _mm_storeu_pd(out+b, newValue);
+        maxDelta = _mm_max_pd(maxDelta,
+                _mm_andnot_pd(signBit, _mm_sub_pd(newValue, centre)));
+    }
+    //Reduce the vector maximum and finish any odd column
+    double lanes[2];
+    _mm_storeu_pd(lanes, maxDelta);
+    double result = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    double tail = jacobiRowScalar(up+b-1, mid+b-1, down+b-1, out+b-1,
+            cols-b+1);
+    return tail > result ? tail : result;
+}
+
+//jacobiRowAVX2
+// As jacobiRowScalar, four columns per instruction
+__attribute__((target("avx2")))
+static double jacobiRowAVX2(const double *up, const double *mid,
+        const double *down, double *out, int cols)
+{
+    const __m256d quarter = _mm256_set1_pd(0.25);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    __m256d maxDelta = _mm256_setzero_pd();
+    int b = 1;
+    for(; b+4 <= cols-1; b += 4)
+    {
+        __m256d centre = _mm256_loadu_pd(mid+b);
+        __m256d sum = _mm256_add_pd(_mm256_loadu_pd(up+b),
+                _mm256_loadu_pd(mid+b-1));
+        sum = _mm256_add_pd(sum, _mm256_loadu_pd(down+b));
+        sum = _mm256_add_pd(sum, _mm256_loadu_pd(mid+b+1));
+        __m256d newValue = _mm256_mul_pd(sum, quarter);
+        _mm256_storeu_pd(out+b, newValue);
+        maxDelta = _mm256_max_pd(maxDelta,
+                _mm256_andnot_pd(signBit, _mm256_sub_pd(newValue, centre)));
+    }
+    //Reduce the vector maximum and finish the remaining columns
+    __m128d half = _mm_max_pd(_mm256_castpd256_pd128(maxDelta),
+            _mm256_extractf128_pd(maxDelta, 1));
+    half = _mm_max_sd(half, _mm_unpackhi_pd(half, half));
+    double result = _mm_cvtsd_f64(half);
+    double tail = jacobiRowScalar(up+b-1, mid+b-1, down+b-1, out+b-1,
+            cols-b+1);
+    return tail > result ? tail : result;
+}
+
+//jacobiRowAVX512
+// As jacobiRowScalar, eight columns per instruction
+__attribute__((target("avx512f")))
+static double jacobiRowAVX512(const double *up, const double *mid,
+        const double *down, double *out, int cols)
+{
+    const __m512d quarter = _mm512_set1_pd(0.25);
+    __m512d maxDelta = _mm512_setzero_pd();
+    int b = 1;
+    for(; b+8 <= cols-1; b += 8)
+    {
+        __m512d centre = _mm512_loadu_pd(mid+b);
+        __m512d sum = _mm512_add_pd(_mm512_loadu_pd(up+b),
+                _mm512_loadu_pd(mid+b-1));
+        sum = _mm512_add_pd(sum, _mm512_loadu_pd(down+b));
+        sum = _mm512_add_pd(sum, _mm512_loadu_pd(mid+b+1));
+        __m512d newValue = _mm512_mul_pd(sum, quarter);
+        _mm512_storeu_pd(out+b, newValue);
+        maxDelta = _mm512_max_pd(maxDelta,
+                _mm512_abs_pd(_mm512_sub_pd(newValue, centre)));
+    }
+    double result = _mm512_reduce_max_pd(maxDelta);
+    double tail = jacobiRowScalar(up+b-1, mid+b-1, down+b-1, out+b-1,
+            cols-b+1);
+    return tail > result ? tail : result;
+}
+
+//colourRowAVX2
+// As colourRowScalar, computing four columns per instruction and storing
+// the two of the right colour with a masked store. The other colour only
+// feeds the neighbour loads, so the in place update stays order independent.
+// Inlined twice so the loop without a right hand side has no extra load
+__attribute__((target("avx2"), always_inline))
+static inline double colourRowBodyAVX2(const double *up, double *mid,
+        const double *down, const double *rhs, int cols, int first,
+        double omega, int hasRhs)
+{
+    const __m256d quarter = _mm256_set1_pd(0.25);
+    const __m256d factor = _mm256_set1_pd(omega);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    //Vectors start on odd columns, so odd lanes hold column first+1
+    const __m256i store = (first == 1) ? _mm256_set_epi64x(0, -1, 0, -1)
+            : _mm256_set_epi64x(-1, 0, -1, 0);
+    const __m256d keep = _mm256_castsi256_pd(store);
+    __m256d maxDelta = _mm256_setzero_pd();
+    int b = 1;
+    for(; b+4 <= cols-1; b += 4)
+    {
+        __m256d centre = _mm256_loadu_pd(mid+b);
+        __m256d sum = _mm256_add_pd(_mm256_loadu_pd(up+b),
+                _mm256_loadu_pd(mid+b-1));
+        sum = _mm256_add_pd(sum, _mm256_loadu_pd(down+b));
+        sum = _mm256_add_pd(sum, _mm256_loadu_pd(mid+b+1));
+        if(hasRhs)
+            sum = _mm256_add_pd(sum, _mm256_loadu_pd(rhs+b));
+        __m256d average = _mm256_mul_pd(sum, quarter);
+        __m256d newValue = _mm256_add_pd(centre, _mm256_mul_pd(factor,
+                _mm256_sub_pd(average, centre)));
+        _mm256_maskstore_pd(mid+b, store, newValue);
+        __m256d delta = _mm256_andnot_pd(signBit,
+                _mm256_sub_pd(newValue, centre));
+        maxDelta = _mm256_max_pd(maxDelta, _mm256_and_pd(delta, keep));
+    }
+    __m128d half = _mm_max_pd(_mm256_castpd256_pd128(maxDelta),
+            _mm256_extractf128_pd(maxDelta, 1));
+    half = _mm_max_sd(half, _mm_unpackhi_pd(half, half));
+    double result = _mm_cvtsd_f64(half);
+    //b is odd here, so column first keeps its parity in the shifted row
+    double tail = colourRowScalar(up+b-1, mid+b-1, down+b-1,
+            hasRhs ? rhs+b-1 : NULL, cols-b+1, first, omega);
+    return tail > result ? tail : result;
+}
+
+__attribute__((target("avx2")))
+static double colourRowAVX2(const double *up, double *mid,
+        const double *down, const double *rhs, int cols, int first,
+        double omega)
+{
+    if(rhs != NULL)
+        return colourRowBodyAVX2(up, mid, down, rhs, cols, first, omega, 1);
+    return colourRowBodyAVX2(up, mid, down, NULL, cols, first, omega, 0);
+}
+
+//colourRowAVX512
+// As colourRowAVX2, eight columns per instruction
+__attribute__((target("avx512f"), always_inline))
+static inline double colourRowBodyAVX512(const double *up, double *mid,
+        const double *down, const double *rhs, int cols, int first,
+        double omega, int hasRhs)
+{
+    const __m512d quarter = _mm512_set1_pd(0.25);
+    const __m512d factor = _mm512_set1_pd(omega);
+    const __mmask8 store = (first == 1) ? 0x55 : 0xAA;
+    __m512d maxDelta = _mm512_setzero_pd();
+    int b = 1;
+    for(; b+8 <= cols-1; b += 8)
+    {
+        __m512d centre = _mm512_loadu_pd(mid+b);
+        __m512d sum = _mm512_add_pd(_mm512_loadu_pd(up+b),
+                _mm512_loadu_pd(mid+b-1));
+        sum = _mm512_add_pd(sum, _mm512_loadu_pd(down+b));
+        sum = _mm512_add_pd(sum, _mm512_loadu_pd(mid+b+1));
+        if(hasRhs)
+            sum = _mm512_add_pd(sum, _mm512_loadu_pd(rhs+b));
+        __m512d average = _mm512_mul_pd(sum, quarter);
+        __m512d newValue = _mm512_add_pd(centre, _mm512_mul_pd(factor,
+                _mm512_sub_pd(average, centre)));
+        _mm512_mask_storeu_pd(mid+b, store, newValue);
+        maxDelta = _mm512_mask_max_pd(maxDelta, store, maxDelta,
+                _mm512_abs_pd(_mm512_sub_pd(newValue, centre)));
+    }
+    double result = _mm512_reduce_max_pd(maxDelta);
+    double tail = colourRowScalar(up+b-1, mid+b-1, down+b-1,
+            hasRhs ? rhs+b-1 : NULL, cols-b+1, first, omega);
+    return tail > result ? tail : result;
+}
+
+__attribute__((target("avx512f")))
+static double colourRowAVX512(const double *up, double *mid,
+        const double *down, const double *rhs, int cols, int first,
+        double omega)
+{
+    if(rhs != NULL)
+        return colourRowBodyAVX512(up, mid, down, rhs, cols, first, omega, 1);
+    return colourRowBodyAVX512(up, mid, down, NULL, cols, first, omega, 0);
+}
+
+//jacobiRowFloatAVX2
+// As jacobiRowFloatScalar, eight columns per instruction. Inlined twice so
+// the loop without a right hand side has no extra load
+__attribute__((target("avx2"), always_inline))
+static inline double jacobiRowFloatBodyAVX2(const float *up, const float *mid,
+        const float *down, const float *rhs, float *out, int cols,
+        int hasRhs)
+{
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    __m256 maxDelta = _mm256_setzero_ps();
+    int b = 1;
+    for(; b+8 <= cols-1; b += 8)
+    {
+        __m256 centre = _mm256_loadu_ps(mid+b);
+        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(up+b),
+                _mm256_loadu_ps(mid+b-1));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(down+b));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(mid+b+1));
+        if(hasRhs)
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(rhs+b));
+        __m256 newValue = _mm256_mul_ps(sum, quarter);
+        _mm256_storeu_ps(out+b, newValue);
+        maxDelta = _mm256_max_ps(maxDelta,
+                _mm256_andnot_ps(signBit, _mm256_sub_ps(newValue, centre)));
+    }
+    //Reduce the vector maximum and finish the remaining columns
+    __m128 half = _mm_max_ps(_mm256_castps256_ps128(maxDelta),
+            _mm256_extractf128_ps(maxDelta, 1));
+    half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+    double result = _mm_cvtss_f32(half);
+    double tail = jacobiRowFloatScalar(up+b-1, mid+b-1, down+b-1,
+            hasRhs ? rhs+b-1 : NULL, out+b-1, cols-b+1);
+    return tail > result ? tail : result;
+}
+
+__attribute__((target("avx2")))
+static double jacobiRowFloatAVX2(const float *up, const float *mid,
+        const float *down, const float *rhs, float *out, int cols)
+{
+    if(rhs != NULL)
+        return jacobiRowFloatBodyAVX2(up, mid, down, rhs, out, cols, 1);
+    return jacobiRowFloatBodyAVX2(up, mid, down, NULL, out, cols, 0);
+}
+
+//colourRowFloatAVX2
+// As colourRowAVX2, on eight floats per instruction
+__attribute__((target("avx2"), always_inline))
+static inline double colourRowFloatBodyAVX2(const float *up, float *mid,
+        const float *down, const float *rhs, int cols, int first,
+        double omega, int hasRhs)
+{
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    const __m256 factor = _mm256_set1_ps((float)omega);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    //Vectors start on odd columns, so odd lanes hold column first+1
+    const __m256i store = (first == 1)
+            ? _mm256_set_epi32(0, -1, 0, -1, 0, -1, 0, -1)
+            : _mm256_set_epi32(-1, 0, -1, 0, -1, 0, -1, 0);
+    const __m256 keep = _mm256_castsi256_ps(store);
+    __m256 maxDelta = _mm256_setzero_ps();
+    int b = 1;
+    for(; b+8 <= cols-1; b += 8)
+    {
+        __m256 centre = _mm256_loadu_ps(mid+b);
+        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(up+b),
+                _mm256_loadu_ps(mid+b-1));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(down+b));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(mid+b+1));
+        if(hasRhs)
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(rhs+b));
+        __m256 average = _mm256_mul_ps(sum, quarter);
+        __m256 newValue = _mm256_add_ps(centre, _mm256_mul_ps(factor,
+                _mm256_sub_ps(average, centre)));
+        _mm256_maskstore_ps(mid+b, store, newValue);
+        __m256 delta = _mm256_andnot_ps(signBit,
+                _mm256_sub_ps(newValue, centre));
+        maxDelta = _mm256_max_ps(maxDelta, _mm256_and_ps(delta, keep));
+    }
+    __m128 half = _mm_max_ps(_mm256_castps256_ps128(maxDelta),
+            _mm256_extractf128_ps(maxDelta, 1));
+    half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+    double result = _mm_cvtss_f32(half);
+    //b is odd here, so column first keeps its parity in the shifted row
+    double tail = colourRowFloatScalar(up+b-1, mid+b-1, down+b-1,
+            hasRhs ? rhs+b-1 : NULL, cols-b+1, first, omega);
+    return tail > result ? tail : result;
+}
+
+__attribute__((target("avx2")))
+static double colourRowFloatAVX2(const float *up, float *mid,
+        const float *down, const float *rhs, int cols, int first,
+        double omega)
+{
+    if(rhs != NULL)
+        return colourRowFloatBodyAVX2(up, mid, down, rhs, cols, first, omega,
+                1);
+    return colourRowFloatBodyAVX2(up, mid, down, NULL, cols, first, omega,
+            0);
+}
+
+//jacobiRowFloatAVX512
+// As jacobiRowFloatAVX2, sixteen columns per instruction
+__attribute__((target("avx512f"), always_inline))
+static inline double jacobiRowFloatBodyAVX512(const float *up,
+        const float *mid, const float *down, const float *rhs, float *out,
+        int cols, int hasRhs)
+{
+    const __m512 quarter = _mm512_set1_ps(0.25f);
+    __m512 maxDelta = _mm512_setzero_ps();
+    int b = 1;
+    for(; b+16 <= cols-1; b += 16)
+    {
+        __m512 centre = _mm512_loadu_ps(mid+b);
+        __m512 sum = _mm512_add_ps(_mm512_loadu_ps(up+b),
+                _mm512_loadu_ps(mid+b-1));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(down+b));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(mid+b+1));
+        if(hasRhs)
+            sum = _mm512_add_ps(sum, _mm512_loadu_ps(rhs+b));
+        __m512 newValue = _mm512_mul_ps(sum, quarter);
+        _mm512_storeu_ps(out+b, newValue);
+        maxDelta = _mm512_max_ps(maxDelta,
+                _mm512_abs_ps(_mm512_sub_ps(newValue, centre)));
+    }
+    double result = _mm512_reduce_max_ps(maxDelta);
+    double tail = jacobiRowFloatScalar(up+b-1, mid+b-1, down+b-1,
+            hasRhs ? rhs+b-1 : NULL, out+b-1, cols-b+1);
+    return tail > result ? tail : result;
+}
+
+__attribute__((target("avx512f")))
+static double jacobiRowFloatAVX512(const float *up, const float *mid,
+        const float *down, const float *rhs, float *out, int cols)
+{
+    if(rhs != NULL)
+        return jacobiRowFloatBodyAVX512(up, mid, down, rhs, out, cols, 1);
+    return jacobiRowFloatBodyAVX512(up, mid, down, NULL, out, cols, 0);
+}
+
+//colourRowFloatAVX512
+// As colourRowFloatAVX2, sixteen columns per instruction
+__attribute__((target("avx512f"), always_inline))
+static inline double colourRowFloatBodyAVX512(const float *up, float *mid,
+        const float *down, const float *rhs, int cols, int first,
+        double omega, int hasRhs)
+{
+    const __m512 quarter = _mm512_set1_ps(0.25f);
+    const __m512 factor = _mm512_set1_ps((float)omega);
+    const __mmask16 store = (first == 1) ? 0x5555 : 0xAAAA;
+    __m512 maxDelta = _mm512_setzero_ps();
+    int b = 1;
+    for(; b+16 <= cols-1; b += 16)
+    {
+        __m512 centre = _mm512_loadu_ps(mid+b);
+        __m512 sum = _mm512_add_ps(_mm512_loadu_ps(up+b),
+                _mm512_loadu_ps(mid+b-1));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(down+b));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(mid+b+1));
+        if(hasRhs)
+            sum = _mm512_add_ps(sum, _mm512_loadu_ps(rhs+b));
+        __m512 average = _mm512_mul_ps(sum, quarter);
+        __m512 newValue = _mm512_add_ps(centre, _mm512_mul_ps(factor,
+                _mm512_sub_ps(average, centre)));
+        _mm512_mask_storeu_ps(mid+b, store, newValue);
+        maxDelta = _mm512_mask_max_ps(maxDelta, store, maxDelta,
+                _mm512_abs_ps(_mm512_sub_ps(newValue, centre)));
+    }
+    double result = _mm512_reduce_max_ps(maxDelta);
+    double tail = colourRowFloatScalar(up+b-1, mid+b-1, down+b-1,
+            hasRhs ? rhs+b-1 : NULL, cols-b+1, first, omega);
+    return tail > result ? tail : result;
+}
+
+__attribute__((target("avx512f")))
+static double colourRowFloatAVX512(const float *up, float *mid,
+        const float *down, const float *rhs, int cols, int first,
+        double omega)
+{
+    if(rhs != NULL)
+        return colourRowFloatBodyAVX512(up, mid, down, rhs, cols, first,
+                omega, 1);
+    return colourRowFloatBodyAVX512(up, mid, down, NULL, cols, first, omega,
+            0);
+}
+
+#endif
+
+// Kernel table, best instruction set first
+struct sweepKernels
+{
+    const char *name;
+    int (*supported)(void);
+    jacobiRowFunct jacobi;
+    colourRowFunct colour;
+    jacobiRowFloatFunct jacobiFloat;
+    colourRowFloatFunct colourFloat;
+};
+
+static int alwaysSupported(void) { return 1; }
+#ifdef SWEEP_X86
+static int hasSSE2(void) { return __builtin_cpu_supports("sse2"); }
+static int hasAVX2(void) { return __builtin_cpu_supports("avx2"); }
+static int hasAVX512(void) { return __builtin_cpu_supports("avx512f"); }
+#endif
+
+static const struct sweepKernels kernelTable[] =
+{
+#ifdef SWEEP_X86
+    {"avx512", hasAVX512, jacobiRowAVX512, colourRowAVX512,
+            jacobiRowFloatAVX512, colourRowFloatAVX512},
+    {"avx2", hasAVX2, jacobiRowAVX2, colourRowAVX2, jacobiRowFloatAVX2,
+            colourRowFloatAVX2},
+    //Only one lane in two would be stored, so colour rows stay scalar
+    {"sse2", hasSSE2, jacobiRowSSE2, colourRowScalar, jacobiRowFloatScalar,
+            colourRowFloatScalar},
+#endif
+    {"scalar", alwaysSupported, jacobiRowScalar, colourRowScalar,
+            jacobiRowFloatScalar, colourRowFloatScalar},
+};
+
+jacobiRowFunct jacobiRow = jacobiRowScalar;
+colourRowFunct colourRow = colourRowScalar;
+jacobiRowFloatFunct jacobiRowFloat = jacobiRowFloatScalar;
+colourRowFloatFunct colourRowFloat = colourRowFloatScalar;
+
+
+//initSweepKernels
+//PROC: Checks the CPU features (CPUID) and points the kernel function
+//      pointers at the widest supported instruction set. The RELAX_ISA
+//      environment variable (avx512, avx2, sse2 or scalar) caps the choice
+//OUT:  Name of the instruction set selected
+const char *initSweepKernels(void)
+{
+    const char *requested = getenv("RELAX_ISA");
+    int count = sizeof(kernelTable) / sizeof(kernelTable[0]);
+    int first = 0;
+    int i = 0;
+
+#ifdef SWEEP_X86
+    __builtin_cpu_init();
+#endif
+    //Start the search from the requested instruction set if one was given
+    if(requested != NULL)
+    {
+        for(i = 0; i<count; i++)
+            if(strcmp(kernelTable[i].name, requested) == 0)
+                first = i;
+    }
+    for(i = first; i<count; i++)
+    {
+        if(kernelTable[i].supported())
+        {
+            jacobiRow = kernelTable[i].jacobi;
+            colourRow = kernelTable[i].colour;
+            jacobiRowFloat = kernelTable[i].jacobiFloat;
+            colourRowFloat = kernelTable[i].colourFloat;
+            return kernelTable[i].name;
+        }
+    }
+    return "scalar";
+}
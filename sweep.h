@@ -0,0 +1,59 @@
+// Vectorised relaxation sweep kernels with runtime instruction set dispatch
+// Candidate Number: 11066
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+// Update ordering used by the solvers
+enum sweepMethod
+{
+    METHOD_GAUSS_SEIDEL, // In place update with locked edge rows (original)
+    METHOD_JACOBI, // Double buffered update, vectorised across each row
+    METHOD_RED_BLACK, // In place checkerboard update, all red then all black
+    METHOD_SOR, // Red-black update over-relaxed by a factor omega
+    METHOD_VCYCLE, // Multigrid V-cycles smoothed by red-black sweeps
+    METHOD_FMG, // Full multigrid, then V-cycles
+    METHOD_WAVEFRONT // Jacobi sweeps applied several at a time to each tile
+};
+
+// Cell colours for METHOD_RED_BLACK, a cell (a, b) is red when a+b is even
+#define COLOUR_RED 0
+#define COLOUR_BLACK 1
+
+// First column of row a holding cells of the given colour (1 or 2)
+#define COLOUR_FIRST(a, colour) (2 - (((a) + (colour)) & 1))
+
+//Jacobi row kernel
+// Writes the average of the four neighbours of mid into out for columns
+// 1 .. cols-2 and returns the largest absolute change from mid
+typedef double (*jacobiRowFunct)(const double *up, const double *mid,
+        const double *down, double *out, int cols);
+
+//Colour row kernel
+// Moves every second cell of mid, from column first (1 or 2) up to
+// cols-2, omega times the way to a quarter of its four neighbours plus
+// rhs (NULL for a zero right hand side) in place and returns the largest
+// absolute change. Only the updated cells are written
+typedef double (*colourRowFunct)(const double *up, double *mid,
+        const double *down, const double *rhs, int cols, int first,
+        double omega);
+
+//Single precision kernels
+// As the kernels above on rows of floats, for ELEMENT_FLOAT and
+// ELEMENT_MIXED (see mixed.h). The Jacobi kernel also adds rhs (NULL for
+// none) to the neighbour sum
+typedef double (*jacobiRowFloatFunct)(const float *up, const float *mid,
+        const float *down, const float *rhs, float *out, int cols);
+typedef double (*colourRowFloatFunct)(const float *up, float *mid,
+        const float *down, const float *rhs, int cols, int first,
+        double omega);
+
+// Kernels chosen by initSweepKernels
+extern jacobiRowFunct jacobiRow;
+extern colourRowFunct colourRow;
+extern jacobiRowFloatFunct jacobiRowFloat;
+extern colourRowFloatFunct colourRowFloat;
+
+const char *initSweepKernels(void);
+
+#endif
@@ -0,0 +1,233 @@
+// Cache sized tiles of the grid, shared out with work stealing
+// Candidate Number: 11066
+//
+// Fixed bands of rows make every sweep wait for the slowest thread, so a
+// band that is a row longer, or a processor shared with another program
+// or running slower, holds up every thread at each barrier. Here each
+// thread's band is cut into tiles sized for its cache. A thread sweeps its
+// own tiles from the top, so it mostly touches the rows it first wrote
+// (see touchSections), and once they run out it steals tiles from the
+// bottom of its neighbours' bands, nearest neighbour first.
+//
+// Only sweeps whose cells within one phase do not depend on each other
+// are tiled: Jacobi sweeps, which read one grid and write the other, and
+// each colour of a red-black sweep, whose cells only read the other
+// colour. Within a phase the tiles can then be swept in any order by any
+// thread, and the barrier between phases, which every thread already
+// meets, is the only synchronisation needed.
+
+#include <stdlib.h>
+#include "sweep.h"
+#include "tiles.h"
+
+// Packs a queue's front and back into one word
+#define TILE_RANGE(front, back) \
+        (((unsigned long long)(front) << 32) | (unsigned int)(back))
+
+
+//bandTileRows
+//INPUT: Rows in a thread's band (bandRows), rows a tile fits in the cache
+//       (tileRows)
+//OUT:   Rows given to each tile of the band, so that the band has at least
+//       TILES_PER_THREAD tiles where it has the rows
+static int bandTileRows(int bandRows, int tileRows)
+{
+    int rows = (bandRows + TILES_PER_THREAD - 1) / TILES_PER_THREAD;
+    if(rows > tileRows)
+        rows = tileRows;
+    return (rows < 1) ? 1 : rows;
+}
+
+
+//createTileSchedule
+//INPUT: Row borders of each thread's band (borders, threads+1 entries, see
+//       allocateSections), threads (threads), columns in the grid (cols)
+//PROC:  Cuts each band into tiles whose part of the grids being read and
+//       written fits in TILE_CACHE_BYTES. Rows longer than that are also
+//       cut into whole cache lines of columns
+//OUT:   Pointer to the schedule, every queue empty (NULL on failure)
+struct tileSchedule *createTileSchedule(const int *borders, int threads,
+        int cols)
+{
+    struct tileSchedule *schedule = calloc(1, sizeof(struct tileSchedule));
+    int cells = TILE_CACHE_BYTES / (2 * sizeof(double));
+    int perLine = GRID_ALIGN / sizeof(double);
+    int tileCols = cols-2;
+    int i = 0;
+    int row = 0;
+    int col = 0;
+    if(schedule == NULL)
+        return NULL;
+    if(tileCols > cells)
+        tileCols = (cells / perLine) * perLine;
+    int tileRows = (tileCols > 0) ? cells / tileCols : 1;
+    int colTiles = (tileCols > 0) ? (cols-2 + tileCols-1) / tileCols : 0;
+
+    schedule->threads = threads;
+    schedule->owned = malloc((threads+1) * sizeof(int));
+    schedule->queues = aligned_alloc(TILE_LINE,
+            threads * sizeof(struct tileQueue));
+    if(schedule->owned == NULL || schedule->queues == NULL)
+    {
+        freeTileSchedule(schedule);
+        return NULL;
+    }
+    for(i = 0; i<threads; i++)
+    {
+        int bandRows = borders[i+1] - borders[i];
+        int rows = bandTileRows(bandRows, tileRows);
+        schedule->owned[i] = schedule->count;
+        schedule->count += (bandRows + rows-1) / rows * colTiles;
+        atomic_init(&schedule->queues[i].range, 0);
+    }
+    schedule->owned[threads] = schedule->count;
+    schedule->tiles = malloc((schedule->count > 0 ? schedule->count : 1)
+            * sizeof(struct tile));
+    if(schedule->tiles == NULL)
+    {
+        freeTileSchedule(schedule);
+        return NULL;
+    }
+
+    //Each band's tiles in row order, so the owner works down its band
+    struct tile *t = schedule->tiles;
+    for(i = 0; i<threads; i++)
+    {
+        int rows = bandTileRows(borders[i+1] - borders[i], tileRows);
+        for(row = borders[i]; row < borders[i+1]; row += rows)
+        {
+            for(col = 1; col < cols-1; col += tileCols)
+            {
+                t->startRow = row;
+                t->endRow = (row + rows < borders[i+1]) ? row + rows
+                        : borders[i+1];
+                t->startCol = col;
+                t->endCol = (col + tileCols < cols-1) ? col + tileCols
+                        : cols-1;
+                t++;
+            }
+        }
+    }
+    return schedule;
+}
+
+
+//resetTiles
+//INPUT: Schedule (schedule), thread starting a phase (thread)
+//PROC:  Puts every tile of the thread's band back on its queue. Each
+//       thread resets its own queue after the barrier ending the last
+//       phase, so no tile of the new phase is taken before every thread
+//       has finished the last one
+//OUT:   N/A
+void resetTiles(struct tileSchedule *schedule, int thread)
+{
+    atomic_store_explicit(&schedule->queues[thread].range,
+            TILE_RANGE(schedule->owned[thread], schedule->owned[thread+1]),
+            memory_order_release);
+}
+
+
+//takeTile
+//INPUT: Queue to take from (queue), non zero to take from the back (back)
+//OUT:   Index of the tile taken (-1 if the queue is empty)
+static int takeTile(struct tileQueue *queue, int back)
+{
+    unsigned long long range = atomic_load_explicit(&queue->range,
+            memory_order_acquire);
+    unsigned long long next = 0;
+    int tile = 0;
+    do
+    {
+        unsigned int front = (unsigned int)(range >> 32);
+        unsigned int end = (unsigned int)range;
+        if(front >= end)
+            return -1;
+        tile = back ? (int)end - 1 : (int)front;
+        next = back ? TILE_RANGE(front, end-1) : TILE_RANGE(front+1, end);
+    }while(!atomic_compare_exchange_weak_explicit(&queue->range, &range,
+            next, memory_order_acq_rel, memory_order_acquire));
+    return tile;
+}
+
+
+//nextTile
+//INPUT: Schedule (schedule), thread wanting work (thread)
+//PROC:  Takes the thread's next tile, or once its queue is empty steals
+//       the last tile of the nearest thread with any left
+//OUT:   Index of the tile to sweep (-1 once every tile of the phase has
+//       been taken)
+int nextTile(struct tileSchedule *schedule, int thread)
+{
+    int threads = schedule->threads;
+    int tile = takeTile(&schedule->queues[thread], 0);
+    int d = 0;
+    //Neighbours in the order +1, -1, +2, -2 ...
+    for(d = 1; tile < 0 && d < threads; d++)
+    {
+        int offset = (d & 1) ? (d+1) / 2 : -(d/2);
+        int victim = ((thread + offset) % threads + threads) % threads;
+        tile = takeTile(&schedule->queues[victim], 1);
+    }
+    return tile;
+}
+
+
+//jacobiTile
+//INPUT: grid to read (src), grid to write (dst), tile to sweep (t)
+//PROC:  Applies a Jacobi sweep to the cells of the tile
+//OUT:   Largest absolute change made to any cell
+double jacobiTile(const struct grid *src, struct grid *dst,
+        const struct tile *t)
+{
+    //The row kernels sweep columns 1 .. cols-2 of the rows they are given
+    int offset = t->startCol - 1;
+    int width = t->endCol - t->startCol + 2;
+    double maxDelta = 0;
+    int a = 0;
+    for(a = t->startRow; a<t->endRow; a++)
+    {
+        double rowDelta = jacobiRow(GRID_ROW(src, a-1) + offset,
+                GRID_ROW(src, a) + offset, GRID_ROW(src, a+1) + offset,
+                GRID_ROW(dst, a) + offset, width);
+        if(rowDelta > maxDelta)
+            maxDelta = rowDelta;
+    }
+    return maxDelta;
+}
+
+
+//colourTile
+//INPUT: matrix to update in place (matrix), tile to sweep (t), colour of
+//       the cells to update (colour), over-relaxation factor (omega)
+//PROC:  Updates the cells of one colour in the tile
+//OUT:   Largest absolute change made to any cell
+double colourTile(struct grid *matrix, const struct tile *t, int colour,
+        double omega)
+{
+    int offset = t->startCol - 1;
+    int width = t->endCol - t->startCol + 2;
+    double maxDelta = 0;
+    int a = 0;
+    for(a = t->startRow; a<t->endRow; a++)
+    {
+        double rowDelta = colourRow(GRID_ROW(matrix, a-1) + offset,
+                GRID_ROW(matrix, a) + offset, GRID_ROW(matrix, a+1) + offset,
+                NULL, width, COLOUR_FIRST(a + offset, colour), omega);
+        if(rowDelta > maxDelta)
+            maxDelta = rowDelta;
+    }
+    return maxDelta;
+}
+
+
+//freeTileSchedule
+//INPUT: Schedule no thread is using (schedule), may be part set up
+void freeTileSchedule(struct tileSchedule *schedule)
+{
+    if(schedule == NULL)
+        return;
+    free(schedule->tiles);
+    free(schedule->owned);
+    free(schedule->queues);
+    free(schedule);
+}
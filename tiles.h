@@ -0,0 +1,68 @@
+// Cache sized tiles of the grid, shared out with work stealing
+// Candidate Number: 11066
+
+#ifndef TILES_H
+#define TILES_H
+
+#include <stdatomic.h>
+#include "grid.h"
+
+// Bytes of the grids a tile's sweep reads and writes, aimed at each
+// thread's own cache
+#define TILE_CACHE_BYTES (256 * 1024)
+
+// Tiles each thread's rows are cut into at least, so there is work to
+// steal however small the grid
+#define TILES_PER_THREAD 4
+
+// Bytes given to each thread's queue of tiles
+#define TILE_LINE 64
+
+//Struct holding the cells of one tile, the ends excluded
+struct tile
+{
+    int startRow;
+    int endRow;
+    int startCol;
+    int endCol;
+};
+
+//Struct holding the tiles of one thread still to be swept in the current
+//phase, alone on its cache line. The owner takes tiles from the front and
+//idle threads steal them from the back
+struct tileQueue
+{
+    _Alignas(TILE_LINE) atomic_ullong range; // Front in the high 32 bits,
+                                             // back in the low 32 bits
+};
+
+//Struct holding every tile of a grid and the threads they belong to
+struct tileSchedule
+{
+    int threads;
+    int count; // Tiles in the grid
+    struct tile *tiles; // Each thread's tiles in turn, top to bottom
+    int *owned; // First tile of each thread, threads+1 entries
+    struct tileQueue *queues; // One per thread
+};
+
+//Struct counting one thread's share of the work of a solve
+struct tileStats
+{
+    long tiles; // Tiles swept
+    long stolen; // Of which taken from another thread's queue
+    double busy; // Seconds sweeping
+    double waiting; // Seconds at barriers and convergence checks
+};
+
+struct tileSchedule *createTileSchedule(const int *borders, int threads,
+        int cols);
+void resetTiles(struct tileSchedule *schedule, int thread);
+int nextTile(struct tileSchedule *schedule, int thread);
+double jacobiTile(const struct grid *src, struct grid *dst,
+        const struct tile *t);
+double colourTile(struct grid *matrix, const struct tile *t, int colour,
+        double omega);
+void freeTileSchedule(struct tileSchedule *schedule);
+
+#endif
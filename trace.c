@@ -0,0 +1,224 @@
+// Timeline of where each thread's time goes, for chrome://tracing or
+// Perfetto
+// Candidate Number: 11066
+//
+// Each thread appends to its own buffer, so recording takes no lock. The
+// buffers are written out as Chrome trace events: a complete event ("X")
+// for each span, a counter event ("C") for each value, and for each thread
+// a final instant event ("i") holding its total time and count per span
+// name, which shows load imbalance between threads at a glance.
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "trace.h"
+
+// Different span names totalled for each thread
+#define TRACE_NAMES 16
+
+//Struct holding one recorded event
+struct traceEvent
+{
+    const char *name; // String literal, never freed
+    char phase; // 'X' for a span, 'C' for a counter
+    double ts; // Microseconds since traceStart
+    double value; // Duration of a span, or the counter's value
+};
+
+//Struct holding one thread's events and totals
+struct traceBuffer
+{
+    int pid;
+    int tid;
+    struct traceEvent *events;
+    int count;
+    int size;
+    const char *names[TRACE_NAMES]; // Span names seen, for the totals
+    double totals[TRACE_NAMES]; // Microseconds spent in each
+    int spans[TRACE_NAMES]; // Spans recorded of each
+    double last; // End of the latest event
+    struct traceBuffer *next; // Next buffer of this process
+};
+
+static struct timespec origin; // Time of traceStart
+static struct traceBuffer *buffers = NULL; // Every thread's buffer
+static pthread_mutex_t buffersLock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local struct traceBuffer *mine = NULL; // Calling thread's
+
+
+//traceNow
+//OUT: Microseconds since traceStart
+double traceNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - origin.tv_sec) * 1e6
+            + (now.tv_nsec - origin.tv_nsec) * 1e-3;
+}
+
+
+//traceStart
+//PROC: Sets time zero of the timeline. MPI processes call it together,
+//      straight after a barrier, so their timelines line up
+void traceStart(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &origin);
+}
+
+
+//traceThread
+//INPUT: Process (pid) and thread (tid) to show the calling thread as
+//PROC:  Gives the calling thread a buffer, reusing the one it already has
+//       if it is still shown as the same thread
+void traceThread(int pid, int tid)
+{
+    if(mine != NULL && mine->pid == pid && mine->tid == tid)
+        return;
+    mine = calloc(1, sizeof(struct traceBuffer));
+    if(mine == NULL)
+        return;
+    mine->pid = pid;
+    mine->tid = tid;
+    pthread_mutex_lock(&buffersLock);
+    mine->next = buffers;
+    buffers = mine;
+    pthread_mutex_unlock(&buffersLock);
+}
+
+
+//addEvent
+//INPUT: Event to record for the calling thread (name, phase, ts, value)
+//PROC:  Appends the event, growing the buffer as needed. Threads without
+//       a buffer record nothing
+static void addEvent(const char *name, char phase, double ts, double value)
+{
+    if(mine == NULL)
+        return;
+    if(mine->count == mine->size)
+    {
+        int size = (mine->size > 0) ? 2*mine->size : 1024;
+        struct traceEvent *events = realloc(mine->events,
+                size * sizeof(struct traceEvent));
+        if(events == NULL)
+            return;
+        mine->events = events;
+        mine->size = size;
+    }
+    mine->events[mine->count].name = name;
+    mine->events[mine->count].phase = phase;
+    mine->events[mine->count].ts = ts;
+    mine->events[mine->count].value = value;
+    mine->count++;
+    if(ts + ((phase == 'X') ? value : 0) > mine->last)
+        mine->last = ts + ((phase == 'X') ? value : 0);
+}
+
+
+//traceSpan
+//INPUT: What the time was spent on (name, a string literal), when it
+//       started (start, from traceNow)
+//PROC:  Records the span up to now and adds it to the thread's totals
+void traceSpan(const char *name, double start)
+{
+    double end = traceNow();
+    int i = 0;
+    if(mine == NULL)
+        return;
+    addEvent(name, 'X', start, end - start);
+    for(i = 0; i < TRACE_NAMES; i++)
+    {
+        if(mine->names[i] == NULL)
+            mine->names[i] = name;
+        if(mine->names[i] == name || strcmp(mine->names[i], name) == 0)
+        {
+            mine->totals[i] += end - start;
+            mine->spans[i]++;
+            return;
+        }
+    }
+}
+
+
+//traceCounter
+//INPUT: Series (name, a string literal) and its new value (value)
+void traceCounter(const char *name, double value)
+{
+    addEvent(name, 'C', traceNow(), value);
+}
+
+
+//traceLock
+//INPUT: Mutex to lock (mutex)
+//PROC:  Locks the mutex. If another thread holds it, the wait is recorded
+//       as a "mutex wait" span, so the contended locks are counted too
+void traceLock(pthread_mutex_t *mutex)
+{
+    if(pthread_mutex_trylock(mutex) == 0)
+        return;
+    double start = traceNow();
+    pthread_mutex_lock(mutex);
+    traceSpan("mutex wait", start);
+}
+
+
+//traceWrite
+//INPUT: File to write (fileName), whether this is the first process to
+//       write to it (first) and the last (last)
+//PROC:  Writes every buffer of this process as Chrome trace events. The
+//       first process starts the file and the last one closes the event
+//       list, so MPI processes can write one file in turn
+//OUT:   0 on success (-1 if the file could not be written)
+int traceWrite(const char *fileName, int first, int last)
+{
+    struct traceBuffer *b = NULL;
+    int i = 0;
+    FILE *file = fopen(fileName, first ? "w" : "a");
+    if(file == NULL)
+    {
+        printf("Unable to open trace file %s\n", fileName);
+        return -1;
+    }
+    if(first)
+        fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+                "{\"name\": \"start\", \"ph\": \"i\", \"s\": \"g\", "
+                "\"ts\": 0, \"pid\": 0, \"tid\": 0}");
+    pthread_mutex_lock(&buffersLock);
+    for(b = buffers; b != NULL; b = b->next)
+    {
+        fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", "
+                "\"pid\": %d, \"tid\": %d, \"args\": {\"name\": "
+                "\"thread %d\"}}", b->pid, b->tid, b->tid);
+        for(i = 0; i < b->count; i++)
+        {
+            struct traceEvent *e = &b->events[i];
+            if(e->phase == 'X')
+                fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", "
+                        "\"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, "
+                        "\"tid\": %d}", e->name, e->ts, e->value, b->pid,
+                        b->tid);
+            else
+                fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"C\", "
+                        "\"ts\": %.3f, \"pid\": %d, \"args\": {\"value\": "
+                        "%.17g}}", e->name, e->ts, b->pid, e->value);
+        }
+        fprintf(file, ",\n{\"name\": \"totals\", \"ph\": \"i\", \"s\": "
+                "\"t\", \"ts\": %.3f, \"pid\": %d, \"tid\": %d, "
+                "\"args\": {", b->last, b->pid, b->tid);
+        for(i = 0; i < TRACE_NAMES && b->names[i] != NULL; i++)
+            fprintf(file, "%s\"%s us\": %.3f, \"%s count\": %d",
+                    (i > 0) ? ", " : "", b->names[i], b->totals[i],
+                    b->names[i], b->spans[i]);
+        fprintf(file, "}}");
+    }
+    pthread_mutex_unlock(&buffersLock);
+    if(last)
+        fprintf(file, "\n]}\n");
+    if(fclose(file) != 0)
+    {
+        printf("Unable to write trace file %s\n", fileName);
+        return -1;
+    }
+    return 0;
+}
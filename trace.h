@@ -0,0 +1,43 @@
+// Timeline of where each thread's time goes, for chrome://tracing or
+// Perfetto
+// Candidate Number: 11066
+//
+// Built with -DRELAX_TRACE the solvers record a span for each sweep, wait
+// and message on every thread, plus the convergence history; otherwise
+// every macro below compiles to nothing.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <pthread.h>
+
+double traceNow(void);
+void traceStart(void);
+void traceThread(int pid, int tid);
+void traceSpan(const char *name, double start);
+void traceCounter(const char *name, double value);
+void traceLock(pthread_mutex_t *mutex);
+int traceWrite(const char *fileName, int first, int last);
+
+#ifdef RELAX_TRACE
+#define TRACE_ENABLED 1
+// Microseconds since traceStart, to pass to TRACE_SPAN
+#define TRACE_NOW() traceNow()
+// Names the calling thread (tid) of process pid in the timeline
+#define TRACE_THREAD(pid, tid) traceThread(pid, tid)
+// Records the calling thread spending TRACE_NOW() - start on name
+#define TRACE_SPAN(name, start) traceSpan(name, start)
+// Records a new value of a process wide series
+#define TRACE_COUNTER(name, value) traceCounter(name, value)
+// pthread_mutex_lock, recording any time spent waiting for the mutex
+#define TRACE_LOCK(mutex) traceLock(mutex)
+#else
+#define TRACE_ENABLED 0
+#define TRACE_NOW() 0.0
+#define TRACE_THREAD(pid, tid) ((void)0)
+#define TRACE_SPAN(name, start) ((void)(start))
+#define TRACE_COUNTER(name, value) ((void)0)
+#define TRACE_LOCK(mutex) pthread_mutex_lock(mutex)
+#endif
+
+#endif
@@ -0,0 +1,147 @@
+// Temporally blocked Jacobi sweeps over cache sized tiles
+// Candidate Number: 11066
+//
+// A plain Jacobi sweep streams the whole band through memory once. Here a
+// band is cut into column tiles and each tile is taken several sweeps
+// forward before the next one is touched. Within a tile the sweeps advance
+// as a wavefront down the rows: sweep t of row r is worked out as soon as
+// sweep t-1 of row r+1 exists, so each sweep only keeps its last three
+// rows. Every tile and band is widened by one row or column per sweep
+// (its skirt), so the rows and columns it writes never need values from
+// another thread or tile part way through the block. The skirt is worked
+// out again by the neighbouring band or tile; this repeated work is the
+// price of needing no synchronisation inside a block.
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sweep.h"
+#include "wavefront.h"
+
+
+//createWavefront
+//INPUT: Sweeps to apply to each tile (depth), columns in the grid (cols)
+//PROC:  Sizes the tiles so the intermediate rows of one tile, together
+//       with the rows being read and written, fit in WAVEFRONT_CACHE_BYTES
+//OUT:   Pointer to the wavefront state (NULL if allocation failed)
+struct wavefront *createWavefront(int depth, int cols)
+{
+    struct wavefront *w = malloc(sizeof(struct wavefront));
+    int perLine = GRID_ALIGN / sizeof(double);
+    if(w == NULL)
+        return NULL;
+
+    w->depth = depth;
+    w->tileCols = WAVEFRONT_CACHE_BYTES / ((3*depth + 1) * sizeof(double))
+            - 2*depth;
+    //Keep the skirt from outweighing the tile itself
+    if(w->tileCols < 2*depth)
+        w->tileCols = 2*depth;
+    if(w->tileCols > cols-2)
+        w->tileCols = cols-2;
+    w->pitch = ((w->tileCols + 2*depth + perLine - 1) / perLine) * perLine;
+    w->rows = NULL;
+    //A single sweep writes straight into the destination grid
+    if(depth > 1 && posix_memalign((void **)&w->rows, GRID_ALIGN,
+            (size_t)3*(depth-1) * w->pitch * sizeof(double)) != 0)
+    {
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+
+//levelRow
+//INPUT: Wavefront state (w), grid at the start of the block (src), sweep
+//       (t, 0 for src), row (r), first column held by the tile (lo)
+//OUT:   Row r after t sweeps, from column lo. Boundary rows never change,
+//       so they and sweep 0 are read straight from src
+static const double *levelRow(const struct wavefront *w,
+        const struct grid *src, int t, int r, int lo)
+{
+    if(t == 0 || r == 0 || r == src->rows-1)
+        return GRID_ROW(src, r) + lo;
+    return w->rows + ((t-1)*3 + r%3) * w->pitch;
+}
+
+
+//wavefrontSweeps
+//INPUT: Wavefront state (w), grid to read (src), grid to write (dst),
+//       rows of dst to write (startRow up to but not including endRow),
+//       sweeps to apply (sweeps, 1 up to w->depth)
+//PROC:  Applies the sweeps to src, tile by tile, reading src rows up to
+//       sweeps beyond the band and writing only the band of dst
+//OUT:   Largest absolute change made to a cell of the band by the last
+//       of the sweeps
+double wavefrontSweeps(struct wavefront *w, const struct grid *src,
+        struct grid *dst, int startRow, int endRow, int sweeps)
+{
+    //Fewer sweeps need fewer intermediate rows and a narrower skirt
+    int depth = sweeps;
+    int rows = src->rows;
+    int cols = src->cols;
+    double maxDelta = 0;
+    int c0 = 0;
+    int i = 0;
+    int t = 0;
+
+    for(c0 = 1; c0 < cols-1; c0 += w->tileCols)
+    {
+        int c1 = (c0 + w->tileCols < cols-1) ? c0 + w->tileCols : cols-1;
+        int lo = (c0 - depth > 0) ? c0 - depth : 0;
+
+        //Sweep t of row r is worked out at step i = r + t
+        for(i = startRow - depth + 2; i < endRow + depth; i++)
+        {
+            for(t = 1; t <= depth; t++)
+            {
+                int r = i - t;
+                int first = (startRow - depth + t > 1)
+                        ? startRow - depth + t : 1;
+                int last = (endRow + depth - t < rows-1)
+                        ? endRow + depth - t : rows-1;
+                if(r < first || r >= last)
+                    continue;
+
+                //Sweep t is only needed as far out as the remaining sweeps
+                //reach, so each sweep works on a narrower span
+                int from = (c0 - (depth-t) - 1 > 0) ? c0 - (depth-t) - 1 : 0;
+                int to = (c1 + (depth-t) + 1 < cols) ? c1 + (depth-t) + 1
+                        : cols;
+                const double *up = levelRow(w, src, t-1, r-1, lo) + from-lo;
+                const double *mid = levelRow(w, src, t-1, r, lo) + from-lo;
+                const double *down = levelRow(w, src, t-1, r+1, lo) + from-lo;
+                if(t == depth)
+                {
+                    //Writes exactly the tile's columns of the band
+                    double rowDelta = jacobiRow(up, mid, down,
+                            GRID_ROW(dst, r) + from, to - from);
+                    if(rowDelta > maxDelta)
+                        maxDelta = rowDelta;
+                    continue;
+                }
+
+                double *out = (double *)levelRow(w, src, t, r, lo) + from-lo;
+                jacobiRow(up, mid, down, out, to - from);
+                //Boundary columns never change
+                if(from == 0)
+                    out[0] = GRID_AT(src, r, 0);
+                if(to == cols)
+                    out[to-from-1] = GRID_AT(src, r, cols-1);
+            }
+        }
+    }
+    return maxDelta;
+}
+
+
+//freeWavefront
+//INPUT: Wavefront state to free (w), may be NULL
+void freeWavefront(struct wavefront *w)
+{
+    if(w == NULL)
+        return;
+    free(w->rows);
+    free(w);
+}
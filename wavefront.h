@@ -0,0 +1,26 @@
+// Temporally blocked Jacobi sweeps over cache sized tiles
+// Candidate Number: 11066
+
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+#include "grid.h"
+
+// Bytes of intermediate rows each thread aims to keep in its own cache
+#define WAVEFRONT_CACHE_BYTES (256 * 1024)
+
+//Struct holding one thread's intermediate rows for blocked sweeps
+struct wavefront
+{
+    int depth; // Sweeps applied to a tile before moving on
+    int tileCols; // Columns written per tile, skirt excluded
+    int pitch; // Doubles between intermediate rows
+    double *rows; // Last 3 rows of each sweep but the final one
+};
+
+struct wavefront *createWavefront(int depth, int cols);
+double wavefrontSweeps(struct wavefront *w, const struct grid *src,
+        struct grid *dst, int startRow, int endRow, int sweeps);
+void freeWavefront(struct wavefront *w);
+
+#endif